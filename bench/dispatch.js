@@ -0,0 +1,117 @@
+'use strict'
+
+// Measures the cost of the binding layer (JS validation plus native glue) by
+// running the same draw loop on ANGLE's null backend, which dispatches every
+// call but rasterizes nothing, and on a real backend.
+//
+//   node bench/dispatch.js [--frames=N] [--draws=N] [--size=N] [--backend=name]
+
+const createContext = require('../index')
+const { measure, report, intArg, formatNs } = require('./util')
+
+const FRAMES = intArg('frames', 500)
+const DRAWS = intArg('draws', 100)
+const SIZE = intArg('size', 256)
+
+function backendArg () {
+  const arg = process.argv.find(a => a.startsWith('--backend='))
+  return arg ? arg.slice('--backend='.length) : createContext.getDefaultBackend()
+}
+
+const VERT_SRC = `
+attribute vec2 position;
+uniform vec2 offset;
+void main() {
+  gl_Position = vec4(position + offset, 0, 1);
+}`
+
+const FRAG_SRC = `
+precision mediump float;
+uniform vec4 color;
+void main() {
+  gl_FragColor = color;
+}`
+
+function compile (gl, type, src) {
+  const shader = gl.createShader(type)
+  gl.shaderSource(shader, src)
+  gl.compileShader(shader)
+  if (!gl.getShaderParameter(shader, gl.COMPILE_STATUS)) {
+    throw new Error(gl.getShaderInfoLog(shader))
+  }
+  return shader
+}
+
+function setup (options) {
+  const gl = createContext(SIZE, SIZE, options)
+  if (!gl) {
+    return null
+  }
+
+  const program = gl.createProgram()
+  gl.attachShader(program, compile(gl, gl.VERTEX_SHADER, VERT_SRC))
+  gl.attachShader(program, compile(gl, gl.FRAGMENT_SHADER, FRAG_SRC))
+  gl.bindAttribLocation(program, 0, 'position')
+  gl.linkProgram(program)
+  if (!gl.getProgramParameter(program, gl.LINK_STATUS)) {
+    throw new Error(gl.getProgramInfoLog(program))
+  }
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-0.1, -0.1, 0.1, -0.1, 0, 0.1]), gl.STATIC_DRAW)
+
+  return {
+    gl,
+    program,
+    buffer,
+    offset: gl.getUniformLocation(program, 'offset'),
+    color: gl.getUniformLocation(program, 'color')
+  }
+}
+
+function frame (state) {
+  const { gl, program, buffer, offset, color } = state
+  gl.clearColor(0, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.useProgram(program)
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.enableVertexAttribArray(0)
+  gl.vertexAttribPointer(0, 2, gl.FLOAT, false, 0, 0)
+  for (let i = 0; i < DRAWS; ++i) {
+    gl.uniform2f(offset, (i % 10) / 5 - 1, Math.floor(i / 10) / 5 - 1)
+    gl.uniform4f(color, i / DRAWS, 0, 1, 1)
+    gl.drawArrays(gl.TRIANGLES, 0, 3)
+  }
+  // Force the work to complete so the real backend is measured end to end
+  gl.finish()
+}
+
+function run (label, options) {
+  let state
+  try {
+    state = setup(options)
+  } catch (e) {
+    console.log(`${label}: unavailable (${e.message})`)
+    return null
+  }
+  if (!state) {
+    console.log(`${label}: unavailable`)
+    return null
+  }
+  const ns = measure(() => frame(state), FRAMES, 20)
+  // Each draw issues 3 calls, plus 7 calls of per-frame setup
+  const calls = DRAWS * 3 + 7
+  report(`${label} frame`, ns, `${formatNs(ns / calls)}/call`)
+  state.gl.getExtension('STACKGL_destroy_context').destroy()
+  return ns
+}
+
+console.log(`${FRAMES} frames, ${DRAWS} draws per frame, ${SIZE}x${SIZE}`)
+const dispatch = run('null (dispatch only)', { dispatchOnly: true })
+const backend = backendArg()
+const full = run(backend, { backend })
+if (dispatch !== null && full !== null) {
+  const share = (dispatch / full) * 100
+  console.log(`binding layer share of frame time: ${share.toFixed(1)}%`)
+}
@@ -0,0 +1,70 @@
+'use strict'
+
+// Time per linkProgram call for programs that were never linked before, so
+// ANGLE's in-memory program cache cannot help. `--relink=1` adds the second
+// driver link linkProgram used to issue after rebinding attribute locations,
+// which gives the cost of the old path for comparison.
+//
+//   node bench/link.js [--programs=N] [--attributes=N] [--relink=1] [--backend=name]
+
+const createContext = require('../index')
+const { now, report, intArg } = require('./util')
+
+const PROGRAMS = intArg('programs', 200)
+const ATTRIBUTES = intArg('attributes', 8)
+const RELINK = intArg('relink', 0) !== 0
+
+function backendArg () {
+  const arg = process.argv.find(a => a.startsWith('--backend='))
+  return arg ? { backend: arg.slice('--backend='.length) } : {}
+}
+
+const gl = createContext(16, 16, backendArg())
+
+function compile (type, src) {
+  const shader = gl.createShader(type)
+  gl.shaderSource(shader, src)
+  gl.compileShader(shader)
+  return shader
+}
+
+function vertexSource (seed) {
+  const lines = []
+  let sum = 'vec4(0)'
+  for (let i = 0; i < ATTRIBUTES; ++i) {
+    lines.push(`attribute vec4 a${i};`)
+    sum += ` + a${i}`
+  }
+  lines.push('void main() {')
+  lines.push(`  gl_Position = (${sum}) * ${seed.toFixed(1)};`)
+  lines.push('}')
+  return lines.join('\n')
+}
+
+const fragShader = compile(gl.FRAGMENT_SHADER, `
+precision mediump float;
+void main() {
+  gl_FragColor = vec4(1);
+}`)
+
+const programs = []
+for (let i = 0; i < PROGRAMS; ++i) {
+  const program = gl.createProgram()
+  gl.attachShader(program, compile(gl.VERTEX_SHADER, vertexSource(i + 1)))
+  gl.attachShader(program, fragShader)
+  programs.push(program)
+}
+
+let elapsed = 0n
+for (const program of programs) {
+  const start = now()
+  gl.linkProgram(program)
+  if (RELINK) {
+    gl.linkProgram(program)
+  }
+  gl.getProgramParameter(program, gl.LINK_STATUS)
+  elapsed += now() - start
+}
+
+report(RELINK ? 'linkProgram + relink' : 'linkProgram', Number(elapsed) / PROGRAMS,
+  `${ATTRIBUTES} attributes`)
@@ -0,0 +1,45 @@
+'use strict'
+
+// Measures context creation time. The first context pays for loading libEGL,
+// initializing the display and resolving the GLES entry points; later
+// contexts should only pay for the EGL context and surface plus JS setup.
+//
+//   node bench/startup.js [--contexts=N] [--burst=N] [--webgl2=1]
+
+const createContext = require('../index')
+const { now, report, intArg } = require('./util')
+
+const CONTEXTS = intArg('contexts', 200)
+const BURST = intArg('burst', 16)
+const options = { createWebGL2Context: intArg('webgl2', 0) !== 0 }
+
+function destroy (gl) {
+  gl.getExtension('STACKGL_destroy_context').destroy()
+}
+
+let start = now()
+const first = createContext(1, 1, options)
+report('first context', Number(now() - start))
+destroy(first)
+
+// Create and destroy one context at a time
+start = now()
+for (let i = 0; i < CONTEXTS; ++i) {
+  destroy(createContext(64, 64, options))
+}
+report('create + destroy', Number(now() - start) / CONTEXTS)
+
+// Create bursts of live contexts, then tear them all down
+const live = new Array(BURST)
+let created = 0
+start = now()
+while (created < CONTEXTS) {
+  for (let i = 0; i < BURST; ++i) {
+    live[i] = createContext(64, 64, options)
+  }
+  for (let i = 0; i < BURST; ++i) {
+    destroy(live[i])
+  }
+  created += BURST
+}
+report(`bursts of ${BURST}`, Number(now() - start) / created)
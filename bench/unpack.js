@@ -0,0 +1,74 @@
+'use strict'
+
+// Throughput of texSubImage2D uploads with UNPACK_FLIP_Y_WEBGL and
+// UNPACK_PREMULTIPLY_ALPHA_WEBGL, in MB of source pixels per second, for each
+// format/type pair that has an unpack conversion. The null backend is the
+// default so the conversion dominates; `--backend=name` includes the upload.
+//
+//   node bench/unpack.js [--width=N] [--height=N] [--iterations=N] [--backend=name]
+
+const createContext = require('../index')
+const { measure, report, intArg } = require('./util')
+
+const WIDTH = intArg('width', 3840)
+const HEIGHT = intArg('height', 2160)
+const ITERATIONS = intArg('iterations', 20)
+
+function backendArg () {
+  const arg = process.argv.find(a => a.startsWith('--backend='))
+  return arg ? arg.slice('--backend='.length) : 'null'
+}
+
+const gl = createContext(1, 1, { backend: backendArg() })
+const halfFloat = gl.getExtension('OES_texture_half_float')
+gl.getExtension('OES_texture_float')
+
+const FORMATS = [
+  ['RGBA/UNSIGNED_BYTE', gl.RGBA, gl.UNSIGNED_BYTE, 4, Uint8Array],
+  ['LUMINANCE_ALPHA/UNSIGNED_BYTE', gl.LUMINANCE_ALPHA, gl.UNSIGNED_BYTE, 2, Uint8Array],
+  ['RGBA/UNSIGNED_SHORT_4_4_4_4', gl.RGBA, gl.UNSIGNED_SHORT_4_4_4_4, 2, Uint16Array],
+  ['RGBA/UNSIGNED_SHORT_5_5_5_1', gl.RGBA, gl.UNSIGNED_SHORT_5_5_5_1, 2, Uint16Array],
+  ['RGBA/HALF_FLOAT_OES', gl.RGBA, halfFloat && halfFloat.HALF_FLOAT_OES, 8, Uint16Array],
+  ['RGBA/FLOAT', gl.RGBA, gl.FLOAT, 16, Float32Array]
+]
+
+const MODES = [
+  ['flip', true, false],
+  ['premultiply', false, true],
+  ['flip+premultiply', true, true]
+]
+
+const texture = gl.createTexture()
+gl.bindTexture(gl.TEXTURE_2D, texture)
+
+for (const [name, format, type, pixelSize, ArrayType] of FORMATS) {
+  if (!type) {
+    console.log(`${name}: unavailable`)
+    continue
+  }
+  const bytes = WIDTH * HEIGHT * pixelSize
+  const pixels = new ArrayType(bytes / ArrayType.BYTES_PER_ELEMENT)
+  for (let i = 0; i < pixels.length; ++i) {
+    pixels[i] = ArrayType === Float32Array ? Math.random() : (i * 2654435761) >>> 24
+  }
+
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, false)
+  gl.pixelStorei(gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, false)
+  gl.texImage2D(gl.TEXTURE_2D, 0, format, WIDTH, HEIGHT, 0, format, type, null)
+  if (gl.getError() !== gl.NO_ERROR) {
+    console.log(`${name}: unavailable`)
+    continue
+  }
+
+  for (const [mode, flipY, premultiply] of MODES) {
+    gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, flipY)
+    gl.pixelStorei(gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, premultiply)
+    const ns = measure(() => {
+      gl.texSubImage2D(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, format, type, pixels)
+    }, ITERATIONS, 2)
+    const mbPerSecond = bytes / 1e6 / (ns / 1e9)
+    report(`${name} ${mode}`, ns, `${mbPerSecond.toFixed(0)} MB/s`)
+  }
+}
+
+gl.getExtension('STACKGL_destroy_context').destroy()
@@ -0,0 +1,52 @@
+'use strict'
+
+// Minimal timing helpers shared by the benchmark scripts.
+
+function now () {
+  return process.hrtime.bigint()
+}
+
+// Runs fn(i) `iterations` times after `warmup` untimed runs and returns the
+// mean time per iteration in nanoseconds.
+function measure (fn, iterations, warmup) {
+  warmup = warmup === undefined ? Math.min(iterations, 100) : warmup
+  for (let i = 0; i < warmup; ++i) {
+    fn(i)
+  }
+  const start = now()
+  for (let i = 0; i < iterations; ++i) {
+    fn(i)
+  }
+  return Number(now() - start) / iterations
+}
+
+function formatNs (ns) {
+  if (ns >= 1e6) {
+    return (ns / 1e6).toFixed(2) + ' ms'
+  }
+  if (ns >= 1e3) {
+    return (ns / 1e3).toFixed(2) + ' us'
+  }
+  return ns.toFixed(1) + ' ns'
+}
+
+function report (name, ns, extra) {
+  const opsPerSecond = 1e9 / ns
+  let line = `${name.padEnd(40)} ${formatNs(ns).padStart(12)}/op ${opsPerSecond.toFixed(0).padStart(12)} op/s`
+  if (extra) {
+    line += '  ' + extra
+  }
+  console.log(line)
+}
+
+function intArg (name, dflt) {
+  const prefix = `--${name}=`
+  for (const arg of process.argv.slice(2)) {
+    if (arg.startsWith(prefix)) {
+      return parseInt(arg.slice(prefix.length), 10)
+    }
+  }
+  return dflt
+}
+
+module.exports = { now, measure, formatNs, report, intArg }
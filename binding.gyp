@@ -17,6 +17,9 @@
           'src/native/bindings.cc',
           'src/native/webgl.cc',
           'src/native/SharedLibrary.cc',
+          'src/native/ProgramCache.cc',
+          'src/native/PixelKernels.cc',
+          'src/native/PngEncoder.cc',
           'src/native/angle-loader/egl_loader.cc',
           'src/native/angle-loader/gles_loader.cc'
       ],
@@ -7,11 +7,131 @@ declare namespace createContext {
       resize(width: GLint, height: GLint): void;
   }
 
+  interface STACKGL_state_cache {
+      stats(): { hits: number; misses: number };
+  }
+
+  interface ScratchMemoryStats {
+      capacity: number;
+      limit: number;
+      highWater: number;
+      reuses: number;
+      grows: number;
+      oversized: number;
+  }
+
+  interface STACKGL_scratch_memory {
+      stats(): ScratchMemoryStats;
+      setLimit(maxBytes: number): void;
+  }
+
+  interface KHR_parallel_shader_compile {
+      readonly COMPLETION_STATUS_KHR: GLenum;
+      maxShaderCompilerThreadsKHR(count: GLuint): void;
+  }
+
+  interface ReadbackOptions {
+      packFlipY?: boolean;
+      outputFormat?: "rgba" | "rgb" | "bgra" | "gray";
+      unpremultiply?: boolean;
+  }
+
+  interface EncodeFrameOptions {
+      format?: "png";
+      quality?: number;
+      compressionLevel?: number;
+      rect?: { x: GLint; y: GLint; width: GLsizei; height: GLsizei };
+  }
+
   interface StackGLExtension {
+      encodeFrame(options?: EncodeFrameOptions): Promise<Buffer>;
+      readPixels(x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, type: GLenum, pixels: ArrayBufferView | null, options: ReadbackOptions): void;
+      compileShaderAsync(shader: WebGLShader): Promise<boolean>;
+      linkProgramAsync(program: WebGLProgram): Promise<boolean>;
+      texSubImage2DAsync(target: GLenum, level: GLint, xoffset: GLint, yoffset: GLint, width: GLsizei, height: GLsizei, format: GLenum, type: GLenum, pixels: ArrayBufferView | null): Promise<void>;
+      readPixelsAsync(x: GLint, y: GLint, width: GLsizei, height: GLsizei, format: GLenum, type: GLenum, pixels?: ArrayBufferView | null, options?: ReadbackOptions): Promise<ArrayBufferView>;
+      getExtension(extensionName: "KHR_parallel_shader_compile"): KHR_parallel_shader_compile | null;
       getExtension(extensionName: "STACKGL_destroy_context"): STACKGL_destroy_context | null;
       getExtension(extensionName: "STACKGL_resize_drawingbuffer"): STACKGL_resize_drawingbuffer | null;
+      getExtension(extensionName: "STACKGL_state_cache"): STACKGL_state_cache | null;
+      getExtension(extensionName: "STACKGL_scratch_memory"): STACKGL_scratch_memory | null;
+  }
+
+  type Backend = "default" | "swiftshader" | "vulkan" | "gl" | "gles" | "d3d11" | "metal" | "null";
+
+  interface HeadlessContextAttributes extends WebGLContextAttributes {
+      backend?: Backend;
+      dispatchOnly?: boolean;
+      commandBuffer?: boolean | number;
+      scratchLimit?: number;
+      samples?: number;
+      reuseDrawingBuffer?: boolean;
+  }
+
+  function setDefaultBackend(backend: Backend): void;
+  function getDefaultBackend(): Backend;
+
+  interface ProgramCacheOptions {
+      directory: string;
+      maxBytes?: number;
+  }
+
+  interface ProgramCacheStats {
+      enabled: boolean;
+      hits: number;
+      misses: number;
+      stores: number;
+      evictions: number;
+      entries: number;
+      bytes: number;
+  }
+
+  function setProgramCache(options: ProgramCacheOptions | string): void;
+  function getProgramCacheStats(): ProgramCacheStats;
+  function flushProgramCache(): void;
+
+  interface SharedProgramStats {
+      hits: number;
+      misses: number;
+      entries: number;
+      bytes: number;
+  }
+
+  function setSharedProgramCacheSize(maxBytes: number): void;
+  function getSharedProgramStats(): SharedProgramStats;
+
+  interface ContextPoolOptions {
+      maxIdle?: number;
+  }
+
+  interface ContextPoolStats {
+      idle: number;
+      active: number;
+      created: number;
+      reused: number;
+      released: number;
+      destroyed: number;
   }
 
+  interface ContextPool {
+      prewarm(count: number, options?: HeadlessContextAttributes & { createWebGL2Context?: boolean }): number;
+      acquire(
+          width: number,
+          height: number,
+          options?: HeadlessContextAttributes & { createWebGL2Context?: false },
+      ): (WebGLRenderingContext & StackGLExtension) | null;
+      acquire(
+          width: number,
+          height: number,
+          options: HeadlessContextAttributes & { createWebGL2Context: true },
+      ): (WebGL2RenderingContext & StackGLExtension) | null;
+      release(gl: WebGLRenderingContext | WebGL2RenderingContext): boolean;
+      stats(): ContextPoolStats;
+      destroy(): void;
+  }
+
+  function createContextPool(options?: ContextPoolOptions): ContextPool;
+
   const WebGLRenderingContext: WebGLRenderingContext & StackGLExtension & {
       new(): WebGLRenderingContext & StackGLExtension;
       prototype: WebGLRenderingContext & StackGLExtension;
@@ -26,19 +146,19 @@ declare namespace createContext {
 declare function createContext(
   width: number,
   height: number,
-  options?: WebGLContextAttributes & { createWebGL2Context?: false },
+  options?: createContext.HeadlessContextAttributes & { createWebGL2Context?: false },
 ): WebGLRenderingContext & createContext.StackGLExtension;
 
 declare function createContext(
   width: number,
   height: number,
-  options: WebGLContextAttributes & { createWebGL2Context: true }
+  options: createContext.HeadlessContextAttributes & { createWebGL2Context: true }
 ): WebGL2RenderingContext & createContext.StackGLExtension;
 
 declare function createContext(
   width: number,
   height: number,
-  options?: WebGLContextAttributes & { createWebGL2Context?: boolean }
+  options?: createContext.HeadlessContextAttributes & { createWebGL2Context?: boolean }
 ): (WebGLRenderingContext | WebGL2RenderingContext) & createContext.StackGLExtension;
 
 export = createContext;
@@ -0,0 +1,106 @@
+const { NativeWebGL, NativeWebGLRenderingContext } = require('./native-gl')
+
+// Default size of a context's command buffer in bytes
+const DEFAULT_COMMAND_BUFFER_SIZE = 64 * 1024
+
+// Longest command (opcode plus arguments) in 32-bit words
+const MAX_COMMAND_WORDS = 7
+
+const ARG_INT = 0
+const ARG_UINT = 1
+const ARG_BOOL = 2
+const ARG_FLOAT = 3
+
+const ARG_TYPES = { i: ARG_INT, u: ARG_UINT, b: ARG_BOOL, f: ARG_FLOAT }
+
+// Records side-effect only native calls. The native side shares the buffer and
+// runs the pending commands before any other method of the context, see
+// GL_BOILERPLATE in webgl.cc, so calls always execute in the order they were made.
+// Word 0 holds the number of recorded words that follow it.
+class CommandBuffer {
+  constructor (ctx, byteLength) {
+    const words = Math.max(MAX_COMMAND_WORDS + 1, (byteLength | 0) >> 2)
+    this._ctx = ctx
+    this._words = new Int32Array(words)
+    this._floats = new Float32Array(this._words.buffer)
+    NativeWebGLRenderingContext.prototype._setCommandBuffer.call(ctx, this._words)
+  }
+
+  _reserve (count) {
+    if (1 + this._words[0] + count > this._words.length) {
+      this.flush()
+    }
+    const start = 1 + this._words[0]
+    this._words[0] += count
+    return start
+  }
+
+  flush () {
+    if (this._words[0] > 0) {
+      executeCommandBuffer.call(this._ctx)
+    }
+  }
+}
+
+let executeCommandBuffer = null
+
+function encode (cb, opcode, types, a, b, c, d, e, f) {
+  const argc = types.length
+  const start = cb._reserve(argc + 1)
+  const words = cb._words
+  words[start] = opcode
+  for (let i = 0; i < argc; ++i) {
+    const value = i === 0 ? a : i === 1 ? b : i === 2 ? c : i === 3 ? d : i === 4 ? e : f
+    switch (types[i]) {
+      case ARG_INT:
+        words[start + 1 + i] = value | 0
+        break
+      case ARG_UINT:
+        words[start + 1 + i] = value >>> 0
+        break
+      case ARG_BOOL:
+        words[start + 1 + i] = value ? 1 : 0
+        break
+      case ARG_FLOAT:
+        cb._floats[start + 1 + i] = +value
+        break
+    }
+  }
+}
+
+function recording (native, opcode, types) {
+  return function (a, b, c, d, e, f) {
+    const cb = this._commandBuffer
+    if (!cb) {
+      return native.call(this, a, b, c, d, e, f)
+    }
+    encode(cb, opcode, types, a, b, c, d, e, f)
+  }
+}
+
+// Routes the recordable native methods through the command buffer of the
+// context they are called on. Contexts without a command buffer call straight
+// through, and methods that are not recorded are never wrapped: the native side
+// runs pending commands before them. Only installed once the first context
+// enables batching.
+function install () {
+  if (executeCommandBuffer) {
+    return
+  }
+  const proto = NativeWebGLRenderingContext.prototype
+  const ops = NativeWebGL.commandBufferOps
+  executeCommandBuffer = proto._executeCommandBuffer
+
+  for (const name of Object.keys(ops)) {
+    const op = ops[name]
+    proto[name] = recording(proto[name], op.opcode, Array.from(op.args, type => ARG_TYPES[type]))
+  }
+}
+
+function enableCommandBuffer (ctx, byteLength) {
+  install()
+  ctx._commandBuffer = new CommandBuffer(ctx, byteLength || DEFAULT_COMMAND_BUFFER_SIZE)
+  return ctx._commandBuffer
+}
+
+module.exports = { CommandBuffer, enableCommandBuffer, DEFAULT_COMMAND_BUFFER_SIZE }
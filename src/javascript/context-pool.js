@@ -0,0 +1,131 @@
+// Pool of pre-created contexts grouped by their context attributes.
+//
+// Creating a context is expensive (EGL config selection, context and surface
+// creation, extension parsing), so released contexts are reset in place and
+// handed out again instead of being destroyed. The GL specific work is
+// injected through `hooks` so the pool itself stays platform agnostic:
+//
+//   key(options)              -> string identifying a compatible context
+//   create(options)           -> new context or null
+//   init(gl, width, height)   -> prepare a context for a new user
+//   reset(gl)                 -> restore default state, delete all objects,
+//                                false if the context cannot be reused
+//   destroy(gl)               -> tear the context down for good
+class ContextPool {
+  constructor (hooks) {
+    this._hooks = hooks
+    this._maxIdle = hooks.maxIdle > 0 ? hooks.maxIdle | 0 : Infinity
+    this._idle = new Map()
+    this._active = new Map()
+    this._stats = { created: 0, reused: 0, released: 0, destroyed: 0 }
+  }
+
+  prewarm (count, options) {
+    const key = this._hooks.key(options)
+    const idle = this._idleList(key)
+    let created = 0
+    while (idle.length < count) {
+      const gl = this._hooks.create(options)
+      if (!gl) {
+        break
+      }
+      this._stats.created++
+      idle.push(gl)
+      created++
+    }
+    return created
+  }
+
+  acquire (width, height, options) {
+    width = width | 0
+    height = height | 0
+    if (!(width > 0 && height > 0)) {
+      return null
+    }
+
+    const key = this._hooks.key(options)
+    const idle = this._idleList(key)
+    let gl = idle.pop()
+    if (gl) {
+      this._stats.reused++
+    } else {
+      gl = this._hooks.create(options)
+      if (!gl) {
+        return null
+      }
+      this._stats.created++
+    }
+
+    this._hooks.init(gl, width, height)
+    this._active.set(gl, key)
+    return gl
+  }
+
+  release (gl) {
+    const key = this._active.get(gl)
+    if (key === undefined) {
+      return false
+    }
+    this._active.delete(gl)
+    this._stats.released++
+
+    const idle = this._idleList(key)
+    if (idle.length >= this._maxIdle || this._hooks.reset(gl) === false) {
+      this._destroy(gl)
+      return true
+    }
+    idle.push(gl)
+    return true
+  }
+
+  destroy () {
+    for (const idle of this._idle.values()) {
+      for (const gl of idle) {
+        this._destroy(gl)
+      }
+    }
+    for (const gl of this._active.keys()) {
+      this._destroy(gl)
+    }
+    this._idle.clear()
+    this._active.clear()
+  }
+
+  stats () {
+    let idle = 0
+    for (const list of this._idle.values()) {
+      idle += list.length
+    }
+    return Object.assign({ idle, active: this._active.size }, this._stats)
+  }
+
+  _idleList (key) {
+    let idle = this._idle.get(key)
+    if (!idle) {
+      idle = []
+      this._idle.set(key, idle)
+    }
+    return idle
+  }
+
+  _destroy (gl) {
+    this._hooks.destroy(gl)
+    this._stats.destroyed++
+  }
+}
+
+function contextAttributesKey (contextAttributes) {
+  return [
+    contextAttributes.alpha,
+    contextAttributes.depth,
+    contextAttributes.stencil,
+    contextAttributes.antialias,
+    contextAttributes.premultipliedAlpha,
+    contextAttributes.preserveDrawingBuffer,
+    contextAttributes.preferLowPowerToHighPerformance,
+    contextAttributes.failIfMajorPerformanceCaveat,
+    contextAttributes.createWebGL2Context
+  ].map(Number).join('') + ':' + contextAttributes.backend
+}
+
+module.exports = { ContextPool, contextAttributesKey }
@@ -11,10 +11,12 @@ class ANGLEInstancedArrays {
   }
 
   drawArraysInstancedANGLE (mode, first, count, primCount) {
+    this.ctx._writeDrawingBuffer()
     this._drawArraysInstancedANGLE(mode, first, count, primCount)
   }
 
   drawElementsInstancedANGLE (mode, count, type, ioffset, primCount) {
+    this.ctx._writeDrawingBuffer()
     this._drawElementsInstancedANGLE(mode, count, type, ioffset, primCount)
   }
 
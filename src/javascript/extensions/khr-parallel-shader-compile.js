@@ -0,0 +1,21 @@
+class KHRParallelShaderCompile {
+  constructor (ctx) {
+    this.COMPLETION_STATUS_KHR = 0x91B1
+    this.maxShaderCompilerThreadsKHR = function (count) {
+      ctx._maxShaderCompilerThreads(count >>> 0)
+    }
+  }
+}
+
+function getKHRParallelShaderCompile (context) {
+  let result = null
+  const exts = context.getSupportedExtensions()
+
+  if (exts && exts.indexOf('KHR_parallel_shader_compile') >= 0) {
+    result = new KHRParallelShaderCompile(context)
+  }
+
+  return result
+}
+
+module.exports = { getKHRParallelShaderCompile, KHRParallelShaderCompile }
@@ -0,0 +1,17 @@
+class STACKGLScratchMemory {
+  constructor (ctx) {
+    this.stats = ctx._getScratchStats.bind(ctx)
+    this.setLimit = function (maxBytes) {
+      if (typeof maxBytes !== 'number' || !(maxBytes >= 0)) {
+        throw new TypeError('maxBytes must be a non-negative number')
+      }
+      ctx._setScratchLimit(maxBytes)
+    }
+  }
+}
+
+function getSTACKGLScratchMemory (ctx) {
+  return new STACKGLScratchMemory(ctx)
+}
+
+module.exports = { getSTACKGLScratchMemory, STACKGLScratchMemory }
@@ -0,0 +1,11 @@
+class STACKGLStateCache {
+  constructor (ctx) {
+    this.stats = ctx._getStateCacheStats.bind(ctx)
+  }
+}
+
+function getSTACKGLStateCache (ctx) {
+  return new STACKGLStateCache(ctx)
+}
+
+module.exports = { getSTACKGLStateCache, STACKGLStateCache }
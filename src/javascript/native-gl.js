@@ -3,7 +3,10 @@
 // doesn't work in Bun compiled executables
 
 const NativeWebGL = require('../../build/Release/webgl_napi.node')
-const { WebGLRenderingContext: NativeWebGLRenderingContext } = NativeWebGL
+const {
+  WebGLRenderingContext: NativeWebGLRenderingContext,
+  WebGL2RenderingContext: NativeWebGL2RenderingContext
+} = NativeWebGL
 
 if (typeof NativeWebGL.cleanup === 'function') {
   process.on('exit', NativeWebGL.cleanup)
@@ -11,10 +14,19 @@ if (typeof NativeWebGL.cleanup === 'function') {
 
 const gl = NativeWebGLRenderingContext.prototype
 
+// WebGL2 only enums, the WebGL1 methods and enums are inherited from gl
+const gl2 = {}
+for (const key of Object.getOwnPropertyNames(NativeWebGL2RenderingContext.prototype)) {
+  const value = NativeWebGL2RenderingContext.prototype[key]
+  if (typeof value === 'number') {
+    gl2[key] = value
+  }
+}
+
 // from binding.gyp
 delete gl['1.0.0']
 
 // from binding.gyp
 delete NativeWebGLRenderingContext['1.0.0']
 
-module.exports = { gl, NativeWebGL, NativeWebGLRenderingContext }
+module.exports = { gl, gl2, NativeWebGL, NativeWebGLRenderingContext }
@@ -1,4 +1,8 @@
+const path = require('path')
 const bits = require('bit-twiddle')
+const { enableCommandBuffer, DEFAULT_COMMAND_BUFFER_SIZE } = require('./command-buffer')
+const { ContextPool, contextAttributesKey } = require('./context-pool')
+const { NativeWebGL } = require('./native-gl')
 const { WebGLContextAttributes } = require('./webgl-context-attributes')
 const { WebGLRenderingContext, WebGL2RenderingContext, wrapContext } = require('./webgl-rendering-context')
 const { WebGLTextureUnit } = require('./webgl-texture-unit')
@@ -6,6 +10,72 @@ const { WebGLVertexArrayObjectState, WebGLVertexArrayGlobalState } = require('./
 
 let CONTEXT_COUNTER = 0
 
+// ANGLE backends that can be selected with the `backend` option, see
+// ANGLE_BACKENDS in webgl.cc. 'default' lets ANGLE pick the platform.
+const BACKENDS = ['default', 'swiftshader', 'vulkan', 'gl', 'gles', 'd3d11', 'metal', 'null']
+
+let DEFAULT_BACKEND = checkBackend(process.env.HEADLESS_GL_BACKEND || 'default')
+
+function checkBackend (backend) {
+  if (BACKENDS.indexOf(backend) === -1) {
+    throw new TypeError(`Unknown ANGLE backend '${backend}', expected one of ${BACKENDS.join(', ')}`)
+  }
+  return backend
+}
+
+function setDefaultBackend (backend) {
+  DEFAULT_BACKEND = checkBackend(backend)
+}
+
+function getDefaultBackend () {
+  return DEFAULT_BACKEND
+}
+
+// Size budget of the persistent program cache when none is given, see ProgramCache.h
+const DEFAULT_PROGRAM_CACHE_SIZE = 64 * 1024 * 1024
+
+// Samples per pixel of antialiased drawing buffers when none are requested
+const DEFAULT_SAMPLES = 4
+
+function setProgramCache (options) {
+  if (typeof options === 'string') {
+    options = { directory: options }
+  }
+  if (!options || typeof options.directory !== 'string' || !options.directory) {
+    throw new TypeError('setProgramCache requires a directory')
+  }
+  const maxBytes = options.maxBytes === undefined ? DEFAULT_PROGRAM_CACHE_SIZE : options.maxBytes
+  if (typeof maxBytes !== 'number' || !(maxBytes > 0)) {
+    throw new TypeError('maxBytes must be a positive number')
+  }
+  NativeWebGL.setProgramCache(path.resolve(options.directory), maxBytes)
+}
+
+function getProgramCacheStats () {
+  return NativeWebGL.getProgramCacheStats()
+}
+
+function flushProgramCache () {
+  NativeWebGL.flushProgramCache()
+}
+
+// Linked programs shared between contexts of this process, see SharedProgramCache
+// in webgl.h. Disabled until a budget is set.
+function setSharedProgramCacheSize (maxBytes) {
+  if (typeof maxBytes !== 'number' || !(maxBytes >= 0)) {
+    throw new TypeError('maxBytes must be a non-negative number')
+  }
+  NativeWebGL.setSharedProgramCacheSize(maxBytes)
+}
+
+function getSharedProgramStats () {
+  return NativeWebGL.getSharedProgramStats()
+}
+
+if (process.env.HEADLESS_GL_PROGRAM_CACHE) {
+  setProgramCache(process.env.HEADLESS_GL_PROGRAM_CACHE)
+}
+
 function flag (options, name, dflt) {
   if (!options || !(typeof options === 'object') || !(name in options)) {
     return dflt
@@ -13,43 +83,93 @@ function flag (options, name, dflt) {
   return !!options[name]
 }
 
-function createContext (width, height, options) {
-  width = width | 0
-  height = height | 0
-  if (!(width > 0 && height > 0)) {
-    return null
+function backendOption (options) {
+  if (!options || typeof options !== 'object') {
+    return DEFAULT_BACKEND
+  }
+  // Dispatch only contexts run on ANGLE's null backend: every call is still
+  // validated and forwarded to GL, but nothing is rasterized.
+  if (options.dispatchOnly) {
+    return 'null'
   }
+  if (options.backend !== undefined) {
+    return checkBackend(options.backend)
+  }
+  return DEFAULT_BACKEND
+}
 
+function createContextAttributes (options) {
   const contextAttributes = new WebGLContextAttributes(
     flag(options, 'alpha', true),
     flag(options, 'depth', true),
     flag(options, 'stencil', false),
-    false, // flag(options, 'antialias', true),
+    flag(options, 'antialias', false),
     flag(options, 'premultipliedAlpha', true),
     flag(options, 'preserveDrawingBuffer', false),
     flag(options, 'preferLowPowerToHighPerformance', false),
     flag(options, 'failIfMajorPerformanceCaveat', false),
-    flag(options, 'createWebGL2Context', false))
+    flag(options, 'createWebGL2Context', false),
+    backendOption(options))
 
   // Can only use premultipliedAlpha if alpha is set
   contextAttributes.premultipliedAlpha =
     contextAttributes.premultipliedAlpha && contextAttributes.alpha
 
+  return contextAttributes
+}
+
+// Size in bytes of the command buffer requested through the `commandBuffer`
+// option, or 0 if calls should go straight to native.
+function commandBufferSize (options) {
+  if (!options || typeof options !== 'object' || !options.commandBuffer) {
+    return 0
+  }
+  if (typeof options.commandBuffer === 'number' && options.commandBuffer > 0) {
+    return options.commandBuffer | 0
+  }
+  return DEFAULT_COMMAND_BUFFER_SIZE
+}
+
+// Largest conversion buffer kept between texture uploads requested through the
+// `scratchLimit` option, see ScratchArena in webgl.h, or -1 for the default.
+function scratchLimit (options) {
+  if (!options || typeof options !== 'object' || options.scratchLimit === undefined) {
+    return -1
+  }
+  if (typeof options.scratchLimit !== 'number' || !(options.scratchLimit >= 0)) {
+    throw new TypeError('scratchLimit must be a non-negative number')
+  }
+  return options.scratchLimit
+}
+
+// Sample count requested through the `samples` option for antialiased drawing
+// buffers. The context clamps it to what the implementation supports.
+function sampleCount (options) {
+  if (!options || typeof options !== 'object' || options.samples === undefined) {
+    return DEFAULT_SAMPLES
+  }
+  if (typeof options.samples !== 'number' || !(options.samples >= 1)) {
+    throw new TypeError('samples must be a positive number')
+  }
+  return options.samples | 0
+}
+
+function createNativeContext (contextAttributes, options) {
+  const limit = scratchLimit(options)
+  const samples = sampleCount(options)
   const WebGLContext = contextAttributes.createWebGL2Context ? WebGL2RenderingContext : WebGLRenderingContext
   let ctx
   try {
     console.error('[gl-bun] Creating WebGLContext with:', {
-      width: 1, height: 1,
       alpha: contextAttributes.alpha,
       depth: contextAttributes.depth,
       stencil: contextAttributes.stencil,
       antialias: contextAttributes.antialias,
       premultipliedAlpha: contextAttributes.premultipliedAlpha,
       preserveDrawingBuffer: contextAttributes.preserveDrawingBuffer,
+      backend: contextAttributes.backend,
     })
     ctx = new WebGLContext(
-      1,
-      1,
       contextAttributes.alpha,
       contextAttributes.depth,
       contextAttributes.stencil,
@@ -58,7 +178,8 @@ function createContext (width, height, options) {
       contextAttributes.preserveDrawingBuffer,
       contextAttributes.preferLowPowerToHighPerformance,
       contextAttributes.failIfMajorPerformanceCaveat,
-      contextAttributes.createWebGL2Context)
+      contextAttributes.createWebGL2Context,
+      contextAttributes.backend)
     console.error('[gl-bun] Context created:', !!ctx)
   } catch (e) {
     console.error('[gl-bun] WebGLContext creation failed:', e)
@@ -67,13 +188,36 @@ function createContext (width, height, options) {
     return null
   }
 
+  ctx._contextAttributes = contextAttributes
+  ctx._commandBuffer = null
+  ctx._reuseDrawingBuffer = flag(options, 'reuseDrawingBuffer', false)
+
+  // Antialiasing is reported as off when the drawing buffer cannot be multisampled
+  ctx._samples = contextAttributes.antialias ? ctx._drawingBufferSamples(samples) : 0
+  contextAttributes.antialias = ctx._samples > 0
+
+  const byteLength = commandBufferSize(options)
+  if (byteLength > 0) {
+    enableCommandBuffer(ctx, byteLength)
+  }
+
+  if (limit >= 0) {
+    ctx._setScratchLimit(limit)
+  }
+
+  return ctx
+}
+
+// Sets up the JS side state and the default drawing buffer. Runs once for a
+// freshly created context and again each time a pooled context is handed out.
+function initContext (ctx, width, height) {
+  const contextAttributes = ctx._contextAttributes
+
   ctx.drawingBufferWidth = width
   ctx.drawingBufferHeight = height
 
   ctx._ = CONTEXT_COUNTER++
 
-  ctx._contextAttributes = contextAttributes
-
   ctx._extensions = {}
   ctx._programs = {}
   ctx._shaders = {}
@@ -102,8 +246,6 @@ function createContext (width, height, options) {
   ctx._activeTextureUnit = 0
   ctx.activeTexture(ctx.TEXTURE0)
 
-  ctx._errorStack = []
-
   // Vertex array attributes that are in vertex array objects.
   ctx._defaultVertexObjectState = new WebGLVertexArrayObjectState(ctx)
   ctx._vertexObjectState = ctx._defaultVertexObjectState
@@ -111,11 +253,14 @@ function createContext (width, height, options) {
   // Vertex array attibures that are not in vertex array objects.
   ctx._vertexGlobalState = new WebGLVertexArrayGlobalState(ctx)
 
-  // Store limits
-  ctx._maxTextureSize = ctx.getParameter(ctx.MAX_TEXTURE_SIZE)
-  ctx._maxTextureLevel = bits.log2(bits.nextPow2(ctx._maxTextureSize))
-  ctx._maxCubeMapSize = ctx.getParameter(ctx.MAX_CUBE_MAP_TEXTURE_SIZE)
-  ctx._maxCubeMapLevel = bits.log2(bits.nextPow2(ctx._maxCubeMapSize))
+  // Store limits, these never change over the lifetime of a context
+  if (ctx._maxTextureSize === undefined) {
+    ctx._maxTextureSize = ctx.getParameter(ctx.MAX_TEXTURE_SIZE)
+    ctx._maxTextureLevel = bits.log2(bits.nextPow2(ctx._maxTextureSize))
+    ctx._maxCubeMapSize = ctx.getParameter(ctx.MAX_CUBE_MAP_TEXTURE_SIZE)
+    ctx._maxCubeMapLevel = bits.log2(bits.nextPow2(ctx._maxCubeMapSize))
+    ctx._maxDrawingBufferSize = Math.min(ctx._maxTextureSize, ctx.getParameter(ctx.MAX_RENDERBUFFER_SIZE))
+  }
 
   // Unpack alignment
   ctx._unpackAlignment = 4
@@ -142,8 +287,96 @@ function createContext (width, height, options) {
   ctx.clearColor(0, 0, 0, 0)
   ctx.clearStencil(0)
   ctx.clear(ctx.COLOR_BUFFER_BIT | ctx.DEPTH_BUFFER_BIT | ctx.STENCIL_BUFFER_BIT)
+}
+
+// The native reset deleted every GL object, so make sure wrappers the previous
+// user may still hold are rejected instead of aliasing freshly generated names.
+function invalidateObjects (ctx) {
+  const tables = [
+    ctx._programs,
+    ctx._shaders,
+    ctx._buffers,
+    ctx._textures,
+    ctx._framebuffers,
+    ctx._renderbuffers,
+    ctx._vaos,
+    ctx._extensions.oes_vertex_array_object && ctx._extensions.oes_vertex_array_object._vaos
+  ]
+  for (const table of tables) {
+    if (!table) {
+      continue
+    }
+    for (const id in table) {
+      table[id]._ = 0
+    }
+  }
+  ctx._drawingBuffer = null
+  ctx._attrib0Buffer = null
+}
+
+function createContext (width, height, options) {
+  width = width | 0
+  height = height | 0
+  if (!(width > 0 && height > 0)) {
+    return null
+  }
+
+  const ctx = createNativeContext(createContextAttributes(options), options)
+  if (!ctx) {
+    return null
+  }
+  initContext(ctx, width, height)
 
   return wrapContext(ctx)
 }
 
+function createContextPool (options) {
+  const contexts = new WeakMap()
+
+  return new ContextPool({
+    maxIdle: options && options.maxIdle,
+
+    key (options) {
+      return contextAttributesKey(createContextAttributes(options)) + ':' + commandBufferSize(options) +
+        ':' + scratchLimit(options) + ':' + sampleCount(options) + ':' + flag(options, 'reuseDrawingBuffer', false)
+    },
+
+    create (options) {
+      const ctx = createNativeContext(createContextAttributes(options), options)
+      if (!ctx) {
+        return null
+      }
+      const gl = wrapContext(ctx)
+      contexts.set(gl, ctx)
+      return gl
+    },
+
+    init (gl, width, height) {
+      initContext(contexts.get(gl), width, height)
+    },
+
+    reset (gl) {
+      const ctx = contexts.get(gl)
+      if (!ctx._resetContext()) {
+        return false
+      }
+      invalidateObjects(ctx)
+      return true
+    },
+
+    destroy (gl) {
+      contexts.get(gl).destroy()
+      contexts.delete(gl)
+    }
+  })
+}
+
 module.exports = createContext
+module.exports.createContextPool = createContextPool
+module.exports.setDefaultBackend = setDefaultBackend
+module.exports.getDefaultBackend = getDefaultBackend
+module.exports.setProgramCache = setProgramCache
+module.exports.getProgramCacheStats = getProgramCacheStats
+module.exports.flushProgramCache = flushProgramCache
+module.exports.setSharedProgramCacheSize = setSharedProgramCacheSize
+module.exports.getSharedProgramStats = getSharedProgramStats
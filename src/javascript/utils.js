@@ -1,4 +1,4 @@
-const { gl } = require('./native-gl')
+const { gl, gl2 } = require('./native-gl')
 
 const { WebGLUniformLocation } = require('./webgl-uniform-location')
 
@@ -104,6 +104,35 @@ function typeSize (type) {
   return 0
 }
 
+// True if pixels is the kind of typed array WebGL requires for reading or
+// writing pixels of the given type. Unknown types are left to GL to reject.
+function checkPixelArrayType (pixels, type) {
+  switch (type) {
+    case gl.UNSIGNED_BYTE:
+      return pixels instanceof Uint8Array || pixels instanceof Uint8ClampedArray
+    case gl.BYTE:
+      return pixels instanceof Int8Array
+    case gl.UNSIGNED_SHORT:
+    case gl.UNSIGNED_SHORT_5_6_5:
+    case gl.UNSIGNED_SHORT_4_4_4_4:
+    case gl.UNSIGNED_SHORT_5_5_5_1:
+    case gl2.HALF_FLOAT:
+      return pixels instanceof Uint16Array
+    case gl.SHORT:
+      return pixels instanceof Int16Array
+    case gl.UNSIGNED_INT:
+    case gl2.UNSIGNED_INT_2_10_10_10_REV:
+    case gl2.UNSIGNED_INT_10F_11F_11F_REV:
+    case gl2.UNSIGNED_INT_5_9_9_9_REV:
+      return pixels instanceof Uint32Array
+    case gl.INT:
+      return pixels instanceof Int32Array
+    case gl.FLOAT:
+      return pixels instanceof Float32Array
+  }
+  return true
+}
+
 function uniformTypeSize (type) {
   switch (type) {
     case gl.BOOL_VEC4:
@@ -139,6 +168,18 @@ function unpackTypedArray (array) {
     array.byteLength + array.byteOffset)
 }
 
+// Returns the first length elements of value as an ArrayType for a single
+// native uniform array upload, without copying if value already has that type
+function uniformArrayData (ArrayType, value, length) {
+  if (value instanceof ArrayType) {
+    return value.length > length ? value.subarray(0, length) : value
+  }
+  if (value.length > length) {
+    return new ArrayType(Array.prototype.slice.call(value, 0, length))
+  }
+  return new ArrayType(value)
+}
+
 function extractImageData (pixels) {
   if (typeof pixels === 'object' && typeof pixels.width !== 'undefined' && typeof pixels.height !== 'undefined') {
     if (typeof pixels.data !== 'undefined') {
@@ -220,18 +261,48 @@ function validCubeTarget (target) {
     target === gl.TEXTURE_CUBE_MAP_NEGATIVE_Z
 }
 
+// Resolves once check() returns true. Checks on the next turn of the event loop
+// first, then backs off to timers of up to 4 ms so a long wait stays cheap.
+function pollUntil (check) {
+  return new Promise((resolve, reject) => {
+    let delay = 0
+    const poll = () => {
+      let done
+      try {
+        done = check()
+      } catch (err) {
+        reject(err)
+        return
+      }
+      if (done) {
+        resolve()
+      } else if (delay === 0) {
+        delay = 1
+        setImmediate(poll)
+      } else {
+        setTimeout(poll, delay)
+        delay = Math.min(delay * 2, 4)
+      }
+    }
+    poll()
+  })
+}
+
 module.exports = {
   bindPublics,
   checkObject,
   isTypedArray,
   isValidString,
+  pollUntil,
   vertexCount,
   typeSize,
   uniformTypeSize,
   unpackTypedArray,
+  uniformArrayData,
   extractImageData,
   formatSize,
   checkFormat,
+  checkPixelArrayType,
   checkUniform,
   convertPixels,
   validCubeTarget
@@ -3,6 +3,24 @@ class WebGLDrawingBufferWrapper {
     this._framebuffer = framebuffer
     this._color = color
     this._depthStencil = depthStencil
+
+    // Antialiased drawing buffers render into multisampled storage on
+    // _framebuffer and are resolved into _color, attached to _resolveFramebuffer,
+    // before they are read.
+    this._samples = 0
+    this._resolveFramebuffer = framebuffer
+    this._multisampleColor = 0
+
+    // Set by anything that writes to the drawing buffer, cleared by a resolve.
+    // Reads skip the resolve while _color is still up to date.
+    this._dirty = false
+
+    // Size of the attachments. Drawing buffers that reuse their storage keep it
+    // when they shrink and grow it to the next power of two, so they can be
+    // larger than drawingBufferWidth/Height.
+    this._reuse = false
+    this._width = 0
+    this._height = 0
   }
 }
 
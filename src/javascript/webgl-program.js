@@ -8,8 +8,12 @@ class WebGLProgram extends Linkable {
     this._linkCount = 0
     this._linkStatus = false
     this._linkInfoLog = 'not linked'
+    this._linkPending = false
     this._attributes = []
     this._uniforms = []
+    this._uniformIndex = new Map()
+    this._uniformBlocks = []
+    this._transformFeedbackVaryings = []
   }
 
   _performDelete () {
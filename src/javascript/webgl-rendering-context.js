@@ -1,5 +1,6 @@
 const HEADLESS_VERSION = require('../../package.json').version
-const { gl, NativeWebGLRenderingContext, NativeWebGL } = require('./native-gl')
+const bits = require('bit-twiddle')
+const { gl, gl2, NativeWebGLRenderingContext, NativeWebGL } = require('./native-gl')
 const { getANGLEInstancedArrays } = require('./extensions/angle-instanced-arrays')
 const { getOESElementIndexUint } = require('./extensions/oes-element-index-unit')
 const { getOESStandardDerivatives } = require('./extensions/oes-standard-derivatives')
@@ -7,21 +8,28 @@ const { getOESTextureFloat } = require('./extensions/oes-texture-float')
 const { getOESTextureFloatLinear } = require('./extensions/oes-texture-float-linear')
 const { getSTACKGLDestroyContext } = require('./extensions/stackgl-destroy-context')
 const { getSTACKGLResizeDrawingBuffer } = require('./extensions/stackgl-resize-drawing-buffer')
+const { getSTACKGLStateCache } = require('./extensions/stackgl-state-cache')
+const { getSTACKGLScratchMemory } = require('./extensions/stackgl-scratch-memory')
 const { getWebGLDrawBuffers } = require('./extensions/webgl-draw-buffers')
 const { getEXTBlendMinMax } = require('./extensions/ext-blend-minmax')
 const { getEXTTextureFilterAnisotropic } = require('./extensions/ext-texture-filter-anisotropic')
 const { getEXTShaderTextureLod } = require('./extensions/ext-shader-texture-lod')
 const { getOESVertexArrayObject } = require('./extensions/oes-vertex-array-object')
+const { getKHRParallelShaderCompile } = require('./extensions/khr-parallel-shader-compile')
 const {
   bindPublics,
   checkObject,
+  checkPixelArrayType,
   checkUniform,
   isValidString,
+  pollUntil,
   typeSize,
+  formatSize,
   uniformTypeSize,
   extractImageData,
   isTypedArray,
   unpackTypedArray,
+  uniformArrayData,
   convertPixels,
   validCubeTarget
 } = require('./utils')
@@ -42,6 +50,10 @@ const { getEXTColorBufferFloat } = require('./extensions/ext-color-buffer-float'
 // These are defined by the WebGL spec
 const MAX_UNIFORM_LENGTH = 256
 const MAX_ATTRIBUTE_LENGTH = 256
+const COMPLETION_STATUS_KHR = 0x91B1
+const READ_FRAMEBUFFER = 0x8CA8
+const RGB8 = 0x8051
+const RGBA8 = 0x8058
 
 const DEFAULT_ATTACHMENTS = [
   gl.COLOR_ATTACHMENT0,
@@ -52,6 +64,44 @@ const DEFAULT_ATTACHMENTS = [
 
 const DEFAULT_COLOR_ATTACHMENTS = [gl.COLOR_ATTACHMENT0]
 
+// Output layouts for readPixels options, in the order of PixelKernels::PackFormat
+const READBACK_FORMATS = ['rgba', 'rgb', 'bgra', 'gray']
+const READBACK_PIXEL_SIZES = [4, 3, 4, 1]
+
+// Native arguments for the readPixels options, or null if there are none
+function readbackArgs (options) {
+  if (options === undefined || options === null || typeof options !== 'object') {
+    return null
+  }
+  const format = READBACK_FORMATS.indexOf(options.outputFormat || 'rgba')
+  if (format < 0) {
+    throw new TypeError('outputFormat must be one of ' + READBACK_FORMATS.join(', '))
+  }
+  return [format, !!options.packFlipY, !!options.unpremultiply]
+}
+
+// Clips one axis of a blit so its source ends at `limit`, moving the matching
+// destination edge by the same fraction of the rectangle. A source that lies
+// entirely past `limit` becomes empty, which blits nothing.
+function clipBlitAxis (src0, src1, dst0, dst1, limit) {
+  if (src0 <= limit && src1 <= limit) {
+    return [src0, src1, dst0, dst1]
+  }
+  if (src0 >= limit && src1 >= limit) {
+    return [limit, limit, dst0, dst1]
+  }
+  const dst = dst0 + Math.round((limit - src0) * (dst1 - dst0) / (src1 - src0))
+  return src0 > limit ? [limit, src1, dst, dst1] : [src0, limit, dst0, dst]
+}
+
+// Settles a texSubImage2DAsync promise with the GL error of its upload
+function uploadResult (error) {
+  if (error) {
+    return Promise.reject(new Error('texSubImage2DAsync: upload failed with GL error 0x' + error.toString(16)))
+  }
+  return Promise.resolve()
+}
+
 const availableExtensions = {
   angle_instanced_arrays: getANGLEInstancedArrays,
   oes_element_index_uint: getOESElementIndexUint,
@@ -61,17 +111,37 @@ const availableExtensions = {
   oes_vertex_array_object: getOESVertexArrayObject,
   stackgl_destroy_context: getSTACKGLDestroyContext,
   stackgl_resize_drawingbuffer: getSTACKGLResizeDrawingBuffer,
+  stackgl_state_cache: getSTACKGLStateCache,
+  stackgl_scratch_memory: getSTACKGLScratchMemory,
   webgl_draw_buffers: getWebGLDrawBuffers,
   ext_blend_minmax: getEXTBlendMinMax,
   ext_texture_filter_anisotropic: getEXTTextureFilterAnisotropic,
   ext_shader_texture_lod: getEXTShaderTextureLod,
-  ext_color_buffer_float: getEXTColorBufferFloat
+  ext_color_buffer_float: getEXTColorBufferFloat,
+  khr_parallel_shader_compile: getKHRParallelShaderCompile
 }
 
 const privateMethods = [
   'constructor',
   'resize',
-  'destroy'
+  'destroy',
+  '_resetContext',
+  '_getStateCacheStats',
+  '_getScratchStats',
+  '_setScratchLimit',
+  '_getProgramReflection',
+  '_maxShaderCompilerThreads',
+  '_texSubImage2DAsync',
+  '_readPixelsAsync',
+  '_readPixelsAsyncPoll',
+  '_readPixelsAsyncFinish',
+  '_encodeFrame',
+  '_drawingBufferSamples',
+  '_drawingBufferStorageMultisample',
+  '_resolveDrawingBuffer',
+  '_clearDrawingBuffer',
+  '_executeCommandBuffer',
+  '_setCommandBuffer'
 ]
 
 function wrapContext (ctx) {
@@ -182,44 +252,99 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   }
 
   _fixupLink (program) {
-    if (!super.getProgramParameter(program._, this.LINK_STATUS)) {
+    // One native call returns the link status and every active item, see
+    // GetProgramReflection in webgl.cc for the layout
+    const reflection = super._getProgramReflection(program._ | 0)
+    const layout = reflection.layout
+    program._attributes = []
+    program._uniforms = []
+    program._uniformIndex = new Map()
+    program._uniformBlocks = []
+    program._transformFeedbackVaryings = []
+    if (!layout[0]) {
       program._linkInfoLog = super.getProgramInfoLog(program._)
       return false
     }
 
-    // Record attribute attributeLocations
-    const numAttribs = this.getProgramParameter(program, this.ACTIVE_ATTRIBUTES)
-    const names = new Array(numAttribs)
-    program._attributes.length = numAttribs
-    for (let i = 0; i < numAttribs; ++i) {
-      names[i] = this.getActiveAttrib(program, i).name
-      program._attributes[i] = this.getAttribLocation(program, names[i]) | 0
-    }
+    const names = reflection.names.split('\0')
+    const numAttribs = layout[1]
+    const numUniforms = layout[2]
+    const numBlocks = layout[3]
+    const numVaryings = layout[4]
+    let offset = 5
+    let nameIndex = 0
 
-    // Check attribute names
-    for (let i = 0; i < names.length; ++i) {
-      if (names[i].length > MAX_ATTRIBUTE_LENGTH) {
-        program._linkInfoLog = 'attribute ' + names[i] + ' is too long'
+    // The active attributes, uniforms, blocks and varyings answer the getActive*
+    // queries, the native side already pinned attribute locations for relinks
+    program._attributes.length = numAttribs
+    for (let i = 0; i < numAttribs; ++i, offset += 2) {
+      const name = names[nameIndex++]
+      if (name.length > MAX_ATTRIBUTE_LENGTH) {
+        program._linkInfoLog = 'attribute ' + name + ' is too long'
         return false
       }
+      program._attributes[i] = new WebGLActiveInfo({
+        type: layout[offset],
+        size: layout[offset + 1],
+        name
+      })
     }
 
-    for (let i = 0; i < numAttribs; ++i) {
-      super.bindAttribLocation(
-        program._ | 0,
-        program._attributes[i],
-        names[i])
+    // Index every name getUniformLocation accepts, including each array element
+    // and the array name without [0], so lookups are a single Map access
+    program._uniforms.length = numUniforms
+    for (let i = 0; i < numUniforms; ++i) {
+      const type = layout[offset]
+      const size = layout[offset + 1]
+      const location = layout[offset + 2]
+      const name = names[nameIndex++]
+      offset += 3
+      program._uniforms[i] = new WebGLActiveInfo({ type, size, name })
+      if (location < 0) {
+        continue
+      }
+
+      const info = { size, type, name }
+      if (size > 1 && name.endsWith('[0]')) {
+        const baseName = name.slice(0, -3)
+        const array = [location]
+        let valid = true
+        for (let j = 1; j < size; ++j) {
+          const elementLocation = layout[offset + j - 1]
+          valid = valid && elementLocation >= 0
+          if (valid) {
+            array.push(elementLocation)
+            program._uniformIndex.set(baseName + '[' + j + ']', { location: elementLocation, info, array: null })
+          }
+        }
+        offset += size - 1
+        const entry = { location, info, array }
+        program._uniformIndex.set(name, entry)
+        program._uniformIndex.set(baseName, entry)
+      } else {
+        program._uniformIndex.set(name, {
+          location,
+          info,
+          array: name.endsWith('[0]') ? [location] : null
+        })
+      }
     }
 
-    super.linkProgram(program._ | 0)
+    program._uniformBlocks.length = numBlocks
+    for (let i = 0; i < numBlocks; ++i) {
+      program._uniformBlocks[i] = names[nameIndex++]
+    }
 
-    const numUniforms = this.getProgramParameter(program, this.ACTIVE_UNIFORMS)
-    program._uniforms.length = numUniforms
-    for (let i = 0; i < numUniforms; ++i) {
-      program._uniforms[i] = this.getActiveUniform(program, i)
+    program._transformFeedbackVaryings.length = numVaryings
+    for (let i = 0; i < numVaryings; ++i, offset += 2) {
+      program._transformFeedbackVaryings[i] = new WebGLActiveInfo({
+        type: layout[offset],
+        size: layout[offset + 1],
+        name: names[nameIndex++]
+      })
     }
 
-    // Check attribute and uniform name lengths
+    // Check uniform name lengths
     for (let i = 0; i < program._uniforms.length; ++i) {
       if (program._uniforms[i].name.length > MAX_UNIFORM_LENGTH) {
         program._linkInfoLog = 'uniform ' + program._uniforms[i].name + ' is too long'
@@ -231,6 +356,25 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return true
   }
 
+  // compileShader and linkProgram only start the work, the driver may finish it on
+  // its compiler threads. The results are collected the first time they are needed.
+  _resolveCompile (shader) {
+    if (shader._compilePending) {
+      shader._compilePending = false
+      shader._compileStatus = !!super.getShaderParameter(
+        shader._ | 0,
+        this.COMPILE_STATUS)
+      shader._compileInfo = super.getShaderInfoLog(shader._ | 0)
+    }
+  }
+
+  _resolveLink (program) {
+    if (program._linkPending) {
+      program._linkPending = false
+      program._linkStatus = this._fixupLink(program)
+    }
+  }
+
   _framebufferOk () {
     return true
   }
@@ -326,7 +470,32 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     const contextAttributes = this._contextAttributes
 
     const drawingBuffer = this._drawingBuffer
-    super.bindFramebuffer(this.FRAMEBUFFER, drawingBuffer._framebuffer)
+    drawingBuffer._dirty = true
+    if (drawingBuffer._reuse) {
+      // Storage that is large enough already only has to look freshly allocated
+      if (width <= drawingBuffer._width && height <= drawingBuffer._height) {
+        let mask = this.COLOR_BUFFER_BIT
+        if (contextAttributes.depth) {
+          mask |= this.DEPTH_BUFFER_BIT
+        }
+        if (contextAttributes.stencil) {
+          mask |= this.STENCIL_BUFFER_BIT
+        }
+        super.bindFramebuffer(this.FRAMEBUFFER, drawingBuffer._framebuffer)
+        super._clearDrawingBuffer(mask)
+        this.bindFramebuffer(this.FRAMEBUFFER, prevFramebuffer)
+        return
+      }
+      width = Math.max(width, drawingBuffer._width,
+        Math.min(bits.nextPow2(width), this._maxDrawingBufferSize))
+      height = Math.max(height, drawingBuffer._height,
+        Math.min(bits.nextPow2(height), this._maxDrawingBufferSize))
+    }
+    drawingBuffer._width = width
+    drawingBuffer._height = height
+
+    const samples = drawingBuffer._samples
+    super.bindFramebuffer(this.FRAMEBUFFER, drawingBuffer._resolveFramebuffer)
     const attachments = this._getAttachments()
     // Clear all attachments
     for (let i = 0; i < attachments.length; ++i) {
@@ -360,6 +529,18 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       drawingBuffer._color,
       0)
 
+    // Antialiased drawing buffers render into multisampled storage instead
+    if (samples) {
+      super.bindFramebuffer(this.FRAMEBUFFER, drawingBuffer._framebuffer)
+      super.bindRenderbuffer(this.RENDERBUFFER, drawingBuffer._multisampleColor)
+      super._drawingBufferStorageMultisample(samples, colorFormat, width, height)
+      super.framebufferRenderbuffer(
+        this.FRAMEBUFFER,
+        this.COLOR_ATTACHMENT0,
+        this.RENDERBUFFER,
+        drawingBuffer._multisampleColor)
+    }
+
     // Update depth-stencil attachments if needed
     let storage = 0
     let attachment = 0
@@ -378,11 +559,15 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       super.bindRenderbuffer(
         this.RENDERBUFFER,
         drawingBuffer._depthStencil)
-      super.renderbufferStorage(
-        this.RENDERBUFFER,
-        storage,
-        width,
-        height)
+      if (samples) {
+        super._drawingBufferStorageMultisample(samples, storage, width, height)
+      } else {
+        super.renderbufferStorage(
+          this.RENDERBUFFER,
+          storage,
+          width,
+          height)
+      }
       super.framebufferRenderbuffer(
         this.FRAMEBUFFER,
         attachment,
@@ -396,17 +581,110 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     this.bindRenderbuffer(this.RENDERBUFFER, prevRenderbuffer)
   }
 
-  _restoreError (lastError) {
-    const topError = this._errorStack.pop()
-    if (topError === this.NO_ERROR) {
-      this.setError(lastError)
+  // Reads from an antialiased drawing buffer go through its resolved copy. Call
+  // before anything that reads from the read framebuffer and pass the result to
+  // _endDrawingBufferRead afterwards.
+  _beginDrawingBufferRead () {
+    const drawingBuffer = this._drawingBuffer
+    if (!drawingBuffer._samples || this._activeFramebuffers.read) {
+      return false
+    }
+    if (drawingBuffer._dirty) {
+      super._resolveDrawingBuffer(
+        drawingBuffer._framebuffer,
+        drawingBuffer._resolveFramebuffer,
+        this.drawingBufferWidth,
+        this.drawingBufferHeight)
+      drawingBuffer._dirty = false
     } else {
-      this.setError(topError)
+      super.bindFramebuffer(READ_FRAMEBUFFER, drawingBuffer._resolveFramebuffer)
+    }
+    return true
+  }
+
+  // Call from anything that may write to the draw framebuffer
+  _writeDrawingBuffer () {
+    if (!this._activeFramebuffers.draw) {
+      this._drawingBuffer._dirty = true
+    }
+  }
+
+  _endDrawingBufferRead (resolved) {
+    if (resolved) {
+      super.bindFramebuffer(READ_FRAMEBUFFER, this._drawingBuffer._framebuffer)
     }
   }
 
-  _saveError () {
-    this._errorStack.push(this.getError())
+  // True if the rectangle extends past the logical size of a drawing buffer
+  // whose storage is larger. Those pixels are outside the drawing buffer.
+  _readsPastDrawingBuffer (x, y, width, height) {
+    return this._drawingBuffer._reuse && !this._activeFramebuffers.read &&
+      (x + width > this.drawingBufferWidth || y + height > this.drawingBufferHeight)
+  }
+
+  // Copies out of a drawing buffer whose storage is larger than its size. The
+  // full copy is made from a rectangle of the same size outside the storage,
+  // which checks the arguments and leaves the texels zero (copyTexImage2D) or
+  // untouched (copyTexSubImage*). Then the part of the rectangle inside the
+  // drawing buffer is copied with copySub(xoffset, yoffset, x, y, width, height),
+  // the offsets relative to the rectangle.
+  _copyClipped (x, y, width, height, copyFull, copySub) {
+    if (copyFull(-width, -height) !== this.NO_ERROR) {
+      return
+    }
+    const x0 = Math.max(x, 0)
+    const x1 = Math.min(x + width, this.drawingBufferWidth)
+    const y0 = Math.max(y, 0)
+    const y1 = Math.min(y + height, this.drawingBufferHeight)
+    if (x0 < x1 && y0 < y1) {
+      copySub(x0 - x, y0 - y, x0, y0, x1 - x0, y1 - y0)
+    }
+  }
+
+  // Reads the part of the rectangle that lies inside the logical drawing buffer
+  // one row at a time and leaves the rest of `pixels` untouched.
+  _readPixelsClipped (x, y, width, height, format, type, pixels, readback) {
+    let pixelSize = 0
+    let rowStride = 0
+    if (readback) {
+      pixelSize = READBACK_PIXEL_SIZES[readback[0]]
+      rowStride = width * pixelSize
+    } else {
+      pixelSize = typeSize(type) ? formatSize(format) * typeSize(type) : 2
+      rowStride = Math.ceil(width * pixelSize / this._packAlignment) * this._packAlignment
+    }
+    if (pixels.byteLength < rowStride * (height - 1) + width * pixelSize) {
+      this.setError(this.INVALID_OPERATION)
+      return
+    }
+
+    const args = readback || []
+    const x0 = Math.max(x, 0)
+    const x1 = Math.min(x + width, this.drawingBufferWidth)
+    const y0 = Math.max(y, 0)
+    const y1 = Math.min(y + height, this.drawingBufferHeight)
+    if (x0 >= x1 || y0 >= y1) {
+      // Nothing is inside, but the format and type are still validated
+      super.readPixels(0, 0, 0, 0, format, type, pixels, ...args)
+      return
+    }
+
+    const flipY = readback && readback[1]
+    const elementSize = pixels.BYTES_PER_ELEMENT
+    const rowBytes = (x1 - x0) * pixelSize
+    for (let row = y0; row < y1; ++row) {
+      const line = flipY ? y + height - 1 - row : row - y
+      const offset = line * rowStride + (x0 - x) * pixelSize
+      super.readPixels(
+        x0,
+        row,
+        x1 - x0,
+        1,
+        format,
+        type,
+        pixels.subarray(offset / elementSize, (offset + rowBytes) / elementSize),
+        ...args)
+    }
   }
 
   _switchActiveProgram (active) {
@@ -469,6 +747,14 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return false
   }
 
+  // WebGL 1 only binds FRAMEBUFFER. ANGLE accepts READ_FRAMEBUFFER and
+  // DRAW_FRAMEBUFFER as well on antialiased contexts, which enable
+  // GL_ANGLE_framebuffer_blit for their drawing buffer.
+  _validFramebufferTarget (target) {
+    return target === this.FRAMEBUFFER ||
+      (this._isWebGL2() && (target === this.READ_FRAMEBUFFER || target === this.DRAW_FRAMEBUFFER))
+  }
+
   _validGLSLIdentifier (str) {
     return !(str.indexOf('webgl_') === 0 ||
       str.indexOf('_webgl_') === 0 ||
@@ -530,12 +816,9 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       this._checkOwns(program) &&
       this._checkOwns(shader)) {
       if (!program._linked(shader)) {
-        this._saveError()
-        super.attachShader(
+        const error = super.attachShader(
           program._ | 0,
           shader._ | 0)
-        const error = this.getError()
-        this._restoreError(error)
         if (error === this.NO_ERROR) {
           program._link(shader)
         }
@@ -556,6 +839,8 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (/^_?webgl_a/.test(name)) {
       this.setError(this.INVALID_OPERATION)
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      // The pending link pins attribute locations, which must not override this binding
+      this._resolveLink(program)
       return super.bindAttribLocation(
         program._ | 0,
         index | 0,
@@ -567,23 +852,21 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(framebuffer)) {
       throw new TypeError('bindFramebuffer(GLenum, WebGLFramebuffer)')
     }
+    if (!this._validFramebufferTarget(target)) {
+      this.setError(this.INVALID_ENUM)
+      return
+    }
     let error = 0
     if (!framebuffer) {
-      this._saveError()
-      super.bindFramebuffer(
+      error = super.bindFramebuffer(
         target,
         this._drawingBuffer._framebuffer)
-      error = super.getError()
-      this._restoreError(error)
     } else if (framebuffer._pendingDelete) {
       return
     } else if (this._checkWrapper(framebuffer, WebGLFramebuffer)) {
-      this._saveError()
-      super.bindFramebuffer(
+      error = super.bindFramebuffer(
         target,
         framebuffer._ | 0)
-      error = super.getError()
-      this._restoreError(error)
     } else {
       return
     }
@@ -693,12 +976,9 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
-    this._saveError()
-    super.bindTexture(
+    const error = super.bindTexture(
       target,
       textureId)
-    const error = this.getError()
-    this._restoreError(error)
 
     if (error !== this.NO_ERROR) {
       return
@@ -946,13 +1226,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         return
       }
 
-      this._saveError()
-      super.bufferData(
+      const error = super.bufferData(
         target,
         u8Data,
         usage)
-      const error = this.getError()
-      this._restoreError(error)
       if (error !== this.NO_ERROR) {
         return
       }
@@ -968,13 +1245,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         return
       }
 
-      this._saveError()
-      super.bufferData(
+      const error = super.bufferData(
         target,
         size,
         usage)
-      const error = this.getError()
-      this._restoreError(error)
       if (error !== this.NO_ERROR) {
         return
       }
@@ -1044,6 +1318,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   }
 
   checkFramebufferStatus (target) {
+    if (!this._validFramebufferTarget(target | 0)) {
+      this.setError(this.INVALID_ENUM)
+      return 0
+    }
     return super.checkFramebufferStatus(target)
   }
 
@@ -1051,9 +1329,30 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!this._framebufferOk()) {
       return
     }
+    this._writeDrawingBuffer()
     return super.clear(mask | 0)
   }
 
+  clearBufferfv (buffer, drawbuffer, values) {
+    this._writeDrawingBuffer()
+    return super.clearBufferfv(buffer | 0, drawbuffer | 0, values)
+  }
+
+  clearBufferiv (buffer, drawbuffer, values) {
+    this._writeDrawingBuffer()
+    return super.clearBufferiv(buffer | 0, drawbuffer | 0, values)
+  }
+
+  clearBufferuiv (buffer, drawbuffer, values) {
+    this._writeDrawingBuffer()
+    return super.clearBufferuiv(buffer | 0, drawbuffer | 0, values)
+  }
+
+  clearBufferfi (buffer, drawbuffer, depth, stencil) {
+    this._writeDrawingBuffer()
+    return super.clearBufferfi(buffer | 0, drawbuffer | 0, +depth, stencil | 0)
+  }
+
   clearColor (red, green, blue, alpha) {
     return super.clearColor(+red, +green, +blue, +alpha)
   }
@@ -1077,18 +1376,21 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
     if (this._checkWrapper(shader, WebGLShader) &&
       this._checkShaderSource(shader)) {
-      const prevError = this.getError()
       super.compileShader(shader._ | 0)
-      const error = this.getError()
-      shader._compileStatus = !!super.getShaderParameter(
-        shader._ | 0,
-        this.COMPILE_STATUS)
-      shader._compileInfo = super.getShaderInfoLog(shader._ | 0)
-      this.getError()
-      this.setError(prevError || error)
+      shader._compilePending = true
     }
   }
 
+  // Resolves with the compile status once the driver has finished compiling,
+  // without blocking the event loop in between
+  compileShaderAsync (shader) {
+    this.compileShader(shader)
+    return this._whenComplete(shader, 'compile').then(() => {
+      this._resolveCompile(shader)
+      return shader._compileStatus
+    })
+  }
+
   copyTexImage2D (
     target,
     level,
@@ -1104,18 +1406,27 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     height |= 0
     border |= 0
 
-    this._saveError()
-    super.copyTexImage2D(
-      target,
-      level,
-      internalFormat,
-      x,
-      y,
-      width,
-      height,
-      border)
-    const error = this.getError()
-    this._restoreError(error)
+    const resolved = this._beginDrawingBufferRead()
+    let error = this.NO_ERROR
+    const copyFull = (x, y) => {
+      error = super.copyTexImage2D(
+        target,
+        level,
+        internalFormat,
+        x,
+        y,
+        width,
+        height,
+        border)
+      return error
+    }
+    if (this._readsPastDrawingBuffer(x, y, width, height)) {
+      this._copyClipped(x, y, width, height, copyFull, (xoffset, yoffset, x, y, width, height) =>
+        super.copyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height))
+    } else {
+      copyFull(x, y)
+    }
+    this._endDrawingBufferRead(resolved)
 
     if (error === this.NO_ERROR) {
       const texture = this._getTexImage(target)
@@ -1138,15 +1449,85 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     width |= 0
     height |= 0
 
-    super.copyTexSubImage2D(
+    const resolved = this._beginDrawingBufferRead()
+    const copySub = (dx, dy, x, y, width, height) => super.copyTexSubImage2D(
       target,
       level,
-      xoffset,
-      yoffset,
+      xoffset + dx,
+      yoffset + dy,
       x,
       y,
       width,
       height)
+    if (this._readsPastDrawingBuffer(x, y, width, height)) {
+      this._copyClipped(x, y, width, height, (x, y) => copySub(0, 0, x, y, width, height), copySub)
+    } else {
+      copySub(0, 0, x, y, width, height)
+    }
+    this._endDrawingBufferRead(resolved)
+  }
+
+  copyTexSubImage3D (
+    target,
+    level,
+    xoffset, yoffset, zoffset,
+    x, y, width, height) {
+    x |= 0
+    y |= 0
+    width |= 0
+    height |= 0
+
+    const resolved = this._beginDrawingBufferRead()
+    const copySub = (dx, dy, x, y, width, height) => super.copyTexSubImage3D(
+      target | 0,
+      level | 0,
+      (xoffset | 0) + dx,
+      (yoffset | 0) + dy,
+      zoffset | 0,
+      x,
+      y,
+      width,
+      height)
+    if (this._readsPastDrawingBuffer(x, y, width, height)) {
+      this._copyClipped(x, y, width, height, (x, y) => copySub(0, 0, x, y, width, height), copySub)
+    } else {
+      copySub(0, 0, x, y, width, height)
+    }
+    this._endDrawingBufferRead(resolved)
+  }
+
+  blitFramebuffer (
+    srcX0, srcY0, srcX1, srcY1,
+    dstX0, dstY0, dstX1, dstY1,
+    mask, filter) {
+    let src = [srcX0 | 0, srcY0 | 0, srcX1 | 0, srcY1 | 0]
+    let dst = [dstX0 | 0, dstY0 | 0, dstX1 | 0, dstY1 | 0]
+
+    // Pixels past the drawing buffer are outside the read framebuffer, so the
+    // destination pixels they would map to are left alone
+    if (this._readsPastDrawingBuffer(
+      Math.min(src[0], src[2]), Math.min(src[1], src[3]),
+      Math.abs(src[2] - src[0]), Math.abs(src[3] - src[1]))) {
+      const x = clipBlitAxis(src[0], src[2], dst[0], dst[2], this.drawingBufferWidth)
+      const y = clipBlitAxis(src[1], src[3], dst[1], dst[3], this.drawingBufferHeight)
+      src = [x[0], y[0], x[1], y[1]]
+      dst = [x[2], y[2], x[3], y[3]]
+    }
+
+    this._writeDrawingBuffer()
+    const resolved = this._beginDrawingBufferRead()
+    super.blitFramebuffer(
+      src[0],
+      src[1],
+      src[2],
+      src[3],
+      dst[0],
+      dst[1],
+      dst[2],
+      dst[3],
+      mask | 0,
+      filter | 0)
+    this._endDrawingBufferRead(resolved)
   }
 
   cullFace (mode) {
@@ -1416,18 +1797,35 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     first |= 0
     count |= 0
 
+    this._writeDrawingBuffer()
     return super.drawArrays(mode, first, count)
   }
 
+  drawArraysInstanced (mode, first, count, instanceCount) {
+    this._writeDrawingBuffer()
+    return super.drawArraysInstanced(mode | 0, first | 0, count | 0, instanceCount | 0)
+  }
+
   drawElements (mode, count, type, ioffset) {
     mode |= 0
     count |= 0
     type |= 0
     ioffset |= 0
 
+    this._writeDrawingBuffer()
     return super.drawElements(mode, count, type, ioffset)
   }
 
+  drawElementsInstanced (mode, count, type, ioffset, instanceCount) {
+    this._writeDrawingBuffer()
+    return super.drawElementsInstanced(mode | 0, count | 0, type | 0, ioffset | 0, instanceCount | 0)
+  }
+
+  drawRangeElements (mode, start, end, count, type, ioffset) {
+    this._writeDrawingBuffer()
+    return super.drawRangeElements(mode | 0, start >>> 0, end >>> 0, count | 0, type | 0, ioffset | 0)
+  }
+
   enable (cap) {
     cap |= 0
     super.enable(cap)
@@ -1467,6 +1865,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     // Since we emulate the default framebuffer, we can't rely on ANGLE's validation.
+    if (!this._validFramebufferTarget(target)) {
+      this.setError(this.INVALID_ENUM)
+      return
+    }
     if (!this._getActiveFramebuffer(target)) {
       this.setError(this.INVALID_OPERATION)
       return
@@ -1499,6 +1901,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     // Since we emulate the default framebuffer, we can't rely on ANGLE's validation.
+    if (!this._validFramebufferTarget(target)) {
+      this.setError(this.INVALID_ENUM)
+      return
+    }
     if (!this._getActiveFramebuffer(target)) {
       this.setError(this.INVALID_OPERATION)
       return
@@ -1522,6 +1928,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     }
 
     // Since we emulate the default framebuffer, we can't rely on ANGLE's validation.
+    if (!this._validFramebufferTarget(target)) {
+      this.setError(this.INVALID_ENUM)
+      return
+    }
     if (!this._getActiveFramebuffer(target)) {
       this.setError(this.INVALID_OPERATION)
       return
@@ -1544,10 +1954,12 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (!program) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(program, WebGLProgram)) {
-      const info = super.getActiveAttrib(program._ | 0, index | 0)
+      this._resolveLink(program)
+      const info = program._attributes[index | 0]
       if (info) {
         return new WebGLActiveInfo(info)
       }
+      this.setError(this.INVALID_VALUE)
     }
     return null
   }
@@ -1558,10 +1970,12 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     } else if (!program) {
       this.setError(this.INVALID_VALUE)
     } else if (this._checkWrapper(program, WebGLProgram)) {
-      const info = super.getActiveUniform(program._ | 0, index | 0)
+      this._resolveLink(program)
+      const info = program._uniforms[index | 0]
       if (info) {
         return new WebGLActiveInfo(info)
       }
+      this.setError(this.INVALID_VALUE)
     }
     return null
   }
@@ -1696,21 +2110,22 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     pname |= 0
 
     // Since we emulate the default framebuffer, we can't rely on ANGLE's validation.
+    if (!this._validFramebufferTarget(target)) {
+      this.setError(this.INVALID_ENUM)
+      return null
+    }
     if (!this._getActiveFramebuffer(target)) {
       this.setError(this.INVALID_OPERATION)
       return null
     }
 
-    this._saveError()
+    // The native call returns null if the query raised an error
     const result = super.getFramebufferAttachmentParameter(target, attachment, pname)
-    const error = super.getError()
-    this._restoreError(error)
-
-    if (error) {
+    if (result === null) {
       return null
     }
 
-    if (error === this.NO_ERROR && pname === this.FRAMEBUFFER_ATTACHMENT_OBJECT_NAME) {
+    if (pname === this.FRAMEBUFFER_ATTACHMENT_OBJECT_NAME) {
       const type = super.getFramebufferAttachmentParameter(target, attachment, this.FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE)
       if (type === this.RENDERBUFFER) {
         return this._renderbuffers[result]
@@ -1732,8 +2147,16 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
           return program._pendingDelete
 
         case this.LINK_STATUS:
+          this._resolveLink(program)
           return program._linkStatus
 
+        case COMPLETION_STATUS_KHR:
+          if (!this._extensions.khr_parallel_shader_compile) {
+            break
+          }
+          return !program._linkPending ||
+            !!super.getProgramParameter(program._ | 0, pname)
+
         case this.VALIDATE_STATUS:
           return !!super.getProgramParameter(program._, pname)
 
@@ -1751,6 +2174,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(program)) {
       throw new TypeError('getProgramInfoLog(WebGLProgram)')
     } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       return program._linkInfoLog
     }
     return null
@@ -1797,7 +2221,14 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
         case this.DELETE_STATUS:
           return shader._pendingDelete
         case this.COMPILE_STATUS:
+          this._resolveCompile(shader)
           return shader._compileStatus
+        case COMPLETION_STATUS_KHR:
+          if (!this._extensions.khr_parallel_shader_compile) {
+            break
+          }
+          return !shader._compilePending ||
+            !!super.getShaderParameter(shader._ | 0, pname)
         case this.SHADER_TYPE:
           return shader._type
       }
@@ -1810,6 +2241,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     if (!checkObject(shader)) {
       throw new TypeError('getShaderInfoLog(WebGLShader)')
     } else if (this._checkWrapper(shader, WebGLShader)) {
+      this._resolveCompile(shader)
       return shader._compileInfo
     }
     return null
@@ -1855,6 +2287,22 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return null
   }
 
+  getTransformFeedbackVarying (program, index) {
+    if (!checkObject(program)) {
+      throw new TypeError('getTransformFeedbackVarying(WebGLProgram, GLuint)')
+    } else if (!program) {
+      this.setError(this.INVALID_VALUE)
+    } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
+      const info = program._transformFeedbackVaryings[index | 0]
+      if (info) {
+        return new WebGLActiveInfo(info)
+      }
+      this.setError(this.INVALID_VALUE)
+    }
+    return null
+  }
+
   getUniform (program, location) {
     if (!checkObject(program) ||
       !checkObject(location)) {
@@ -1914,75 +2362,45 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return null
   }
 
+  getUniformBlockIndex (program, name) {
+    if (!checkObject(program)) {
+      throw new TypeError('getUniformBlockIndex(WebGLProgram, String)')
+    } else if (!program) {
+      this.setError(this.INVALID_VALUE)
+    } else if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
+      const index = program._uniformBlocks.indexOf(name + '')
+      if (index >= 0) {
+        return index
+      }
+    }
+    return this.INVALID_INDEX
+  }
+
   getUniformLocation (program, name) {
     if (!checkObject(program)) {
       throw new TypeError('getUniformLocation(WebGLProgram, String)')
     }
 
     name += ''
+    if (this._checkValid(program, WebGLProgram) && this._checkOwns(program)) {
+      this._resolveLink(program)
+      const entry = program._linkStatus && program._uniformIndex.get(name)
+      if (entry) {
+        const result = new WebGLUniformLocation(entry.location, program, entry.info)
+        result._array = entry.array
+        return result
+      }
+    }
+
+    // Only names that are not active uniforms get here
     if (!isValidString(name)) {
       this.setError(this.INVALID_VALUE)
       return
     }
-
-    if (this._checkWrapper(program, WebGLProgram)) {
-      const loc = super.getUniformLocation(program._ | 0, name)
-      if (loc >= 0) {
-        let searchName = name
-        if (/\[\d+\]$/.test(name)) {
-          searchName = name.replace(/\[\d+\]$/, '[0]')
-        }
-
-        let info = null
-        for (let i = 0; i < program._uniforms.length; ++i) {
-          const infoItem = program._uniforms[i]
-          if (infoItem.name === searchName) {
-            info = {
-              size: infoItem.size,
-              type: infoItem.type,
-              name: infoItem.name
-            }
-          }
-        }
-        if (!info) {
-          return null
-        }
-
-        const result = new WebGLUniformLocation(
-          loc,
-          program,
-          info)
-
-        // handle array case
-        if (/\[0\]$/.test(name)) {
-          const baseName = name.replace(/\[0\]$/, '')
-          const arrayLocs = []
-
-          // if (offset < 0 || offset >= info.size) {
-          //   return null
-          // }
-
-          this._saveError()
-          for (let i = 0; this.getError() === this.NO_ERROR; ++i) {
-            const xloc = super.getUniformLocation(
-              program._ | 0,
-              baseName + '[' + i + ']')
-            if (this.getError() !== this.NO_ERROR || xloc < 0) {
-              break
-            }
-            arrayLocs.push(xloc)
-          }
-          this._restoreError(this.NO_ERROR)
-
-          result._array = arrayLocs
-        } else if (/\[(\d+)\]$/.test(name)) {
-          const offset = +(/\[(\d+)\]$/.exec(name))[1]
-          if (offset < 0 || offset >= info.size) {
-            return null
-          }
-        }
-        return result
-      }
+    if (this._checkWrapper(program, WebGLProgram) && !program._linkStatus) {
+      // Let GL raise the error for programs that did not link
+      super.getUniformLocation(program._ | 0, name)
     }
     return null
   }
@@ -2108,19 +2526,42 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       throw new TypeError('linkProgram(WebGLProgram)')
     }
     if (this._checkWrapper(program, WebGLProgram)) {
+      this._resolveLink(program)
       program._linkCount += 1
-      program._attributes = []
-      const prevError = this.getError()
-      super.linkProgram(program._ | 0)
-      const error = this.getError()
+      const error = super.linkProgram(program._ | 0)
       if (error === this.NO_ERROR) {
-        program._linkStatus = this._fixupLink(program)
+        program._linkPending = true
       }
-      this.getError()
-      this.setError(prevError || error)
     }
   }
 
+  // Resolves with the link status once the driver has finished linking,
+  // without blocking the event loop in between
+  linkProgramAsync (program) {
+    this.linkProgram(program)
+    return this._whenComplete(program, 'link').then(() => {
+      this._resolveLink(program)
+      return program._linkStatus
+    })
+  }
+
+  // Polls COMPLETION_STATUS_KHR only if the user enabled KHR_parallel_shader_compile.
+  // ANGLE rejects the query otherwise, and enabling it here would change what the
+  // context accepts. Without it the promise resolves right away and reading the
+  // status waits for the driver.
+  _whenComplete (object, kind) {
+    const pending = kind === 'compile' ? '_compilePending' : '_linkPending'
+    if (!object || !object[pending] || !this._extensions.khr_parallel_shader_compile) {
+      return Promise.resolve()
+    }
+    const query = kind === 'compile' ? super.getShaderParameter : super.getProgramParameter
+    return pollUntil(() => {
+      return !object[pending] ||
+        object._pendingDelete ||
+        !!query.call(this, object._ | 0, COMPLETION_STATUS_KHR)
+    })
+  }
+
   pixelStorei (pname, param) {
     pname |= 0
     param |= 0
@@ -2157,20 +2598,148 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     return super.polygonOffset(+factor, +units)
   }
 
-  readPixels (x, y, width, height, format, type, pixels) {
+  readPixels (x, y, width, height, format, type, pixels, options) {
     x |= 0
     y |= 0
     width |= 0
     height |= 0
 
-    super.readPixels(
-      x,
-      y,
-      width,
-      height,
-      format,
-      type,
-      pixels)
+    const readback = readbackArgs(options)
+    const resolved = this._beginDrawingBufferRead()
+    try {
+      if (width > 0 && height > 0 && isTypedArray(pixels) &&
+        this._readsPastDrawingBuffer(x, y, width, height)) {
+        this._readPixelsClipped(x, y, width, height, format, type, pixels, readback)
+      } else if (!readback) {
+        super.readPixels(
+          x,
+          y,
+          width,
+          height,
+          format,
+          type,
+          pixels)
+      } else {
+        super.readPixels(x, y, width, height, format, type, pixels, ...readback)
+      }
+    } finally {
+      this._endDrawingBufferRead(resolved)
+    }
+  }
+
+  // Reads into a pixel pack buffer and resolves once GL has written the pixels,
+  // so the pipeline does not have to drain first. Resolves with `pixels`, or a
+  // new Uint8Array if it is omitted. If `pixels` does not match `type` or is too
+  // small, raises INVALID_OPERATION and rejects without reading. WebGL 1
+  // contexts read synchronously.
+  readPixelsAsync (x, y, width, height, format, type, pixels, options) {
+    x |= 0
+    y |= 0
+    width |= 0
+    height |= 0
+    format |= 0
+    type |= 0
+    if (pixels !== undefined && pixels !== null && !isTypedArray(pixels)) {
+      throw new TypeError('readPixelsAsync(GLint, GLint, GLint, GLint, GLenum, GLenum, ArrayBufferView)')
+    }
+
+    const readback = readbackArgs(options)
+    if (pixels && !checkPixelArrayType(pixels, type)) {
+      this.setError(this.INVALID_OPERATION)
+      return Promise.reject(new TypeError('readPixelsAsync: pixels do not match type'))
+    }
+
+    // The native side checks the destination is large enough before it starts the read
+    let id = 0
+    if (this._isWebGL2() && !this._readsPastDrawingBuffer(x, y, width, height)) {
+      const resolved = this._beginDrawingBufferRead()
+      id = super._readPixelsAsync(
+        x,
+        y,
+        width,
+        height,
+        format,
+        type,
+        pixels ? pixels.byteLength : -1,
+        ...(readback || []))
+      this._endDrawingBufferRead(resolved)
+    }
+    if (id < 0) {
+      return Promise.reject(new RangeError('readPixelsAsync: pixels is too small'))
+    }
+    if (!id) {
+      if (!pixels && readback) {
+        pixels = new Uint8Array(Math.max(0, width * height * READBACK_PIXEL_SIZES[readback[0]]))
+      } else if (!pixels) {
+        const pixelSize = typeSize(type) ? formatSize(format) * typeSize(type) : 2
+        const rowStride = Math.ceil(width * pixelSize / this._packAlignment) * this._packAlignment
+        pixels = new Uint8Array(Math.max(0, rowStride * (height - 1) + width * pixelSize))
+      }
+      this.readPixels(x, y, width, height, format, type, pixels, options)
+      return Promise.resolve(pixels)
+    }
+
+    return pollUntil(() => super._readPixelsAsyncPoll(id)).then(() => {
+      const result = super._readPixelsAsyncFinish(id, pixels || undefined)
+      if (!result) {
+        throw new Error('readPixelsAsync was cancelled by a context reset')
+      }
+      return result
+    })
+  }
+
+  // Encodes a rectangle of the read framebuffer as a PNG on the libuv threadpool
+  // and resolves with a Buffer. The pixels go from GL straight to the encoder.
+  encodeFrame (options) {
+    options = options || {}
+    const format = options.format === undefined ? 'png' : options.format
+    if (format !== 'png') {
+      return Promise.reject(new TypeError('encodeFrame: unsupported format ' + format))
+    }
+    if (options.quality !== undefined && !(options.quality >= 0 && options.quality <= 1)) {
+      return Promise.reject(new RangeError('encodeFrame: quality must be between 0 and 1'))
+    }
+    const level = options.compressionLevel === undefined ? 6 : options.compressionLevel
+    if (!(level >= 0 && level <= 9)) {
+      return Promise.reject(new RangeError('encodeFrame: compressionLevel must be between 0 and 9'))
+    }
+    const rect = options.rect || {
+      x: 0,
+      y: 0,
+      width: this.drawingBufferWidth,
+      height: this.drawingBufferHeight
+    }
+
+    // The drawing buffer follows the context attributes, framebuffers are read as straight RGBA
+    const attributes = this._contextAttributes
+    const drawingBuffer = !this._activeFramebuffers.read
+    const alpha = !drawingBuffer || attributes.alpha
+    const unpremultiply = drawingBuffer && attributes.alpha && attributes.premultipliedAlpha
+
+    const x = rect.x | 0
+    const y = rect.y | 0
+    const width = rect.width | 0
+    const height = rect.height | 0
+    const clipped = this._readsPastDrawingBuffer(x, y, width, height)
+
+    return new Promise((resolve, reject) => {
+      const resolved = this._beginDrawingBufferRead()
+      const queued = super._encodeFrame(
+        x,
+        y,
+        width,
+        height,
+        clipped ? this.drawingBufferWidth : x + width,
+        clipped ? this.drawingBufferHeight : y + height,
+        alpha,
+        unpremultiply,
+        level | 0,
+        (err, image) => err ? reject(err) : resolve(image))
+      this._endDrawingBufferRead(resolved)
+      if (!queued) {
+        reject(new Error('encodeFrame: could not read the framebuffer'))
+      }
+    })
   }
 
   renderbufferStorage (
@@ -2183,7 +2752,10 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     width |= 0
     height |= 0
 
-    if (target !== this.RENDERBUFFER) {
+    // GL_OES_rgb8_rgba8, which antialiased WebGL 1 contexts enable for their
+    // drawing buffer, is not a WebGL 1 extension
+    if (target !== this.RENDERBUFFER ||
+      (!this._isWebGL2() && (internalFormat === RGB8 || internalFormat === RGBA8))) {
       this.setError(this.INVALID_ENUM)
       return
     }
@@ -2194,14 +2766,11 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       return
     }
 
-    this._saveError()
-    super.renderbufferStorage(
+    const error = super.renderbufferStorage(
       target,
       internalFormat,
       width,
       height)
-    const error = this.getError()
-    this._restoreError(error)
     if (error !== this.NO_ERROR) {
       return
     }
@@ -2329,8 +2898,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
     const data = convertPixels(pixels)
 
     // Need to check for out of memory error
-    this._saveError()
-    super.texImage2D(
+    const error = super.texImage2D(
       target,
       level,
       internalFormat,
@@ -2340,8 +2908,6 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       format,
       type,
       data)
-    const error = this.getError()
-    this._restoreError(error)
     if (error === this.NO_ERROR) {
       const texture = this._getTexImage(target)
       texture._format = format
@@ -2393,6 +2959,84 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       data)
   }
 
+  // Streams the pixels into a pixel unpack buffer off the main thread and
+  // resolves once the upload has been handed to GL. The upload takes effect
+  // before any later draw, clear, read or texture call, which wait for it if
+  // the pixels are still being copied. The pixels must not be modified until
+  // the promise settles. Invalid arguments raise the error texSubImage2D
+  // would, and the promise rejects if the upload fails. WebGL 1 contexts, and
+  // uploads that cannot be staged, upload synchronously.
+  texSubImage2DAsync (
+    target,
+    level,
+    xoffset,
+    yoffset,
+    width,
+    height,
+    format,
+    type,
+    pixels) {
+    if (arguments.length === 7) {
+      pixels = format
+      type = height
+      format = width
+
+      pixels = extractImageData(pixels)
+
+      if (pixels == null) {
+        throw new TypeError('texSubImage2DAsync(GLenum, GLint, GLint, GLint, GLenum, GLenum, ImageData | HTMLImageElement | HTMLCanvasElement | HTMLVideoElement)')
+      }
+
+      width = pixels.width
+      height = pixels.height
+      pixels = pixels.data
+    }
+
+    if (typeof pixels !== 'object') {
+      throw new TypeError('texSubImage2DAsync(GLenum, GLint, GLint, GLint, GLint, GLint, GLenum, GLenum, Uint8Array)')
+    }
+
+    target |= 0
+    const data = convertPixels(pixels)
+    const texture = target === this.TEXTURE_2D || validCubeTarget(target)
+      ? this._getTexImage(target)
+      : null
+
+    if (this._isWebGL2() && data && texture &&
+      super._texSubImage2DAsync(
+        target,
+        level | 0,
+        xoffset | 0,
+        yoffset | 0,
+        width | 0,
+        height | 0,
+        format | 0,
+        type | 0,
+        data,
+        texture._ | 0,
+        this._uploadCallback())) {
+      return new Promise((resolve, reject) => this._pendingUploads.push({ resolve, reject }))
+    }
+
+    const error = super.texSubImage2D(target, level, xoffset, yoffset, width, height, format, type, data)
+    return uploadResult(error)
+  }
+
+  // The native side passes the error of each of the oldest pending uploads
+  // it issued
+  _uploadCallback () {
+    if (!this._pendingUploads) {
+      const pending = this._pendingUploads = []
+      this._uploadsIssued = function (errors) {
+        for (const error of errors) {
+          const { resolve, reject } = pending.shift()
+          uploadResult(error).then(resolve, reject)
+        }
+      }
+    }
+    return this._uploadsIssued
+  }
+
   texParameterf (target, pname, param) {
     target |= 0
     pname |= 0
@@ -2447,13 +3091,11 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
 
   validateProgram (program) {
     if (this._checkWrapper(program, WebGLProgram)) {
-      super.validateProgram(program._ | 0)
-      const error = this.getError()
+      this._resolveLink(program)
+      const error = super.validateProgram(program._ | 0)
       if (error === this.NO_ERROR) {
         program._linkInfoLog = super.getProgramInfoLog(program._ | 0)
       }
-      this.getError()
-      this.setError(error)
     }
   }
 
@@ -2537,6 +3179,14 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
       super.createTexture(),
       super.createRenderbuffer())
 
+    if (this._samples) {
+      const drawingBuffer = this._drawingBuffer
+      drawingBuffer._samples = this._samples
+      drawingBuffer._framebuffer = super.createFramebuffer()
+      drawingBuffer._multisampleColor = super.createRenderbuffer()
+    }
+    this._drawingBuffer._reuse = this._reuseDrawingBuffer
+
     this._resizeDrawingBuffer(width, height)
   }
 
@@ -2617,11 +3267,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform1fv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform1fv', 1, 'f')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform1f(loc, value[i])
-      }
+      super.uniform1fv(location._ | 0, uniformArrayData(Float32Array, value, location._array.length))
       return
     }
     super.uniform1f(location._ | 0, value[0])
@@ -2635,11 +3281,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform1iv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform1iv', 1, 'i')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform1i(loc, value[i])
-      }
+      super.uniform1iv(location._ | 0, uniformArrayData(Int32Array, value, location._array.length))
       return
     }
     this.uniform1i(location, value[0])
@@ -2653,11 +3295,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform2fv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform2fv', 2, 'f')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 2 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform2f(loc, value[2 * i], value[(2 * i) + 1])
-      }
+      super.uniform2fv(location._ | 0, uniformArrayData(Float32Array, value, location._array.length * 2))
       return
     }
     super.uniform2f(location._ | 0, value[0], value[1])
@@ -2671,11 +3309,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform2iv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform2iv', 2, 'i')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 2 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform2i(loc, value[2 * i], value[2 * i + 1])
-      }
+      super.uniform2iv(location._ | 0, uniformArrayData(Int32Array, value, location._array.length * 2))
       return
     }
     this.uniform2i(location, value[0], value[1])
@@ -2689,11 +3323,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform3fv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform3fv', 3, 'f')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 3 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform3f(loc, value[3 * i], value[3 * i + 1], value[3 * i + 2])
-      }
+      super.uniform3fv(location._ | 0, uniformArrayData(Float32Array, value, location._array.length * 3))
       return
     }
     super.uniform3f(location._ | 0, value[0], value[1], value[2])
@@ -2707,11 +3337,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform3iv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform3iv', 3, 'i')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 3 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform3i(loc, value[3 * i], value[3 * i + 1], value[3 * i + 2])
-      }
+      super.uniform3iv(location._ | 0, uniformArrayData(Int32Array, value, location._array.length * 3))
       return
     }
     this.uniform3i(location, value[0], value[1], value[2])
@@ -2725,11 +3351,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform4fv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform4fv', 4, 'f')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 4 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform4f(loc, value[4 * i], value[4 * i + 1], value[4 * i + 2], value[4 * i + 3])
-      }
+      super.uniform4fv(location._ | 0, uniformArrayData(Float32Array, value, location._array.length * 4))
       return
     }
     super.uniform4f(location._ | 0, value[0], value[1], value[2], value[3])
@@ -2743,11 +3365,7 @@ class WebGLRenderingContextHelper extends NativeWebGLRenderingContext {
   uniform4iv (location, value) {
     if (!this._checkUniformValueValid(location, value, 'uniform4iv', 4, 'i')) return
     if (location._array) {
-      const locs = location._array
-      for (let i = 0; i < locs.length && 4 * i < value.length; ++i) {
-        const loc = locs[i]
-        super.uniform4i(loc, value[4 * i], value[4 * i + 1], value[4 * i + 2], value[4 * i + 3])
-      }
+      super.uniform4iv(location._ | 0, uniformArrayData(Int32Array, value, location._array.length * 4))
       return
     }
     this.uniform4i(location, value[0], value[1], value[2], value[3])
@@ -2920,4 +3538,10 @@ class WebGLRenderingContext extends WebGLRenderingContextHelper {}
 
 class WebGL2RenderingContext extends WebGLRenderingContextHelper {}
 
+// WebGL2 enums are shared through the prototype instead of being defined on every context
+for (const [key, value] of Object.entries(gl2)) {
+  Object.defineProperty(WebGL2RenderingContext.prototype, key, { value, enumerable: true })
+  Object.defineProperty(WebGL2RenderingContext, key, { value, enumerable: true })
+}
+
 module.exports = { WebGLRenderingContext, WebGL2RenderingContext, wrapContext }
@@ -9,6 +9,7 @@ class WebGLShader extends Linkable {
     this._source = ''
     this._compileStatus = false
     this._compileInfo = ''
+    this._compilePending = false
   }
 
   _performDelete () {
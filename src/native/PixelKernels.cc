@@ -0,0 +1,778 @@
+#include "PixelKernels.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_KERNELS_SSE2 1
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXEL_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define PIXEL_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// round(value * alpha / 255) for value, alpha in [0, 255], without a divide.
+inline uint8_t MulDiv255(uint32_t value, uint32_t alpha) {
+  uint32_t product = value * alpha + 128;
+  return static_cast<uint8_t>((product + (product >> 8)) >> 8);
+}
+
+template <typename T> inline T Load(const uint8_t *src) {
+  T value;
+  memcpy(&value, src, sizeof(T));
+  return value;
+}
+
+template <typename T> inline void Store(uint8_t *dst, T value) { memcpy(dst, &value, sizeof(T)); }
+
+float HalfToFloat(uint16_t half) {
+  uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 0x1f) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    exponent = 113;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      --exponent;
+    }
+    bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+  }
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t exponent = (bits >> 23) & 0xff;
+  uint32_t mantissa = bits & 0x7fffff;
+  if (exponent == 0xff) {
+    return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+  }
+  int halfExponent = static_cast<int>(exponent) - 112;
+  if (halfExponent >= 0x1f) {
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+
+  // Round to nearest even, which may carry into the exponent.
+  uint32_t half, remainder, midpoint;
+  if (halfExponent <= 0) {
+    if (halfExponent < -10) {
+      return static_cast<uint16_t>(sign);
+    }
+    uint32_t shift = 14 - halfExponent;
+    mantissa |= 0x800000;
+    half = mantissa >> shift;
+    remainder = mantissa & ((1u << shift) - 1);
+    midpoint = 1u << (shift - 1);
+  } else {
+    half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    remainder = mantissa & 0x1fff;
+    midpoint = 0x1000;
+  }
+  if (remainder > midpoint || (remainder == midpoint && (half & 1))) {
+    ++half;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+// 8-bit kernels. `Channels` is the number of bytes per pixel, alpha is always the last one.
+
+template <size_t Channels>
+void PremultiplyScalar8(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += Channels, dst += Channels) {
+    uint8_t alpha = src[Channels - 1];
+    for (size_t c = 0; c < Channels - 1; ++c) {
+      dst[c] = MulDiv255(src[c], alpha);
+    }
+    dst[Channels - 1] = alpha;
+  }
+}
+
+#if PIXEL_KERNELS_SSE2
+
+// The pixels are widened to 16-bit lanes, so every lane is multiplied by the alpha lane of its
+// pixel, or by 255 if it is the alpha lane itself.
+template <size_t Channels> struct Sse2Layout;
+
+template <> struct Sse2Layout<4> {
+  static constexpr int kShuffle = 0xff; // _MM_SHUFFLE(3, 3, 3, 3)
+  static __m128i AlphaLanes() { return _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0); }
+};
+
+template <> struct Sse2Layout<2> {
+  static constexpr int kShuffle = 0xf5; // _MM_SHUFFLE(3, 3, 1, 1)
+  static __m128i AlphaLanes() { return _mm_set_epi16(255, 0, 255, 0, 255, 0, 255, 0); }
+};
+
+template <size_t Channels> inline __m128i PremultiplySse2Lanes(__m128i lanes, __m128i alphaLanes) {
+  const int shuffle = Sse2Layout<Channels>::kShuffle;
+  __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lanes, shuffle), shuffle);
+  __m128i product = _mm_mullo_epi16(lanes, _mm_or_si128(alpha, alphaLanes));
+  product = _mm_add_epi16(product, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+}
+
+template <size_t Channels>
+void PremultiplySse2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alphaLanes = Sse2Layout<Channels>::AlphaLanes();
+  size_t bytes = pixels * Channels;
+  size_t i = 0;
+  for (; i + 16 <= bytes; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = PremultiplySse2Lanes<Channels>(_mm_unpacklo_epi8(block, zero), alphaLanes);
+    __m128i hi = PremultiplySse2Lanes<Channels>(_mm_unpackhi_epi8(block, zero), alphaLanes);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  PremultiplyScalar8<Channels>(src + i, dst + i, (bytes - i) / Channels);
+}
+
+#if PIXEL_KERNELS_AVX2
+
+template <size_t Channels>
+__attribute__((target("avx2"))) void PremultiplyAvx2(const uint8_t *src, uint8_t *dst,
+                                                      size_t pixels) {
+  const int shuffle = Sse2Layout<Channels>::kShuffle;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m128i alphaLanes128 = Sse2Layout<Channels>::AlphaLanes();
+  const __m256i alphaLanes = _mm256_broadcastsi128_si256(alphaLanes128);
+  const __m256i bias = _mm256_set1_epi16(128);
+  size_t bytes = pixels * Channels;
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    // Unpack and pack both work within 128-bit halves, so the pixel order is preserved.
+    __m256i halves[2] = {_mm256_unpacklo_epi8(block, zero), _mm256_unpackhi_epi8(block, zero)};
+    for (__m256i &lanes : halves) {
+      __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lanes, shuffle), shuffle);
+      __m256i product = _mm256_mullo_epi16(lanes, _mm256_or_si256(alpha, alphaLanes));
+      product = _mm256_add_epi16(product, bias);
+      lanes = _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_packus_epi16(halves[0], halves[1]));
+  }
+  PremultiplySse2<Channels>(src + i, dst + i, (bytes - i) / Channels);
+}
+
+bool HasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif // PIXEL_KERNELS_AVX2
+#endif // PIXEL_KERNELS_SSE2
+
+#if PIXEL_KERNELS_NEON
+
+inline uint8x8_t MulDiv255Neon(uint8x8_t value, uint8x8_t alpha) {
+  uint16x8_t product = vmull_u8(value, alpha);
+  return vrshrn_n_u16(vrsraq_n_u16(product, product, 8), 8);
+}
+
+void PremultiplyNeonRGBA(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    uint8x8x4_t block = vld4_u8(src + i * 4);
+    block.val[0] = MulDiv255Neon(block.val[0], block.val[3]);
+    block.val[1] = MulDiv255Neon(block.val[1], block.val[3]);
+    block.val[2] = MulDiv255Neon(block.val[2], block.val[3]);
+    vst4_u8(dst + i * 4, block);
+  }
+  PremultiplyScalar8<4>(src + i * 4, dst + i * 4, pixels - i);
+}
+
+void PremultiplyNeonLA(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    uint8x8x2_t block = vld2_u8(src + i * 2);
+    block.val[0] = MulDiv255Neon(block.val[0], block.val[1]);
+    vst2_u8(dst + i * 2, block);
+  }
+  PremultiplyScalar8<2>(src + i * 2, dst + i * 2, pixels - i);
+}
+
+#endif // PIXEL_KERNELS_NEON
+
+struct Kernels8 {
+  PixelKernels::RowKernel rgba;
+  PixelKernels::RowKernel luminanceAlpha;
+  const char *level;
+};
+
+const Kernels8 &SelectKernels8() {
+  static const Kernels8 kernels = []() -> Kernels8 {
+#if PIXEL_KERNELS_AVX2
+    if (HasAvx2()) {
+      return {PremultiplyAvx2<4>, PremultiplyAvx2<2>, "avx2"};
+    }
+#endif
+#if PIXEL_KERNELS_SSE2
+    return {PremultiplySse2<4>, PremultiplySse2<2>, "sse2"};
+#elif PIXEL_KERNELS_NEON
+    return {PremultiplyNeonRGBA, PremultiplyNeonLA, "neon"};
+#else
+    return {PremultiplyScalar8<4>, PremultiplyScalar8<2>, "scalar"};
+#endif
+  }();
+  return kernels;
+}
+
+void PremultiplyRGBA8(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  SelectKernels8().rgba(src, dst, pixels);
+}
+
+void PremultiplyLuminanceAlpha8(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  SelectKernels8().luminanceAlpha(src, dst, pixels);
+}
+
+// Readback kernels. These take RGBA/UNSIGNED_BYTE pixels as read from GL and repack them.
+
+// Colors are divided by alpha with an exact multiply by ceil(2^24 / alpha), see Unpremultiply().
+const uint32_t *UnpremultiplyReciprocals() {
+  static const struct Table {
+    uint32_t values[256];
+    Table() {
+      values[0] = 0;
+      for (uint32_t alpha = 1; alpha < 256; ++alpha) {
+        values[alpha] = ((1u << 24) + alpha - 1) / alpha;
+      }
+    }
+  } table;
+  return table.values;
+}
+
+// min(255, round(value * 255 / alpha)), or 0 for alpha 0.
+inline uint8_t Unpremultiply(uint32_t value, uint32_t alpha, const uint32_t *reciprocals) {
+  uint64_t quotient = (static_cast<uint64_t>(value * 255 + alpha / 2) * reciprocals[alpha]) >> 24;
+  return static_cast<uint8_t>(quotient > 255 ? 255 : quotient);
+}
+
+// BT.601 luma with weights summing to 256, so opaque white stays 255.
+inline uint8_t Luma(uint32_t r, uint32_t g, uint32_t b) {
+  return static_cast<uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+void UnpremultiplyScalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  const uint32_t *reciprocals = UnpremultiplyReciprocals();
+  for (size_t i = 0; i < pixels; ++i, src += 4, dst += 4) {
+    uint32_t alpha = src[3];
+    dst[0] = Unpremultiply(src[0], alpha, reciprocals);
+    dst[1] = Unpremultiply(src[1], alpha, reciprocals);
+    dst[2] = Unpremultiply(src[2], alpha, reciprocals);
+    dst[3] = static_cast<uint8_t>(alpha);
+  }
+}
+
+void SwizzleBGRAScalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 4, dst += 4) {
+    uint8_t r = src[0];
+    dst[0] = src[2];
+    dst[1] = src[1];
+    dst[2] = r;
+    dst[3] = src[3];
+  }
+}
+
+void StripAlphaScalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 4, dst += 3) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+  }
+}
+
+void GrayScalar(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 4) {
+    dst[i] = Luma(src[0], src[1], src[2]);
+  }
+}
+
+#if PIXEL_KERNELS_SSE2
+
+// Blocks that are entirely opaque or entirely transparent are the common case and skip the
+// per-pixel divide.
+void UnpremultiplySse2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  const __m128i ones = _mm_set1_epi8(-1);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+    if ((_mm_movemask_epi8(_mm_cmpeq_epi8(block, ones)) & 0x8888) == 0x8888) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), block);
+    } else if ((_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero)) & 0x8888) == 0x8888) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), zero);
+    } else {
+      UnpremultiplyScalar(src + i * 4, dst + i * 4, 4);
+    }
+  }
+  UnpremultiplyScalar(src + i * 4, dst + i * 4, pixels - i);
+}
+
+inline __m128i SwapRedBlueSse2(__m128i block) {
+  const __m128i greenAlpha = _mm_set1_epi32(static_cast<int>(0xff00ff00));
+  const __m128i low = _mm_set1_epi32(0xff);
+  __m128i red = _mm_slli_epi32(_mm_and_si128(block, low), 16);
+  __m128i blue = _mm_and_si128(_mm_srli_epi32(block, 16), low);
+  return _mm_or_si128(_mm_and_si128(block, greenAlpha), _mm_or_si128(red, blue));
+}
+
+void SwizzleBGRASse2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 4 <= pixels; i += 4) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4), SwapRedBlueSse2(block));
+  }
+  SwizzleBGRAScalar(src + i * 4, dst + i * 4, pixels - i);
+}
+
+// Luma of four pixels, one per 32-bit lane. Red/blue and green/alpha are split into 16-bit pairs
+// so a single multiply-add weighs each pair.
+inline __m128i LumaSse2(__m128i block) {
+  const __m128i mask = _mm_set1_epi32(0x00ff00ff);
+  __m128i redBlue = _mm_and_si128(block, mask);
+  __m128i greenAlpha = _mm_and_si128(_mm_srli_epi32(block, 8), mask);
+  __m128i sum = _mm_add_epi32(_mm_madd_epi16(redBlue, _mm_set1_epi32((29 << 16) | 77)),
+                              _mm_madd_epi16(greenAlpha, _mm_set1_epi32(150)));
+  return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+void GraySse2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    const __m128i *in = reinterpret_cast<const __m128i *>(src + i * 4);
+    __m128i lo = _mm_packs_epi32(LumaSse2(_mm_loadu_si128(in)), LumaSse2(_mm_loadu_si128(in + 1)));
+    __m128i hi =
+        _mm_packs_epi32(LumaSse2(_mm_loadu_si128(in + 2)), LumaSse2(_mm_loadu_si128(in + 3)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  GrayScalar(src + i * 4, dst + i, pixels - i);
+}
+
+#if PIXEL_KERNELS_AVX2
+
+// Stripping alpha needs a byte shuffle, which SSE2 does not have.
+__attribute__((target("ssse3"))) void StripAlphaSsse3(const uint8_t *src, uint8_t *dst,
+                                                       size_t pixels) {
+  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    const __m128i *in = reinterpret_cast<const __m128i *>(src + i * 4);
+    __m128i *out = reinterpret_cast<__m128i *>(dst + i * 3);
+    __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(in), shuffle);
+    __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(in + 1), shuffle);
+    __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(in + 2), shuffle);
+    __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(in + 3), shuffle);
+    // Each shuffled block holds 12 bytes, stitch four of them into three 16 byte stores
+    _mm_storeu_si128(out, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+    _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+    _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+  }
+  StripAlphaScalar(src + i * 4, dst + i * 3, pixels - i);
+}
+
+__attribute__((target("avx2"))) void UnpremultiplyAvx2(const uint8_t *src, uint8_t *dst,
+                                                        size_t pixels) {
+  const __m256i ones = _mm256_set1_epi8(-1);
+  const __m256i zero = _mm256_setzero_si256();
+  const uint32_t alphaBits = 0x88888888u;
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+    uint32_t opaque = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, ones)));
+    uint32_t clear = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, zero)));
+    if ((opaque & alphaBits) == alphaBits) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), block);
+    } else if ((clear & alphaBits) == alphaBits) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), zero);
+    } else {
+      UnpremultiplyScalar(src + i * 4, dst + i * 4, 8);
+    }
+  }
+  UnpremultiplySse2(src + i * 4, dst + i * 4, pixels - i);
+}
+
+__attribute__((target("avx2"))) void SwizzleBGRAAvx2(const uint8_t *src, uint8_t *dst,
+                                                      size_t pixels) {
+  const __m256i greenAlpha = _mm256_set1_epi32(static_cast<int>(0xff00ff00));
+  const __m256i low = _mm256_set1_epi32(0xff);
+  size_t i = 0;
+  for (; i + 8 <= pixels; i += 8) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+    __m256i red = _mm256_slli_epi32(_mm256_and_si256(block, low), 16);
+    __m256i blue = _mm256_and_si256(_mm256_srli_epi32(block, 16), low);
+    block = _mm256_or_si256(_mm256_and_si256(block, greenAlpha), _mm256_or_si256(red, blue));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4), block);
+  }
+  SwizzleBGRASse2(src + i * 4, dst + i * 4, pixels - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i LumaAvx2(__m256i block) {
+  const __m256i mask = _mm256_set1_epi32(0x00ff00ff);
+  __m256i redBlue = _mm256_and_si256(block, mask);
+  __m256i greenAlpha = _mm256_and_si256(_mm256_srli_epi32(block, 8), mask);
+  __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(redBlue, _mm256_set1_epi32((29 << 16) | 77)),
+                                 _mm256_madd_epi16(greenAlpha, _mm256_set1_epi32(150)));
+  return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+}
+
+__attribute__((target("avx2"))) void GrayAvx2(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  // Packing works within 128-bit halves, which interleaves groups of four pixels
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  size_t i = 0;
+  for (; i + 32 <= pixels; i += 32) {
+    const __m256i *in = reinterpret_cast<const __m256i *>(src + i * 4);
+    __m256i lo = _mm256_packs_epi32(LumaAvx2(_mm256_loadu_si256(in)),
+                                    LumaAvx2(_mm256_loadu_si256(in + 1)));
+    __m256i hi = _mm256_packs_epi32(LumaAvx2(_mm256_loadu_si256(in + 2)),
+                                    LumaAvx2(_mm256_loadu_si256(in + 3)));
+    __m256i gray = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), gray);
+  }
+  GraySse2(src + i * 4, dst + i, pixels - i);
+}
+
+bool HasSsse3() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}
+
+#endif // PIXEL_KERNELS_AVX2
+#endif // PIXEL_KERNELS_SSE2
+
+#if PIXEL_KERNELS_NEON
+
+inline uint8_t HorizontalMin(uint8x16_t lanes) {
+  uint8x8_t min = vpmin_u8(vget_low_u8(lanes), vget_high_u8(lanes));
+  min = vpmin_u8(min, min);
+  min = vpmin_u8(min, min);
+  return vget_lane_u8(vpmin_u8(min, min), 0);
+}
+
+inline uint8_t HorizontalMax(uint8x16_t lanes) {
+  uint8x8_t max = vpmax_u8(vget_low_u8(lanes), vget_high_u8(lanes));
+  max = vpmax_u8(max, max);
+  max = vpmax_u8(max, max);
+  return vget_lane_u8(vpmax_u8(max, max), 0);
+}
+
+void UnpremultiplyNeon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x4_t block = vld4q_u8(src + i * 4);
+    if (HorizontalMin(block.val[3]) == 255) {
+      vst4q_u8(dst + i * 4, block);
+    } else if (HorizontalMax(block.val[3]) == 0) {
+      memset(dst + i * 4, 0, 64);
+    } else {
+      UnpremultiplyScalar(src + i * 4, dst + i * 4, 16);
+    }
+  }
+  UnpremultiplyScalar(src + i * 4, dst + i * 4, pixels - i);
+}
+
+void SwizzleBGRANeon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x4_t block = vld4q_u8(src + i * 4);
+    uint8x16_t red = block.val[0];
+    block.val[0] = block.val[2];
+    block.val[2] = red;
+    vst4q_u8(dst + i * 4, block);
+  }
+  SwizzleBGRAScalar(src + i * 4, dst + i * 4, pixels - i);
+}
+
+void StripAlphaNeon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x4_t block = vld4q_u8(src + i * 4);
+    uint8x16x3_t rgb = {{block.val[0], block.val[1], block.val[2]}};
+    vst3q_u8(dst + i * 3, rgb);
+  }
+  StripAlphaScalar(src + i * 4, dst + i * 3, pixels - i);
+}
+
+inline uint8x8_t LumaNeon(uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+  uint16x8_t sum = vmull_u8(r, vdup_n_u8(77));
+  sum = vmlal_u8(sum, g, vdup_n_u8(150));
+  sum = vmlal_u8(sum, b, vdup_n_u8(29));
+  return vrshrn_n_u16(sum, 8);
+}
+
+void GrayNeon(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  size_t i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    uint8x16x4_t block = vld4q_u8(src + i * 4);
+    uint8x8_t lo = LumaNeon(vget_low_u8(block.val[0]), vget_low_u8(block.val[1]),
+                            vget_low_u8(block.val[2]));
+    uint8x8_t hi = LumaNeon(vget_high_u8(block.val[0]), vget_high_u8(block.val[1]),
+                            vget_high_u8(block.val[2]));
+    vst1q_u8(dst + i, vcombine_u8(lo, hi));
+  }
+  GrayScalar(src + i * 4, dst + i, pixels - i);
+}
+
+#endif // PIXEL_KERNELS_NEON
+
+struct PackKernels8 {
+  PixelKernels::RowKernel unpremultiply;
+  PixelKernels::RowKernel bgra;
+  PixelKernels::RowKernel rgb;
+  PixelKernels::RowKernel gray;
+};
+
+const PackKernels8 &SelectPackKernels8() {
+  static const PackKernels8 kernels = []() -> PackKernels8 {
+#if PIXEL_KERNELS_AVX2
+    PixelKernels::RowKernel rgb = HasSsse3() ? StripAlphaSsse3 : StripAlphaScalar;
+    if (HasAvx2()) {
+      return {UnpremultiplyAvx2, SwizzleBGRAAvx2, rgb, GrayAvx2};
+    }
+    return {UnpremultiplySse2, SwizzleBGRASse2, rgb, GraySse2};
+#elif PIXEL_KERNELS_SSE2
+    return {UnpremultiplySse2, SwizzleBGRASse2, StripAlphaScalar, GraySse2};
+#elif PIXEL_KERNELS_NEON
+    return {UnpremultiplyNeon, SwizzleBGRANeon, StripAlphaNeon, GrayNeon};
+#else
+    return {UnpremultiplyScalar, SwizzleBGRAScalar, StripAlphaScalar, GrayScalar};
+#endif
+  }();
+  return kernels;
+}
+
+// Floating point kernels.
+
+template <size_t Channels>
+void PremultiplyFloat(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += Channels * 4, dst += Channels * 4) {
+    float channels[Channels];
+    memcpy(channels, src, sizeof(channels));
+    for (size_t c = 0; c < Channels - 1; ++c) {
+      channels[c] *= channels[Channels - 1];
+    }
+    memcpy(dst, channels, sizeof(channels));
+  }
+}
+
+template <size_t Channels>
+void PremultiplyHalfFloat(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += Channels * 2, dst += Channels * 2) {
+    uint16_t channels[Channels];
+    memcpy(channels, src, sizeof(channels));
+    float alpha = HalfToFloat(channels[Channels - 1]);
+    for (size_t c = 0; c < Channels - 1; ++c) {
+      channels[c] = FloatToHalf(HalfToFloat(channels[c]) * alpha);
+    }
+    memcpy(dst, channels, sizeof(channels));
+  }
+}
+
+// Packed kernels.
+
+void PremultiplyRGBA4444(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 2, dst += 2) {
+    uint32_t pixel = Load<uint16_t>(src);
+    uint32_t alpha = pixel & 0xf;
+    uint32_t r = ((pixel >> 12) * alpha + 7) / 15;
+    uint32_t g = (((pixel >> 8) & 0xf) * alpha + 7) / 15;
+    uint32_t b = (((pixel >> 4) & 0xf) * alpha + 7) / 15;
+    Store<uint16_t>(dst, static_cast<uint16_t>((r << 12) | (g << 8) | (b << 4) | alpha));
+  }
+}
+
+void PremultiplyRGBA5551(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 2, dst += 2) {
+    uint16_t pixel = Load<uint16_t>(src);
+    Store<uint16_t>(dst, (pixel & 1) ? pixel : 0);
+  }
+}
+
+void PremultiplyRGBA1010102(const uint8_t *src, uint8_t *dst, size_t pixels) {
+  for (size_t i = 0; i < pixels; ++i, src += 4, dst += 4) {
+    uint32_t pixel = Load<uint32_t>(src);
+    uint32_t alpha = pixel >> 30;
+    uint32_t r = ((pixel & 0x3ff) * alpha + 1) / 3;
+    uint32_t g = (((pixel >> 10) & 0x3ff) * alpha + 1) / 3;
+    uint32_t b = (((pixel >> 20) & 0x3ff) * alpha + 1) / 3;
+    Store<uint32_t>(dst, r | (g << 10) | (b << 20) | (alpha << 30));
+  }
+}
+
+size_t ComponentCount(GLenum format) {
+  switch (format) {
+  case GL_ALPHA:
+  case GL_LUMINANCE:
+  case GL_RED:
+  case GL_RED_INTEGER:
+  case GL_DEPTH_COMPONENT:
+    return 1;
+  case GL_LUMINANCE_ALPHA:
+  case GL_RG:
+  case GL_RG_INTEGER:
+  case GL_DEPTH_STENCIL:
+    return 2;
+  case GL_RGB:
+  case GL_RGB_INTEGER:
+  case GL_SRGB_EXT:
+    return 3;
+  case GL_RGBA:
+  case GL_RGBA_INTEGER:
+  case GL_SRGB_ALPHA_EXT:
+    return 4;
+  default:
+    return 0;
+  }
+}
+
+} // namespace
+
+namespace PixelKernels {
+
+size_t BytesPerPixel(GLenum format, GLenum type) {
+  switch (type) {
+  case GL_UNSIGNED_SHORT_5_6_5:
+  case GL_UNSIGNED_SHORT_4_4_4_4:
+  case GL_UNSIGNED_SHORT_5_5_5_1:
+    return 2;
+  case GL_UNSIGNED_INT_2_10_10_10_REV:
+  case GL_UNSIGNED_INT_10F_11F_11F_REV:
+  case GL_UNSIGNED_INT_5_9_9_9_REV:
+  case GL_UNSIGNED_INT_24_8:
+    return 4;
+  case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+    return 8;
+  case GL_UNSIGNED_BYTE:
+  case GL_BYTE:
+    return ComponentCount(format);
+  case GL_UNSIGNED_SHORT:
+  case GL_SHORT:
+  case GL_HALF_FLOAT:
+  case GL_HALF_FLOAT_OES:
+    return 2 * ComponentCount(format);
+  case GL_UNSIGNED_INT:
+  case GL_INT:
+  case GL_FLOAT:
+    return 4 * ComponentCount(format);
+  default:
+    return 0;
+  }
+}
+
+RowKernel PremultiplyKernel(GLenum format, GLenum type) {
+  if (format == GL_RGBA || format == GL_SRGB_ALPHA_EXT) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+      return PremultiplyRGBA8;
+    case GL_FLOAT:
+      return PremultiplyFloat<4>;
+    case GL_HALF_FLOAT:
+    case GL_HALF_FLOAT_OES:
+      return PremultiplyHalfFloat<4>;
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+      return PremultiplyRGBA4444;
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return PremultiplyRGBA5551;
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+      return PremultiplyRGBA1010102;
+    }
+  } else if (format == GL_LUMINANCE_ALPHA) {
+    switch (type) {
+    case GL_UNSIGNED_BYTE:
+      return PremultiplyLuminanceAlpha8;
+    case GL_FLOAT:
+      return PremultiplyFloat<2>;
+    case GL_HALF_FLOAT:
+    case GL_HALF_FLOAT_OES:
+      return PremultiplyHalfFloat<2>;
+    }
+  }
+  return nullptr;
+}
+
+void Unpack(const uint8_t *src, uint8_t *dst, size_t width, size_t height, size_t pixelSize,
+            size_t rowStride, bool flipY, RowKernel premultiply) {
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t *in = src + row * rowStride;
+    uint8_t *out = dst + (flipY ? height - 1 - row : row) * rowStride;
+    if (premultiply) {
+      premultiply(in, out, width);
+    } else {
+      memcpy(out, in, width * pixelSize);
+    }
+  }
+}
+
+size_t PackedPixelSize(PackFormat format) {
+  switch (format) {
+  case PACK_RGB:
+    return 3;
+  case PACK_GRAY:
+    return 1;
+  default:
+    return 4;
+  }
+}
+
+void Pack(const uint8_t *src, uint8_t *dst, size_t width, size_t height, size_t srcStride,
+          size_t dstStride, bool flipY, PackFormat format, bool unpremultiply) {
+  const PackKernels8 &kernels = SelectPackKernels8();
+  RowKernel convert = nullptr;
+  switch (format) {
+  case PACK_BGRA:
+    convert = kernels.bgra;
+    break;
+  case PACK_RGB:
+    convert = kernels.rgb;
+    break;
+  case PACK_GRAY:
+    convert = kernels.gray;
+    break;
+  default:
+    break;
+  }
+  size_t outSize = PackedPixelSize(format);
+
+  // When both steps run, rows go through a small buffer that stays in L1 between them
+  const size_t CHUNK = 1024;
+  uint8_t chunk[CHUNK * 4];
+
+  for (size_t row = 0; row < height; ++row) {
+    const uint8_t *in = src + row * srcStride;
+    uint8_t *out = dst + (flipY ? height - 1 - row : row) * dstStride;
+    if (!unpremultiply) {
+      if (convert) {
+        convert(in, out, width);
+      } else {
+        memcpy(out, in, width * 4);
+      }
+    } else if (!convert) {
+      kernels.unpremultiply(in, out, width);
+    } else {
+      for (size_t i = 0; i < width; i += CHUNK) {
+        size_t pixels = width - i < CHUNK ? width - i : CHUNK;
+        kernels.unpremultiply(in + i * 4, chunk, pixels);
+        convert(chunk, out + i * outSize, pixels);
+      }
+    }
+  }
+}
+
+const char *SimdLevel() { return SelectKernels8().level; }
+
+} // namespace PixelKernels
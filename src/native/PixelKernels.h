@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef GL_GLES_PROTOTYPES
+#define GL_GLES_PROTOTYPES 0
+#endif
+
+#include "angle-loader/gles_loader.h"
+
+// Row kernels for the UNPACK_FLIP_Y_WEBGL / UNPACK_PREMULTIPLY_ALPHA_WEBGL conversions applied to
+// texture uploads and for the conversions applied to pixels read back with readPixels. The 8-bit
+// kernels are vectorized with SSE2 (AVX2 when the CPU has it) or NEON and fall back to scalar code
+// elsewhere; every kernel produces the same result on every path. Color channels are multiplied or
+// divided by alpha and rounded to nearest, alpha itself is left untouched.
+namespace PixelKernels {
+
+// Converts `pixels` pixels read from `src` and writes them to `dst`. `src` and `dst` may be the
+// same row, but must not otherwise overlap.
+typedef void (*RowKernel)(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+// Size in bytes of one pixel of the given format/type pair, or 0 if the pair is not known.
+size_t BytesPerPixel(GLenum format, GLenum type);
+
+// Kernel that premultiplies one row of the given format/type pair, or nullptr if the pair has no
+// alpha channel to premultiply by.
+RowKernel PremultiplyKernel(GLenum format, GLenum type);
+
+// Copies `height` rows of `width` pixels from `src` to `dst`, both laid out with `rowStride` bytes
+// per row. Rows are written bottom-up when `flipY` is set and run through `premultiply` when it is
+// not null. Padding bytes at the end of each row are not written.
+void Unpack(const uint8_t *src, uint8_t *dst, size_t width, size_t height, size_t pixelSize,
+            size_t rowStride, bool flipY, RowKernel premultiply);
+
+// Layouts that RGBA/UNSIGNED_BYTE pixels read back from GL can be repacked into.
+enum PackFormat { PACK_RGBA, PACK_RGB, PACK_BGRA, PACK_GRAY };
+
+// Size in bytes of one pixel in the given layout.
+size_t PackedPixelSize(PackFormat format);
+
+// Repacks `height` rows of `width` RGBA pixels from `src`, with `srcStride` bytes per row, into
+// `dst` with `dstStride` bytes per row. Rows are written bottom-up when `flipY` is set. Colors are
+// divided by alpha first when `unpremultiply` is set. Gray is the BT.601 luma of the color.
+void Pack(const uint8_t *src, uint8_t *dst, size_t width, size_t height, size_t srcStride,
+          size_t dstStride, bool flipY, PackFormat format, bool unpremultiply);
+
+// Instruction set used by the 8-bit kernels: "avx2", "sse2", "neon" or "scalar".
+const char *SimdLevel();
+
+} // namespace PixelKernels
@@ -0,0 +1,206 @@
+#include "PngEncoder.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "PixelKernels.h"
+
+namespace {
+
+enum Filter { FILTER_NONE, FILTER_SUB, FILTER_UP, FILTER_AVERAGE, FILTER_PAETH, FILTER_COUNT };
+
+inline uint8_t Paeth(int left, int up, int upLeft) {
+  int estimate = left + up - upLeft;
+  int toLeft = abs(estimate - left);
+  int toUp = abs(estimate - up);
+  int toUpLeft = abs(estimate - upLeft);
+  if (toLeft <= toUp && toLeft <= toUpLeft) {
+    return static_cast<uint8_t>(left);
+  }
+  return static_cast<uint8_t>(toUp <= toUpLeft ? up : upLeft);
+}
+
+// Writes the filter type followed by `row` filtered against `previous`, the unfiltered row above.
+void FilterRow(Filter filter, const uint8_t *row, const uint8_t *previous, size_t bytes,
+               size_t pixelSize, uint8_t *out) {
+  *out++ = static_cast<uint8_t>(filter);
+  switch (filter) {
+  case FILTER_NONE:
+    memcpy(out, row, bytes);
+    break;
+  case FILTER_SUB:
+    memcpy(out, row, pixelSize);
+    for (size_t i = pixelSize; i < bytes; ++i) {
+      out[i] = static_cast<uint8_t>(row[i] - row[i - pixelSize]);
+    }
+    break;
+  case FILTER_UP:
+    for (size_t i = 0; i < bytes; ++i) {
+      out[i] = static_cast<uint8_t>(row[i] - previous[i]);
+    }
+    break;
+  case FILTER_AVERAGE:
+    for (size_t i = 0; i < pixelSize; ++i) {
+      out[i] = static_cast<uint8_t>(row[i] - (previous[i] >> 1));
+    }
+    for (size_t i = pixelSize; i < bytes; ++i) {
+      out[i] = static_cast<uint8_t>(row[i] - ((row[i - pixelSize] + previous[i]) >> 1));
+    }
+    break;
+  case FILTER_PAETH:
+    for (size_t i = 0; i < pixelSize; ++i) {
+      out[i] = static_cast<uint8_t>(row[i] - previous[i]);
+    }
+    for (size_t i = pixelSize; i < bytes; ++i) {
+      out[i] = static_cast<uint8_t>(
+          row[i] - Paeth(row[i - pixelSize], previous[i], previous[i - pixelSize]));
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// Sum of the filtered bytes taken as signed values. Smaller sums tend to compress better.
+size_t FilterCost(const uint8_t *filtered, size_t bytes) {
+  size_t cost = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    cost += filtered[i] < 128 ? filtered[i] : 256 - filtered[i];
+  }
+  return cost;
+}
+
+void AppendUint32(std::vector<uint8_t> &png, uint32_t value) {
+  png.push_back(static_cast<uint8_t>(value >> 24));
+  png.push_back(static_cast<uint8_t>(value >> 16));
+  png.push_back(static_cast<uint8_t>(value >> 8));
+  png.push_back(static_cast<uint8_t>(value));
+}
+
+// Appends the chunk header with a placeholder length and returns where it starts
+size_t BeginChunk(std::vector<uint8_t> &png, const char *type) {
+  size_t start = png.size();
+  AppendUint32(png, 0);
+  png.insert(png.end(), type, type + 4);
+  return start;
+}
+
+void EndChunk(std::vector<uint8_t> &png, size_t start) {
+  uint32_t length = static_cast<uint32_t>(png.size() - start - 8);
+  for (int i = 0; i < 4; ++i) {
+    png[start + i] = static_cast<uint8_t>(length >> (24 - 8 * i));
+  }
+  AppendUint32(png, crc32(crc32(0, Z_NULL, 0), png.data() + start + 4, length + 4));
+}
+
+// Compresses the pending input into `png` from offset `used`, growing it as needed. Returns once
+// the input is consumed, or the stream has ended when finishing.
+bool Deflate(z_stream &stream, std::vector<uint8_t> &png, size_t &used, int flush) {
+  for (;;) {
+    if (used == png.size()) {
+      png.resize(png.size() * 2);
+    }
+    stream.next_out = png.data() + used;
+    stream.avail_out = static_cast<uInt>(png.size() - used);
+    int result = deflate(&stream, flush);
+    used = png.size() - stream.avail_out;
+    if (result == Z_STREAM_END) {
+      return true;
+    }
+    if (result != Z_OK && result != Z_BUF_ERROR) {
+      return false;
+    }
+    if (flush == Z_NO_FLUSH && stream.avail_in == 0) {
+      return true;
+    }
+  }
+}
+
+} // namespace
+
+namespace PngEncoder {
+
+bool Encode(const uint8_t *rgba, size_t width, size_t height, bool alpha, bool flipY,
+            bool unpremultiply, int level, std::vector<uint8_t> &png) {
+  static const uint8_t SIGNATURE[] = {137, 80, 78, 71, 13, 10, 26, 10};
+  if (width == 0 || height == 0) {
+    return false;
+  }
+  size_t pixelSize = alpha ? 4 : 3;
+  size_t rowBytes = width * pixelSize;
+  bool convert = !alpha || unpremultiply;
+  PixelKernels::PackFormat format = alpha ? PixelKernels::PACK_RGBA : PixelKernels::PACK_RGB;
+
+  png.assign(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+  size_t chunk = BeginChunk(png, "IHDR");
+  AppendUint32(png, static_cast<uint32_t>(width));
+  AppendUint32(png, static_cast<uint32_t>(height));
+  png.push_back(8);             // Bit depth
+  png.push_back(alpha ? 6 : 2); // Truecolor, with or without alpha
+  png.push_back(0);             // Deflate
+  png.push_back(0);             // Adaptive filtering
+  png.push_back(0);             // Not interlaced
+  EndChunk(png, chunk);
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, level, Z_DEFLATED, 15, 8,
+                   level == 0 ? Z_DEFAULT_STRATEGY : Z_FILTERED) != Z_OK) {
+    return false;
+  }
+
+  // Two rows for converted pixels, since the previous row is still needed for filtering, a row
+  // of zeros above the first one and one filtered row per filter type
+  std::vector<uint8_t> buffer(3 * rowBytes + FILTER_COUNT * (rowBytes + 1));
+  uint8_t *converted[2] = {buffer.data(), buffer.data() + rowBytes};
+  const uint8_t *previous = buffer.data() + 2 * rowBytes;
+  uint8_t *filtered = buffer.data() + 3 * rowBytes;
+
+  chunk = BeginChunk(png, "IDAT");
+  size_t used = png.size();
+  png.resize(used + (rowBytes + 1) * height / 4 + 1024);
+
+  bool ok = true;
+  for (size_t y = 0; ok && y < height; ++y) {
+    const uint8_t *row = rgba + (flipY ? height - 1 - y : y) * width * 4;
+    if (convert) {
+      PixelKernels::Pack(row, converted[y & 1], width, 1, width * 4, rowBytes, false, format,
+                         unpremultiply);
+      row = converted[y & 1];
+    }
+
+    const uint8_t *best = filtered;
+    if (level == 0) {
+      FilterRow(FILTER_NONE, row, previous, rowBytes, pixelSize, filtered);
+    } else {
+      size_t bestCost = SIZE_MAX;
+      for (int filter = FILTER_NONE; filter < FILTER_COUNT; ++filter) {
+        uint8_t *candidate = filtered + filter * (rowBytes + 1);
+        FilterRow(static_cast<Filter>(filter), row, previous, rowBytes, pixelSize, candidate);
+        size_t cost = FilterCost(candidate + 1, rowBytes);
+        if (cost < bestCost) {
+          bestCost = cost;
+          best = candidate;
+        }
+      }
+    }
+
+    stream.next_in = const_cast<uint8_t *>(best);
+    stream.avail_in = static_cast<uInt>(rowBytes + 1);
+    ok = Deflate(stream, png, used, y + 1 == height ? Z_FINISH : Z_NO_FLUSH);
+    previous = row;
+  }
+  deflateEnd(&stream);
+  if (!ok) {
+    return false;
+  }
+  png.resize(used);
+  EndChunk(png, chunk);
+
+  EndChunk(png, BeginChunk(png, "IEND"));
+  return true;
+}
+
+} // namespace PngEncoder
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// PNG encoder for frames read back from GL, used by encodeFrame on the libuv threadpool. Rows are
+// converted with PixelKernels::Pack one at a time, so the frame is never copied as a whole. Each
+// row gets the filter with the smallest sum of absolute differences, as libpng picks them, before
+// it is compressed with the zlib that ships with node.
+namespace PngEncoder {
+
+// Encodes `height` rows of `width` tightly packed RGBA pixels to `png`. The image is RGB if
+// `alpha` is false. Rows are taken bottom-up when `flipY` is set, and colors are divided by alpha
+// when `unpremultiply` is set. `level` is the zlib compression level, 0 stores the rows unfiltered.
+// Returns false if zlib fails.
+bool Encode(const uint8_t *rgba, size_t width, size_t height, bool alpha, bool flipY,
+            bool unpremultiply, int level, std::vector<uint8_t> &png);
+
+} // namespace PngEncoder
@@ -0,0 +1,513 @@
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Every entry file starts with this header, followed by the key and the value
+const uint32_t ENTRY_MAGIC = 0x504c4748; // "HGLP"
+
+struct EntryHeader {
+  uint32_t magic;
+  uint32_t keySize;
+  uint32_t valueSize;
+  uint32_t reserved;
+};
+
+bool ReadHeader(const uint8_t *data, size_t size, EntryHeader &header) {
+  if (size < sizeof(EntryHeader)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(EntryHeader));
+  return header.magic == ENTRY_MAGIC && header.keySize > 0 &&
+         sizeof(EntryHeader) + uint64_t(header.keySize) + uint64_t(header.valueSize) == size;
+}
+
+// 64 bit FNV-1a, ANGLE's keys are already hashes so this only has to spread them over file names
+uint64_t HashBytes(const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+std::string HexName(uint64_t hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string name(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    name[i] = digits[hash & 0xf];
+    hash >>= 4;
+  }
+  return name;
+}
+
+unsigned long ProcessId() {
+#ifdef _WIN32
+  return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+// Read only mapping of a whole file
+class MappedFile {
+public:
+  MappedFile() {}
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (view) {
+      UnmapViewOfFile(view);
+    }
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+#else
+    if (view) {
+      munmap(view, length);
+    }
+#endif
+  }
+
+  bool open(const fs::path &path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping) {
+        view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        length = static_cast<size_t>(size.QuadPart);
+      }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *address = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address != MAP_FAILED) {
+        view = address;
+        length = static_cast<size_t>(info.st_size);
+      }
+    }
+    close(fd);
+#endif
+    return view != nullptr;
+  }
+
+  const uint8_t *data() const { return static_cast<const uint8_t *>(view); }
+  size_t size() const { return length; }
+
+private:
+#ifdef _WIN32
+  HANDLE mapping = NULL;
+#endif
+  void *view = nullptr;
+  size_t length = 0;
+};
+
+typedef std::shared_ptr<std::vector<uint8_t>> Record;
+
+// An entry lives in memory until the writer thread has put it on disk, and is mapped afterwards
+struct Entry {
+  std::unique_ptr<MappedFile> file;
+  Record pending;
+  uint64_t serial = 0;
+  uint64_t lastUse = 0;
+  size_t size = 0;
+
+  const uint8_t *record() const { return file ? file->data() : pending->data(); }
+};
+
+struct Job {
+  enum Type { WRITE, REMOVE };
+
+  Type type;
+  uint64_t hash;
+  uint64_t serial;
+  Record record;
+};
+
+struct State {
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::thread writer;
+
+  bool configured = false;
+  bool loaded = false;
+  bool stopping = false;
+  bool busy = false;
+
+  fs::path root;
+  fs::path directory;
+  size_t maxBytes = 0;
+  size_t totalBytes = 0;
+  uint64_t clock = 0;
+  uint64_t serial = 0;
+
+  std::map<uint64_t, Entry> entries;
+  std::set<EGLDisplay> displays;
+  std::deque<Job> jobs;
+
+  double hits = 0;
+  double misses = 0;
+  double stores = 0;
+  double evictions = 0;
+};
+
+// Never destroyed, the blob cache callbacks and the writer thread may outlive static destructors
+State &GetState() {
+  static State *state = new State();
+  return *state;
+}
+
+void EvictLocked(State &state) {
+  while (state.totalBytes > state.maxBytes && !state.entries.empty()) {
+    auto oldest = state.entries.begin();
+    for (auto it = state.entries.begin(); it != state.entries.end(); ++it) {
+      if (it->second.lastUse < oldest->second.lastUse) {
+        oldest = it;
+      }
+    }
+    state.totalBytes -= oldest->second.size;
+    state.jobs.push_back({Job::REMOVE, oldest->first, 0, nullptr});
+    state.entries.erase(oldest);
+    state.evictions++;
+  }
+  if (!state.jobs.empty()) {
+    state.wake.notify_one();
+  }
+}
+
+// Maps every valid entry left by earlier processes, least recently written first
+void LoadLocked(State &state, const std::string &version) {
+  state.directory = state.root / HexName(HashBytes(version.data(), version.size()));
+
+  std::error_code error;
+  fs::create_directories(state.directory, error);
+
+  std::vector<std::pair<fs::file_time_type, uint64_t>> order;
+  fs::directory_iterator end;
+  for (fs::directory_iterator it(state.directory, error); !error && it != end; it.increment(error)) {
+    const fs::path path = it->path();
+    if (path.extension() != ".bin") {
+      continue;
+    }
+
+    auto file = std::make_unique<MappedFile>();
+    EntryHeader header;
+    bool valid = file->open(path) && ReadHeader(file->data(), file->size(), header);
+    uint64_t hash = 0;
+    if (valid) {
+      hash = HashBytes(file->data() + sizeof(EntryHeader), header.keySize);
+      valid = path.stem() == HexName(hash) && state.entries.count(hash) == 0;
+    }
+    if (!valid) {
+      std::error_code removeError;
+      file.reset();
+      fs::remove(path, removeError);
+      continue;
+    }
+
+    std::error_code timeError;
+    order.push_back({fs::last_write_time(path, timeError), hash});
+
+    Entry &entry = state.entries[hash];
+    entry.size = file->size();
+    entry.file = std::move(file);
+    entry.serial = ++state.serial;
+    state.totalBytes += entry.size;
+  }
+
+  std::sort(order.begin(), order.end());
+  for (const auto &item : order) {
+    state.entries[item.second].lastUse = ++state.clock;
+  }
+
+  state.loaded = true;
+  EvictLocked(state);
+}
+
+bool WriteRecord(const fs::path &path, const std::vector<uint8_t> &record) {
+  fs::path temporary = path;
+  temporary += "." + std::to_string(ProcessId()) + ".tmp";
+
+  std::error_code error;
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (out) {
+      out.write(reinterpret_cast<const char *>(record.data()),
+                static_cast<std::streamsize>(record.size()));
+    }
+    if (!out) {
+      out.close();
+      fs::remove(temporary, error);
+      return false;
+    }
+  }
+
+  fs::rename(temporary, path, error);
+  if (error) {
+    fs::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+void WriterMain() {
+  State &state = GetState();
+  std::unique_lock<std::mutex> lock(state.mutex);
+
+  for (;;) {
+    state.wake.wait(lock, [&state] { return state.stopping || !state.jobs.empty(); });
+    if (state.jobs.empty()) {
+      break;
+    }
+
+    Job job = std::move(state.jobs.front());
+    state.jobs.pop_front();
+    state.busy = true;
+    const fs::path path = state.directory / (HexName(job.hash) + ".bin");
+    lock.unlock();
+
+    std::unique_ptr<MappedFile> mapped;
+    if (job.type == Job::REMOVE) {
+      std::error_code error;
+      fs::remove(path, error);
+    } else if (WriteRecord(path, *job.record)) {
+      mapped = std::make_unique<MappedFile>();
+      if (!mapped->open(path) || mapped->size() != job.record->size()) {
+        mapped.reset();
+      }
+    }
+
+    lock.lock();
+    if (mapped) {
+      auto found = state.entries.find(job.hash);
+      if (found != state.entries.end() && found->second.serial == job.serial) {
+        found->second.file = std::move(mapped);
+        found->second.pending.reset();
+      }
+    }
+    state.busy = false;
+    if (state.jobs.empty()) {
+      state.idle.notify_all();
+    }
+  }
+}
+
+void EGLAPIENTRY SetBlob(const void *key, EGLsizeiANDROID keySize, const void *value,
+                         EGLsizeiANDROID valueSize) {
+  if (keySize <= 0 || valueSize < 0) {
+    return;
+  }
+
+  const size_t size = sizeof(EntryHeader) + size_t(keySize) + size_t(valueSize);
+  Record record = std::make_shared<std::vector<uint8_t>>(size);
+  EntryHeader header = {ENTRY_MAGIC, uint32_t(keySize), uint32_t(valueSize), 0};
+  memcpy(record->data(), &header, sizeof(EntryHeader));
+  memcpy(record->data() + sizeof(EntryHeader), key, keySize);
+  memcpy(record->data() + sizeof(EntryHeader) + keySize, value, valueSize);
+  const uint64_t hash = HashBytes(key, keySize);
+
+  State &state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.loaded || state.stopping || size > state.maxBytes) {
+    return;
+  }
+
+  auto existing = state.entries.find(hash);
+  if (existing != state.entries.end()) {
+    state.totalBytes -= existing->second.size;
+    state.entries.erase(existing);
+  }
+
+  Entry &entry = state.entries[hash];
+  entry.pending = record;
+  entry.serial = ++state.serial;
+  entry.lastUse = ++state.clock;
+  entry.size = size;
+  state.totalBytes += size;
+  state.stores++;
+
+  state.jobs.push_back({Job::WRITE, hash, entry.serial, record});
+  EvictLocked(state);
+}
+
+// ANGLE first asks for the size with a null buffer, then calls again to copy the value
+EGLsizeiANDROID EGLAPIENTRY GetBlob(const void *key, EGLsizeiANDROID keySize, void *value,
+                                    EGLsizeiANDROID valueSize) {
+  if (keySize <= 0) {
+    return 0;
+  }
+  const uint64_t hash = HashBytes(key, keySize);
+  const bool query = value == nullptr || valueSize <= 0;
+
+  State &state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  auto found = state.entries.find(hash);
+  EntryHeader header;
+  const uint8_t *record = nullptr;
+  if (found != state.entries.end()) {
+    record = found->second.record();
+    memcpy(&header, record, sizeof(EntryHeader));
+    if (header.keySize != uint32_t(keySize) ||
+        memcmp(record + sizeof(EntryHeader), key, keySize) != 0) {
+      record = nullptr;
+    }
+  }
+
+  if (!record) {
+    if (query) {
+      state.misses++;
+    }
+    return 0;
+  }
+
+  if (query) {
+    state.hits++;
+    found->second.lastUse = ++state.clock;
+  } else if (valueSize >= EGLsizeiANDROID(header.valueSize)) {
+    memcpy(value, record + sizeof(EntryHeader) + header.keySize, header.valueSize);
+  }
+  return EGLsizeiANDROID(header.valueSize);
+}
+
+} // namespace
+
+namespace ProgramCache {
+
+bool Configure(const std::string &directory, size_t maxBytes, std::string &errorMessage) {
+  State &state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  if (state.configured) {
+    errorMessage = "The program cache is already configured.";
+    return false;
+  }
+  if (directory.empty()) {
+    errorMessage = "The program cache requires a directory.";
+    return false;
+  }
+
+  std::error_code error;
+  fs::create_directories(directory, error);
+  if (error) {
+    errorMessage = "Error creating program cache directory '" + directory + "'.";
+    return false;
+  }
+
+  state.root = directory;
+  state.maxBytes = maxBytes;
+  state.configured = true;
+  state.writer = std::thread(WriterMain);
+  return true;
+}
+
+bool IsConfigured() {
+  State &state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.configured;
+}
+
+void Attach(EGLDisplay display) {
+  if (display == EGL_NO_DISPLAY || !eglSetBlobCacheFuncsANDROID) {
+    return;
+  }
+
+  State &state = GetState();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.configured || state.stopping || state.displays.count(display)) {
+      return;
+    }
+
+    const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_ANDROID_blob_cache")) {
+      return;
+    }
+
+    // Every display comes from the same libEGL, so the version is the same for all of them
+    if (!state.loaded) {
+      const char *version = eglQueryString(display, EGL_VERSION);
+      LoadLocked(state, version ? version : "");
+    }
+    state.displays.insert(display);
+  }
+
+  eglSetBlobCacheFuncsANDROID(display, SetBlob, GetBlob);
+}
+
+void Flush() {
+  State &state = GetState();
+  std::unique_lock<std::mutex> lock(state.mutex);
+  state.idle.wait(lock, [&state] { return state.jobs.empty() && !state.busy; });
+}
+
+void Shutdown() {
+  State &state = GetState();
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.stopping = true;
+    state.displays.clear();
+  }
+  state.wake.notify_one();
+  if (state.writer.joinable()) {
+    state.writer.join();
+  }
+}
+
+ProgramCacheStats GetStats() {
+  State &state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+
+  ProgramCacheStats stats;
+  stats.hits = state.hits;
+  stats.misses = state.misses;
+  stats.stores = state.stores;
+  stats.evictions = state.evictions;
+  stats.entries = double(state.entries.size());
+  stats.bytes = double(state.totalBytes);
+  return stats;
+}
+
+} // namespace ProgramCache
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifndef EGL_EGL_PROTOTYPES
+#define EGL_EGL_PROTOTYPES 0
+#endif
+
+#include "angle-loader/egl_loader.h"
+
+// Persistent program binary cache built on EGL_ANDROID_blob_cache. ANGLE hands every compiled
+// program (and, on Vulkan, pipeline cache data) to the callbacks installed here, keyed by a hash
+// it computes from the shader sources and link state. Each entry is stored as one file under
+// <directory>/<hash of EGL_VERSION>, so a different ANGLE build never sees stale binaries.
+//
+// Files already on disk are memory mapped the first time a display is attached. New entries are
+// kept in memory and written by a background thread, after which they are mapped as well. The
+// least recently used entries are evicted once the total size exceeds the budget.
+struct ProgramCacheStats {
+  double hits;
+  double misses;
+  double stores;
+  double evictions;
+  double entries;
+  double bytes;
+};
+
+namespace ProgramCache {
+
+// Enables the cache for the rest of the process. The blob cache callbacks can only be installed
+// once per display, so the cache cannot be moved or disabled afterwards.
+bool Configure(const std::string &directory, size_t maxBytes, std::string &errorMessage);
+bool IsConfigured();
+
+// Installs the blob cache callbacks on an initialized display. Does nothing if the cache is not
+// configured, the display is already attached or does not support EGL_ANDROID_blob_cache.
+void Attach(EGLDisplay display);
+
+// Blocks until every pending entry has been written
+void Flush();
+
+// Flushes pending writes and stops the writer thread, called when the process exits
+void Shutdown();
+
+ProgramCacheStats GetStats();
+
+} // namespace ProgramCache
@@ -9,6 +9,7 @@
 #include <cstdlib>
 
 Nan::Persistent<v8::FunctionTemplate> WEBGL_TEMPLATE;
+Nan::Persistent<v8::FunctionTemplate> WEBGL2_TEMPLATE;
 
 #define JS_GL_METHOD(webgl_name, method_name)                                                      \
   Nan::SetPrototypeTemplate(webgl_template, webgl_name,                                            \
@@ -18,10 +19,12 @@ Nan::Persistent<v8::FunctionTemplate> WEBGL_TEMPLATE;
 
 #define JS_GL_CONSTANT(name) JS_CONSTANT(name, GL_##name)
 
-#define JS_SET_CONSTANT(name, v)                                                                   \
-  Nan::Set(info.This(), Nan::New(#name).ToLocalChecked(), Nan::New(v))
+#define JS_WEBGL2_CONSTANT(name, v)                                                                \
+  Nan::SetPrototypeTemplate(webgl2_template, #name, Nan::New<v8::Integer>(v))
 
-#define JS_SET_GL_CONSTANT(name) JS_SET_CONSTANT(name, GL_##name)
+#define JS_WEBGL2_GL_CONSTANT(name) JS_WEBGL2_CONSTANT(name, GL_##name)
+
+static void BindWebGL2(v8::Local<v8::FunctionTemplate> webgl2_template);
 
 NAN_MODULE_INIT(Init) {
   v8::Local<v8::FunctionTemplate> webgl_template =
@@ -44,6 +47,14 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("uniform2i", Uniform2i);
   JS_GL_METHOD("uniform3i", Uniform3i);
   JS_GL_METHOD("uniform4i", Uniform4i);
+  JS_GL_METHOD("uniform1fv", Uniform1fv);
+  JS_GL_METHOD("uniform1iv", Uniform1iv);
+  JS_GL_METHOD("uniform2fv", Uniform2fv);
+  JS_GL_METHOD("uniform2iv", Uniform2iv);
+  JS_GL_METHOD("uniform3fv", Uniform3fv);
+  JS_GL_METHOD("uniform3iv", Uniform3iv);
+  JS_GL_METHOD("uniform4fv", Uniform4fv);
+  JS_GL_METHOD("uniform4iv", Uniform4iv);
   JS_GL_METHOD("pixelStorei", PixelStorei);
   JS_GL_METHOD("bindAttribLocation", BindAttribLocation);
   JS_GL_METHOD("getError", GetError);
@@ -59,6 +70,7 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("shaderSource", ShaderSource);
   JS_GL_METHOD("compileShader", CompileShader);
   JS_GL_METHOD("getShaderParameter", GetShaderParameter);
+  JS_GL_METHOD("_maxShaderCompilerThreads", MaxShaderCompilerThreads);
   JS_GL_METHOD("getShaderInfoLog", GetShaderInfoLog);
   JS_GL_METHOD("createProgram", CreateProgram);
   JS_GL_METHOD("attachShader", AttachShader);
@@ -138,10 +150,16 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("getShaderSource", GetShaderSource);
   JS_GL_METHOD("validateProgram", ValidateProgram);
   JS_GL_METHOD("texSubImage2D", TexSubImage2D);
+  JS_GL_METHOD("_texSubImage2DAsync", TexSubImage2DAsync);
+  JS_GL_METHOD("_readPixelsAsync", ReadPixelsAsync);
+  JS_GL_METHOD("_readPixelsAsyncPoll", ReadPixelsAsyncPoll);
+  JS_GL_METHOD("_readPixelsAsyncFinish", ReadPixelsAsyncFinish);
+  JS_GL_METHOD("_encodeFrame", EncodeFrame);
   JS_GL_METHOD("readPixels", ReadPixels);
   JS_GL_METHOD("getTexParameter", GetTexParameter);
   JS_GL_METHOD("getActiveAttrib", GetActiveAttrib);
   JS_GL_METHOD("getActiveUniform", GetActiveUniform);
+  JS_GL_METHOD("_getProgramReflection", GetProgramReflection);
   JS_GL_METHOD("getAttachedShaders", GetAttachedShaders);
   JS_GL_METHOD("getParameter", GetParameter);
   JS_GL_METHOD("getBufferParameter", GetBufferParameter);
@@ -156,6 +174,16 @@ NAN_MODULE_INIT(Init) {
   JS_GL_METHOD("frontFace", FrontFace);
   JS_GL_METHOD("sampleCoverage", SampleCoverage);
   JS_GL_METHOD("destroy", Destroy);
+  JS_GL_METHOD("_resetContext", ResetContext);
+  JS_GL_METHOD("_getStateCacheStats", GetStateCacheStats);
+  JS_GL_METHOD("_getScratchStats", GetScratchStats);
+  JS_GL_METHOD("_setScratchLimit", SetScratchLimit);
+  JS_GL_METHOD("_drawingBufferSamples", DrawingBufferSamples);
+  JS_GL_METHOD("_drawingBufferStorageMultisample", DrawingBufferStorageMultisample);
+  JS_GL_METHOD("_resolveDrawingBuffer", ResolveDrawingBuffer);
+  JS_GL_METHOD("_clearDrawingBuffer", ClearDrawingBuffer);
+  JS_GL_METHOD("_executeCommandBuffer", ExecuteCommandBuffer);
+  JS_GL_METHOD("_setCommandBuffer", SetCommandBuffer);
   JS_GL_METHOD("drawBuffersWEBGL", DrawBuffersWEBGL);
   JS_GL_METHOD("extWEBGL_draw_buffers", EXTWEBGL_draw_buffers);
   JS_GL_METHOD("createVertexArrayOES", CreateVertexArrayOES);
@@ -561,281 +589,307 @@ NAN_MODULE_INIT(Init) {
   Nan::Set(target, Nan::New<v8::String>("WebGLRenderingContext").ToLocalChecked(),
            Nan::GetFunction(webgl_template).ToLocalChecked());
 
+  // WebGL2 enums live on the prototype of a second template that inherits all WebGL1 methods and
+  // constants. It is built once here, the JS WebGL2RenderingContext copies the enums onto its own
+  // prototype at load time, so contexts never carry them as own properties.
+  v8::Local<v8::FunctionTemplate> webgl2_template =
+      Nan::New<v8::FunctionTemplate>(WebGLRenderingContext::New);
+
+  webgl2_template->Inherit(webgl_template);
+  webgl2_template->InstanceTemplate()->SetInternalFieldCount(1);
+  webgl2_template->SetClassName(Nan::New<v8::String>("WebGL2RenderingContext").ToLocalChecked());
+
+  BindWebGL2(webgl2_template);
+
+  WEBGL2_TEMPLATE.Reset(webgl2_template);
+  Nan::Set(target, Nan::New<v8::String>("WebGL2RenderingContext").ToLocalChecked(),
+           Nan::GetFunction(webgl2_template).ToLocalChecked());
+
   // Export helper methods for clean up and error handling
   Nan::Export(target, "cleanup", WebGLRenderingContext::DisposeAll);
   Nan::Export(target, "setError", WebGLRenderingContext::SetError);
+  Nan::Export(target, "setProgramCache", WebGLRenderingContext::SetProgramCache);
+  Nan::Export(target, "flushProgramCache", WebGLRenderingContext::FlushProgramCache);
+  Nan::Export(target, "getProgramCacheStats", WebGLRenderingContext::GetProgramCacheStats);
+  Nan::Export(target, "setSharedProgramCacheSize",
+              WebGLRenderingContext::SetSharedProgramCacheSize);
+  Nan::Export(target, "getSharedProgramStats", WebGLRenderingContext::GetSharedProgramStats);
+
+  // Opcodes and argument signatures understood by _executeCommandBuffer
+  Nan::Set(target, Nan::New<v8::String>("commandBufferOps").ToLocalChecked(),
+           WebGLRenderingContext::CommandBufferOps());
 }
 
-void BindWebGL2(const Nan::FunctionCallbackInfo<v8::Value> &info) {
+static void BindWebGL2(v8::Local<v8::FunctionTemplate> webgl2_template) {
   /* ES3 enums */
-  JS_SET_GL_CONSTANT(READ_BUFFER);
-  JS_SET_GL_CONSTANT(UNPACK_ROW_LENGTH);
-  JS_SET_GL_CONSTANT(UNPACK_SKIP_ROWS);
-  JS_SET_GL_CONSTANT(UNPACK_SKIP_PIXELS);
-  JS_SET_GL_CONSTANT(PACK_ROW_LENGTH);
-  JS_SET_GL_CONSTANT(PACK_SKIP_ROWS);
-  JS_SET_GL_CONSTANT(PACK_SKIP_PIXELS);
-  JS_SET_GL_CONSTANT(COLOR);
-  JS_SET_GL_CONSTANT(DEPTH);
-  JS_SET_GL_CONSTANT(STENCIL);
-  JS_SET_GL_CONSTANT(RED);
-  JS_SET_GL_CONSTANT(RGB8);
-  JS_SET_GL_CONSTANT(RGB10_A2);
-  JS_SET_GL_CONSTANT(TEXTURE_BINDING_3D);
-  JS_SET_GL_CONSTANT(UNPACK_SKIP_IMAGES);
-  JS_SET_GL_CONSTANT(UNPACK_IMAGE_HEIGHT);
-  JS_SET_GL_CONSTANT(TEXTURE_3D);
-  JS_SET_GL_CONSTANT(TEXTURE_WRAP_R);
-  JS_SET_GL_CONSTANT(MAX_3D_TEXTURE_SIZE);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_2_10_10_10_REV);
-  JS_SET_GL_CONSTANT(MAX_ELEMENTS_VERTICES);
-  JS_SET_GL_CONSTANT(MAX_ELEMENTS_INDICES);
-  JS_SET_GL_CONSTANT(TEXTURE_MIN_LOD);
-  JS_SET_GL_CONSTANT(TEXTURE_MAX_LOD);
-  JS_SET_GL_CONSTANT(TEXTURE_BASE_LEVEL);
-  JS_SET_GL_CONSTANT(TEXTURE_MAX_LEVEL);
-  JS_SET_GL_CONSTANT(MIN);
-  JS_SET_GL_CONSTANT(MAX);
-  JS_SET_GL_CONSTANT(DEPTH_COMPONENT24);
-  JS_SET_GL_CONSTANT(MAX_TEXTURE_LOD_BIAS);
-  JS_SET_GL_CONSTANT(TEXTURE_COMPARE_MODE);
-  JS_SET_GL_CONSTANT(TEXTURE_COMPARE_FUNC);
-  JS_SET_GL_CONSTANT(CURRENT_QUERY);
-  JS_SET_GL_CONSTANT(QUERY_RESULT);
-  JS_SET_GL_CONSTANT(QUERY_RESULT_AVAILABLE);
-  JS_SET_GL_CONSTANT(STREAM_READ);
-  JS_SET_GL_CONSTANT(STREAM_COPY);
-  JS_SET_GL_CONSTANT(STATIC_READ);
-  JS_SET_GL_CONSTANT(STATIC_COPY);
-  JS_SET_GL_CONSTANT(DYNAMIC_READ);
-  JS_SET_GL_CONSTANT(DYNAMIC_COPY);
-  JS_SET_GL_CONSTANT(MAX_DRAW_BUFFERS);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER0);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER1);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER2);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER3);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER4);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER5);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER6);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER7);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER8);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER9);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER10);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER11);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER12);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER13);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER14);
-  JS_SET_GL_CONSTANT(DRAW_BUFFER15);
-  JS_SET_GL_CONSTANT(MAX_FRAGMENT_UNIFORM_COMPONENTS);
-  JS_SET_GL_CONSTANT(MAX_VERTEX_UNIFORM_COMPONENTS);
-  JS_SET_GL_CONSTANT(SAMPLER_3D);
-  JS_SET_GL_CONSTANT(SAMPLER_2D_SHADOW);
-  JS_SET_GL_CONSTANT(FRAGMENT_SHADER_DERIVATIVE_HINT);
-  JS_SET_GL_CONSTANT(PIXEL_PACK_BUFFER);
-  JS_SET_GL_CONSTANT(PIXEL_UNPACK_BUFFER);
-  JS_SET_GL_CONSTANT(PIXEL_PACK_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(PIXEL_UNPACK_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(FLOAT_MAT2x3);
-  JS_SET_GL_CONSTANT(FLOAT_MAT2x4);
-  JS_SET_GL_CONSTANT(FLOAT_MAT3x2);
-  JS_SET_GL_CONSTANT(FLOAT_MAT3x4);
-  JS_SET_GL_CONSTANT(FLOAT_MAT4x2);
-  JS_SET_GL_CONSTANT(FLOAT_MAT4x3);
-  JS_SET_GL_CONSTANT(SRGB);
-  JS_SET_GL_CONSTANT(SRGB8);
-  JS_SET_GL_CONSTANT(SRGB8_ALPHA8);
-  JS_SET_GL_CONSTANT(COMPARE_REF_TO_TEXTURE);
-  JS_SET_GL_CONSTANT(RGBA32F);
-  JS_SET_GL_CONSTANT(RGB32F);
-  JS_SET_GL_CONSTANT(RGBA16F);
-  JS_SET_GL_CONSTANT(RGB16F);
-  JS_SET_GL_CONSTANT(VERTEX_ATTRIB_ARRAY_INTEGER);
-  JS_SET_GL_CONSTANT(MAX_ARRAY_TEXTURE_LAYERS);
-  JS_SET_GL_CONSTANT(MIN_PROGRAM_TEXEL_OFFSET);
-  JS_SET_GL_CONSTANT(MAX_PROGRAM_TEXEL_OFFSET);
-  JS_SET_GL_CONSTANT(MAX_VARYING_COMPONENTS);
-  JS_SET_GL_CONSTANT(TEXTURE_2D_ARRAY);
-  JS_SET_GL_CONSTANT(TEXTURE_BINDING_2D_ARRAY);
-  JS_SET_GL_CONSTANT(R11F_G11F_B10F);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_10F_11F_11F_REV);
-  JS_SET_GL_CONSTANT(RGB9_E5);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_5_9_9_9_REV);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_MODE);
-  JS_SET_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_VARYINGS);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_START);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_SIZE);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-  JS_SET_GL_CONSTANT(RASTERIZER_DISCARD);
-  JS_SET_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS);
-  JS_SET_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_SEPARATE_ATTRIBS);
-  JS_SET_GL_CONSTANT(INTERLEAVED_ATTRIBS);
-  JS_SET_GL_CONSTANT(SEPARATE_ATTRIBS);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(RGBA32UI);
-  JS_SET_GL_CONSTANT(RGB32UI);
-  JS_SET_GL_CONSTANT(RGBA16UI);
-  JS_SET_GL_CONSTANT(RGB16UI);
-  JS_SET_GL_CONSTANT(RGBA8UI);
-  JS_SET_GL_CONSTANT(RGB8UI);
-  JS_SET_GL_CONSTANT(RGBA32I);
-  JS_SET_GL_CONSTANT(RGB32I);
-  JS_SET_GL_CONSTANT(RGBA16I);
-  JS_SET_GL_CONSTANT(RGB16I);
-  JS_SET_GL_CONSTANT(RGBA8I);
-  JS_SET_GL_CONSTANT(RGB8I);
-  JS_SET_GL_CONSTANT(RED_INTEGER);
-  JS_SET_GL_CONSTANT(RGB_INTEGER);
-  JS_SET_GL_CONSTANT(RGBA_INTEGER);
-  JS_SET_GL_CONSTANT(SAMPLER_2D_ARRAY);
-  JS_SET_GL_CONSTANT(SAMPLER_2D_ARRAY_SHADOW);
-  JS_SET_GL_CONSTANT(SAMPLER_CUBE_SHADOW);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_VEC2);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_VEC3);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_VEC4);
-  JS_SET_GL_CONSTANT(INT_SAMPLER_2D);
-  JS_SET_GL_CONSTANT(INT_SAMPLER_3D);
-  JS_SET_GL_CONSTANT(INT_SAMPLER_CUBE);
-  JS_SET_GL_CONSTANT(INT_SAMPLER_2D_ARRAY);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_SAMPLER_2D);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_SAMPLER_3D);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_SAMPLER_CUBE);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_SAMPLER_2D_ARRAY);
-  JS_SET_GL_CONSTANT(DEPTH_COMPONENT32F);
-  JS_SET_GL_CONSTANT(DEPTH32F_STENCIL8);
-  JS_SET_GL_CONSTANT(FLOAT_32_UNSIGNED_INT_24_8_REV);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_RED_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_GREEN_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_BLUE_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_DEFAULT);
-  JS_SET_GL_CONSTANT(UNSIGNED_INT_24_8);
-  JS_SET_GL_CONSTANT(DEPTH24_STENCIL8);
-  JS_SET_GL_CONSTANT(UNSIGNED_NORMALIZED);
-  JS_SET_GL_CONSTANT(DRAW_FRAMEBUFFER_BINDING);
-  JS_SET_GL_CONSTANT(READ_FRAMEBUFFER);
-  JS_SET_GL_CONSTANT(DRAW_FRAMEBUFFER);
-  JS_SET_GL_CONSTANT(READ_FRAMEBUFFER_BINDING);
-  JS_SET_GL_CONSTANT(RENDERBUFFER_SAMPLES);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_TEXTURE_LAYER);
-  JS_SET_GL_CONSTANT(MAX_COLOR_ATTACHMENTS);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT1);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT2);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT3);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT4);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT5);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT6);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT7);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT8);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT9);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT10);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT11);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT12);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT13);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT14);
-  JS_SET_GL_CONSTANT(COLOR_ATTACHMENT15);
-  JS_SET_GL_CONSTANT(FRAMEBUFFER_INCOMPLETE_MULTISAMPLE);
-  JS_SET_GL_CONSTANT(MAX_SAMPLES);
-  JS_SET_GL_CONSTANT(HALF_FLOAT);
-  JS_SET_GL_CONSTANT(RG);
-  JS_SET_GL_CONSTANT(RG_INTEGER);
-  JS_SET_GL_CONSTANT(R8);
-  JS_SET_GL_CONSTANT(RG8);
-  JS_SET_GL_CONSTANT(R16F);
-  JS_SET_GL_CONSTANT(R32F);
-  JS_SET_GL_CONSTANT(RG16F);
-  JS_SET_GL_CONSTANT(RG32F);
-  JS_SET_GL_CONSTANT(R8I);
-  JS_SET_GL_CONSTANT(R8UI);
-  JS_SET_GL_CONSTANT(R16I);
-  JS_SET_GL_CONSTANT(R16UI);
-  JS_SET_GL_CONSTANT(R32I);
-  JS_SET_GL_CONSTANT(R32UI);
-  JS_SET_GL_CONSTANT(RG8I);
-  JS_SET_GL_CONSTANT(RG8UI);
-  JS_SET_GL_CONSTANT(RG16I);
-  JS_SET_GL_CONSTANT(RG16UI);
-  JS_SET_GL_CONSTANT(RG32I);
-  JS_SET_GL_CONSTANT(RG32UI);
-  JS_SET_GL_CONSTANT(VERTEX_ARRAY_BINDING);
-  JS_SET_GL_CONSTANT(R8_SNORM);
-  JS_SET_GL_CONSTANT(RG8_SNORM);
-  JS_SET_GL_CONSTANT(RGB8_SNORM);
-  JS_SET_GL_CONSTANT(RGBA8_SNORM);
-  JS_SET_GL_CONSTANT(SIGNED_NORMALIZED);
-  JS_SET_GL_CONSTANT(COPY_READ_BUFFER);
-  JS_SET_GL_CONSTANT(COPY_WRITE_BUFFER);
-  JS_SET_GL_CONSTANT(COPY_READ_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(COPY_WRITE_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(UNIFORM_BUFFER);
-  JS_SET_GL_CONSTANT(UNIFORM_BUFFER_BINDING);
-  JS_SET_GL_CONSTANT(UNIFORM_BUFFER_START);
-  JS_SET_GL_CONSTANT(UNIFORM_BUFFER_SIZE);
-  JS_SET_GL_CONSTANT(MAX_VERTEX_UNIFORM_BLOCKS);
-  JS_SET_GL_CONSTANT(MAX_FRAGMENT_UNIFORM_BLOCKS);
-  JS_SET_GL_CONSTANT(MAX_COMBINED_UNIFORM_BLOCKS);
-  JS_SET_GL_CONSTANT(MAX_UNIFORM_BUFFER_BINDINGS);
-  JS_SET_GL_CONSTANT(MAX_UNIFORM_BLOCK_SIZE);
-  JS_SET_GL_CONSTANT(MAX_COMBINED_VERTEX_UNIFORM_COMPONENTS);
-  JS_SET_GL_CONSTANT(MAX_COMBINED_FRAGMENT_UNIFORM_COMPONENTS);
-  JS_SET_GL_CONSTANT(UNIFORM_BUFFER_OFFSET_ALIGNMENT);
-  JS_SET_GL_CONSTANT(ACTIVE_UNIFORM_BLOCKS);
-  JS_SET_GL_CONSTANT(UNIFORM_TYPE);
-  JS_SET_GL_CONSTANT(UNIFORM_SIZE);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_INDEX);
-  JS_SET_GL_CONSTANT(UNIFORM_OFFSET);
-  JS_SET_GL_CONSTANT(UNIFORM_ARRAY_STRIDE);
-  JS_SET_GL_CONSTANT(UNIFORM_MATRIX_STRIDE);
-  JS_SET_GL_CONSTANT(UNIFORM_IS_ROW_MAJOR);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_BINDING);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_DATA_SIZE);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_ACTIVE_UNIFORMS);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_REFERENCED_BY_VERTEX_SHADER);
-  JS_SET_GL_CONSTANT(UNIFORM_BLOCK_REFERENCED_BY_FRAGMENT_SHADER);
-  JS_SET_GL_CONSTANT(INVALID_INDEX);
-  JS_SET_GL_CONSTANT(MAX_VERTEX_OUTPUT_COMPONENTS);
-  JS_SET_GL_CONSTANT(MAX_FRAGMENT_INPUT_COMPONENTS);
-  JS_SET_GL_CONSTANT(MAX_SERVER_WAIT_TIMEOUT);
-  JS_SET_GL_CONSTANT(OBJECT_TYPE);
-  JS_SET_GL_CONSTANT(SYNC_CONDITION);
-  JS_SET_GL_CONSTANT(SYNC_STATUS);
-  JS_SET_GL_CONSTANT(SYNC_FLAGS);
-  JS_SET_GL_CONSTANT(SYNC_FENCE);
-  JS_SET_GL_CONSTANT(SYNC_GPU_COMMANDS_COMPLETE);
-  JS_SET_GL_CONSTANT(UNSIGNALED);
-  JS_SET_GL_CONSTANT(SIGNALED);
-  JS_SET_GL_CONSTANT(ALREADY_SIGNALED);
-  JS_SET_GL_CONSTANT(TIMEOUT_EXPIRED);
-  JS_SET_GL_CONSTANT(CONDITION_SATISFIED);
-  JS_SET_GL_CONSTANT(WAIT_FAILED);
-  JS_SET_GL_CONSTANT(SYNC_FLUSH_COMMANDS_BIT);
-  JS_SET_GL_CONSTANT(VERTEX_ATTRIB_ARRAY_DIVISOR);
-  JS_SET_GL_CONSTANT(ANY_SAMPLES_PASSED);
-  JS_SET_GL_CONSTANT(ANY_SAMPLES_PASSED_CONSERVATIVE);
-  JS_SET_GL_CONSTANT(SAMPLER_BINDING);
-  JS_SET_GL_CONSTANT(RGB10_A2UI);
-  JS_SET_GL_CONSTANT(INT_2_10_10_10_REV);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_PAUSED);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_ACTIVE);
-  JS_SET_GL_CONSTANT(TRANSFORM_FEEDBACK_BINDING);
-  JS_SET_GL_CONSTANT(TEXTURE_IMMUTABLE_FORMAT);
-  JS_SET_GL_CONSTANT(MAX_ELEMENT_INDEX);
-  JS_SET_GL_CONSTANT(TEXTURE_IMMUTABLE_LEVELS);
+  JS_WEBGL2_GL_CONSTANT(READ_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(UNPACK_ROW_LENGTH);
+  JS_WEBGL2_GL_CONSTANT(UNPACK_SKIP_ROWS);
+  JS_WEBGL2_GL_CONSTANT(UNPACK_SKIP_PIXELS);
+  JS_WEBGL2_GL_CONSTANT(PACK_ROW_LENGTH);
+  JS_WEBGL2_GL_CONSTANT(PACK_SKIP_ROWS);
+  JS_WEBGL2_GL_CONSTANT(PACK_SKIP_PIXELS);
+  JS_WEBGL2_GL_CONSTANT(COLOR);
+  JS_WEBGL2_GL_CONSTANT(DEPTH);
+  JS_WEBGL2_GL_CONSTANT(STENCIL);
+  JS_WEBGL2_GL_CONSTANT(RED);
+  JS_WEBGL2_GL_CONSTANT(RGB8);
+  JS_WEBGL2_GL_CONSTANT(RGB10_A2);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_BINDING_3D);
+  JS_WEBGL2_GL_CONSTANT(UNPACK_SKIP_IMAGES);
+  JS_WEBGL2_GL_CONSTANT(UNPACK_IMAGE_HEIGHT);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_3D);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_WRAP_R);
+  JS_WEBGL2_GL_CONSTANT(MAX_3D_TEXTURE_SIZE);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_2_10_10_10_REV);
+  JS_WEBGL2_GL_CONSTANT(MAX_ELEMENTS_VERTICES);
+  JS_WEBGL2_GL_CONSTANT(MAX_ELEMENTS_INDICES);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_MIN_LOD);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_MAX_LOD);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_BASE_LEVEL);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_MAX_LEVEL);
+  JS_WEBGL2_GL_CONSTANT(MIN);
+  JS_WEBGL2_GL_CONSTANT(MAX);
+  JS_WEBGL2_GL_CONSTANT(DEPTH_COMPONENT24);
+  JS_WEBGL2_GL_CONSTANT(MAX_TEXTURE_LOD_BIAS);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_COMPARE_MODE);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_COMPARE_FUNC);
+  JS_WEBGL2_GL_CONSTANT(CURRENT_QUERY);
+  JS_WEBGL2_GL_CONSTANT(QUERY_RESULT);
+  JS_WEBGL2_GL_CONSTANT(QUERY_RESULT_AVAILABLE);
+  JS_WEBGL2_GL_CONSTANT(STREAM_READ);
+  JS_WEBGL2_GL_CONSTANT(STREAM_COPY);
+  JS_WEBGL2_GL_CONSTANT(STATIC_READ);
+  JS_WEBGL2_GL_CONSTANT(STATIC_COPY);
+  JS_WEBGL2_GL_CONSTANT(DYNAMIC_READ);
+  JS_WEBGL2_GL_CONSTANT(DYNAMIC_COPY);
+  JS_WEBGL2_GL_CONSTANT(MAX_DRAW_BUFFERS);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER0);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER1);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER2);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER3);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER4);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER5);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER6);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER7);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER8);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER9);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER10);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER11);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER12);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER13);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER14);
+  JS_WEBGL2_GL_CONSTANT(DRAW_BUFFER15);
+  JS_WEBGL2_GL_CONSTANT(MAX_FRAGMENT_UNIFORM_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(MAX_VERTEX_UNIFORM_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_3D);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_2D_SHADOW);
+  JS_WEBGL2_GL_CONSTANT(FRAGMENT_SHADER_DERIVATIVE_HINT);
+  JS_WEBGL2_GL_CONSTANT(PIXEL_PACK_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(PIXEL_UNPACK_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(PIXEL_PACK_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(PIXEL_UNPACK_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT2x3);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT2x4);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT3x2);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT3x4);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT4x2);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_MAT4x3);
+  JS_WEBGL2_GL_CONSTANT(SRGB);
+  JS_WEBGL2_GL_CONSTANT(SRGB8);
+  JS_WEBGL2_GL_CONSTANT(SRGB8_ALPHA8);
+  JS_WEBGL2_GL_CONSTANT(COMPARE_REF_TO_TEXTURE);
+  JS_WEBGL2_GL_CONSTANT(RGBA32F);
+  JS_WEBGL2_GL_CONSTANT(RGB32F);
+  JS_WEBGL2_GL_CONSTANT(RGBA16F);
+  JS_WEBGL2_GL_CONSTANT(RGB16F);
+  JS_WEBGL2_GL_CONSTANT(VERTEX_ATTRIB_ARRAY_INTEGER);
+  JS_WEBGL2_GL_CONSTANT(MAX_ARRAY_TEXTURE_LAYERS);
+  JS_WEBGL2_GL_CONSTANT(MIN_PROGRAM_TEXEL_OFFSET);
+  JS_WEBGL2_GL_CONSTANT(MAX_PROGRAM_TEXEL_OFFSET);
+  JS_WEBGL2_GL_CONSTANT(MAX_VARYING_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_2D_ARRAY);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_BINDING_2D_ARRAY);
+  JS_WEBGL2_GL_CONSTANT(R11F_G11F_B10F);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_10F_11F_11F_REV);
+  JS_WEBGL2_GL_CONSTANT(RGB9_E5);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_5_9_9_9_REV);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_MODE);
+  JS_WEBGL2_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_SEPARATE_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_VARYINGS);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_START);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_SIZE);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+  JS_WEBGL2_GL_CONSTANT(RASTERIZER_DISCARD);
+  JS_WEBGL2_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(MAX_TRANSFORM_FEEDBACK_SEPARATE_ATTRIBS);
+  JS_WEBGL2_GL_CONSTANT(INTERLEAVED_ATTRIBS);
+  JS_WEBGL2_GL_CONSTANT(SEPARATE_ATTRIBS);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(RGBA32UI);
+  JS_WEBGL2_GL_CONSTANT(RGB32UI);
+  JS_WEBGL2_GL_CONSTANT(RGBA16UI);
+  JS_WEBGL2_GL_CONSTANT(RGB16UI);
+  JS_WEBGL2_GL_CONSTANT(RGBA8UI);
+  JS_WEBGL2_GL_CONSTANT(RGB8UI);
+  JS_WEBGL2_GL_CONSTANT(RGBA32I);
+  JS_WEBGL2_GL_CONSTANT(RGB32I);
+  JS_WEBGL2_GL_CONSTANT(RGBA16I);
+  JS_WEBGL2_GL_CONSTANT(RGB16I);
+  JS_WEBGL2_GL_CONSTANT(RGBA8I);
+  JS_WEBGL2_GL_CONSTANT(RGB8I);
+  JS_WEBGL2_GL_CONSTANT(RED_INTEGER);
+  JS_WEBGL2_GL_CONSTANT(RGB_INTEGER);
+  JS_WEBGL2_GL_CONSTANT(RGBA_INTEGER);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_2D_ARRAY);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_2D_ARRAY_SHADOW);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_CUBE_SHADOW);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_VEC2);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_VEC3);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_VEC4);
+  JS_WEBGL2_GL_CONSTANT(INT_SAMPLER_2D);
+  JS_WEBGL2_GL_CONSTANT(INT_SAMPLER_3D);
+  JS_WEBGL2_GL_CONSTANT(INT_SAMPLER_CUBE);
+  JS_WEBGL2_GL_CONSTANT(INT_SAMPLER_2D_ARRAY);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_SAMPLER_2D);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_SAMPLER_3D);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_SAMPLER_CUBE);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_SAMPLER_2D_ARRAY);
+  JS_WEBGL2_GL_CONSTANT(DEPTH_COMPONENT32F);
+  JS_WEBGL2_GL_CONSTANT(DEPTH32F_STENCIL8);
+  JS_WEBGL2_GL_CONSTANT(FLOAT_32_UNSIGNED_INT_24_8_REV);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_RED_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_GREEN_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_BLUE_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_DEFAULT);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_INT_24_8);
+  JS_WEBGL2_GL_CONSTANT(DEPTH24_STENCIL8);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNED_NORMALIZED);
+  JS_WEBGL2_GL_CONSTANT(DRAW_FRAMEBUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(READ_FRAMEBUFFER);
+  JS_WEBGL2_GL_CONSTANT(DRAW_FRAMEBUFFER);
+  JS_WEBGL2_GL_CONSTANT(READ_FRAMEBUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(RENDERBUFFER_SAMPLES);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_ATTACHMENT_TEXTURE_LAYER);
+  JS_WEBGL2_GL_CONSTANT(MAX_COLOR_ATTACHMENTS);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT1);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT2);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT3);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT4);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT5);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT6);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT7);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT8);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT9);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT10);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT11);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT12);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT13);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT14);
+  JS_WEBGL2_GL_CONSTANT(COLOR_ATTACHMENT15);
+  JS_WEBGL2_GL_CONSTANT(FRAMEBUFFER_INCOMPLETE_MULTISAMPLE);
+  JS_WEBGL2_GL_CONSTANT(MAX_SAMPLES);
+  JS_WEBGL2_GL_CONSTANT(HALF_FLOAT);
+  JS_WEBGL2_GL_CONSTANT(RG);
+  JS_WEBGL2_GL_CONSTANT(RG_INTEGER);
+  JS_WEBGL2_GL_CONSTANT(R8);
+  JS_WEBGL2_GL_CONSTANT(RG8);
+  JS_WEBGL2_GL_CONSTANT(R16F);
+  JS_WEBGL2_GL_CONSTANT(R32F);
+  JS_WEBGL2_GL_CONSTANT(RG16F);
+  JS_WEBGL2_GL_CONSTANT(RG32F);
+  JS_WEBGL2_GL_CONSTANT(R8I);
+  JS_WEBGL2_GL_CONSTANT(R8UI);
+  JS_WEBGL2_GL_CONSTANT(R16I);
+  JS_WEBGL2_GL_CONSTANT(R16UI);
+  JS_WEBGL2_GL_CONSTANT(R32I);
+  JS_WEBGL2_GL_CONSTANT(R32UI);
+  JS_WEBGL2_GL_CONSTANT(RG8I);
+  JS_WEBGL2_GL_CONSTANT(RG8UI);
+  JS_WEBGL2_GL_CONSTANT(RG16I);
+  JS_WEBGL2_GL_CONSTANT(RG16UI);
+  JS_WEBGL2_GL_CONSTANT(RG32I);
+  JS_WEBGL2_GL_CONSTANT(RG32UI);
+  JS_WEBGL2_GL_CONSTANT(VERTEX_ARRAY_BINDING);
+  JS_WEBGL2_GL_CONSTANT(R8_SNORM);
+  JS_WEBGL2_GL_CONSTANT(RG8_SNORM);
+  JS_WEBGL2_GL_CONSTANT(RGB8_SNORM);
+  JS_WEBGL2_GL_CONSTANT(RGBA8_SNORM);
+  JS_WEBGL2_GL_CONSTANT(SIGNED_NORMALIZED);
+  JS_WEBGL2_GL_CONSTANT(COPY_READ_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(COPY_WRITE_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(COPY_READ_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(COPY_WRITE_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BUFFER);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BUFFER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BUFFER_START);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BUFFER_SIZE);
+  JS_WEBGL2_GL_CONSTANT(MAX_VERTEX_UNIFORM_BLOCKS);
+  JS_WEBGL2_GL_CONSTANT(MAX_FRAGMENT_UNIFORM_BLOCKS);
+  JS_WEBGL2_GL_CONSTANT(MAX_COMBINED_UNIFORM_BLOCKS);
+  JS_WEBGL2_GL_CONSTANT(MAX_UNIFORM_BUFFER_BINDINGS);
+  JS_WEBGL2_GL_CONSTANT(MAX_UNIFORM_BLOCK_SIZE);
+  JS_WEBGL2_GL_CONSTANT(MAX_COMBINED_VERTEX_UNIFORM_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(MAX_COMBINED_FRAGMENT_UNIFORM_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+  JS_WEBGL2_GL_CONSTANT(ACTIVE_UNIFORM_BLOCKS);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_TYPE);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_SIZE);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_INDEX);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_OFFSET);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_ARRAY_STRIDE);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_MATRIX_STRIDE);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_IS_ROW_MAJOR);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_BINDING);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_DATA_SIZE);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_ACTIVE_UNIFORMS);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_REFERENCED_BY_VERTEX_SHADER);
+  JS_WEBGL2_GL_CONSTANT(UNIFORM_BLOCK_REFERENCED_BY_FRAGMENT_SHADER);
+  JS_WEBGL2_GL_CONSTANT(INVALID_INDEX);
+  JS_WEBGL2_GL_CONSTANT(MAX_VERTEX_OUTPUT_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(MAX_FRAGMENT_INPUT_COMPONENTS);
+  JS_WEBGL2_GL_CONSTANT(MAX_SERVER_WAIT_TIMEOUT);
+  JS_WEBGL2_GL_CONSTANT(OBJECT_TYPE);
+  JS_WEBGL2_GL_CONSTANT(SYNC_CONDITION);
+  JS_WEBGL2_GL_CONSTANT(SYNC_STATUS);
+  JS_WEBGL2_GL_CONSTANT(SYNC_FLAGS);
+  JS_WEBGL2_GL_CONSTANT(SYNC_FENCE);
+  JS_WEBGL2_GL_CONSTANT(SYNC_GPU_COMMANDS_COMPLETE);
+  JS_WEBGL2_GL_CONSTANT(UNSIGNALED);
+  JS_WEBGL2_GL_CONSTANT(SIGNALED);
+  JS_WEBGL2_GL_CONSTANT(ALREADY_SIGNALED);
+  JS_WEBGL2_GL_CONSTANT(TIMEOUT_EXPIRED);
+  JS_WEBGL2_GL_CONSTANT(CONDITION_SATISFIED);
+  JS_WEBGL2_GL_CONSTANT(WAIT_FAILED);
+  JS_WEBGL2_GL_CONSTANT(SYNC_FLUSH_COMMANDS_BIT);
+  JS_WEBGL2_GL_CONSTANT(VERTEX_ATTRIB_ARRAY_DIVISOR);
+  JS_WEBGL2_GL_CONSTANT(ANY_SAMPLES_PASSED);
+  JS_WEBGL2_GL_CONSTANT(ANY_SAMPLES_PASSED_CONSERVATIVE);
+  JS_WEBGL2_GL_CONSTANT(SAMPLER_BINDING);
+  JS_WEBGL2_GL_CONSTANT(RGB10_A2UI);
+  JS_WEBGL2_GL_CONSTANT(INT_2_10_10_10_REV);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_PAUSED);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_ACTIVE);
+  JS_WEBGL2_GL_CONSTANT(TRANSFORM_FEEDBACK_BINDING);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_IMMUTABLE_FORMAT);
+  JS_WEBGL2_GL_CONSTANT(MAX_ELEMENT_INDEX);
+  JS_WEBGL2_GL_CONSTANT(TEXTURE_IMMUTABLE_LEVELS);
 
-  JS_SET_CONSTANT(TIMEOUT_IGNORED, -1);
+  JS_WEBGL2_CONSTANT(TIMEOUT_IGNORED, -1);
 
   /* WebGL 2-specific enums */
-  JS_SET_CONSTANT(MAX_CLIENT_WAIT_TIMEOUT_WEBGL, 0x9247);
+  JS_WEBGL2_CONSTANT(MAX_CLIENT_WAIT_TIMEOUT_WEBGL, 0x9247);
 
   /* WebGL 2 constant shared with an extension */
-  JS_SET_GL_CONSTANT(RGBA8);
+  JS_WEBGL2_GL_CONSTANT(RGBA8);
 }
 
 NODE_MODULE(webgl, Init)
@@ -1,10 +1,14 @@
 #include <array>
+#include <cassert>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <vector>
 
+#include "PixelKernels.h"
+#include "PngEncoder.h"
+#include "ProgramCache.h"
 #include "webgl.h"
 
 const char *GetDebugMessageSourceString(GLenum source) {
@@ -143,8 +147,10 @@ std::string JoinStringSet(const std::set<std::string> &inputSet,
   return oss.str();
 }
 
-bool WebGLRenderingContext::HAS_DISPLAY = false;
-EGLDisplay WebGLRenderingContext::DISPLAY;
+SharedLibrary WebGLRenderingContext::EGL_LIBRARY;
+std::map<std::string, EGLDisplay> WebGLRenderingContext::DISPLAYS;
+std::map<std::pair<EGLDisplay, EGLConfig>, EGLSurface> WebGLRenderingContext::SURFACES;
+SharedProgramCache WebGLRenderingContext::SHARED_PROGRAMS;
 WebGLRenderingContext *WebGLRenderingContext::ACTIVE = NULL;
 WebGLRenderingContext *WebGLRenderingContext::CONTEXT_LIST_HEAD = NULL;
 
@@ -158,6 +164,9 @@ WebGLRenderingContext *WebGLRenderingContext::CONTEXT_LIST_HEAD = NULL;
   WebGLRenderingContext *inst = node::ObjectWrap::Unwrap<WebGLRenderingContext>(info.This());      \
   if (!(inst && inst->setActive())) {                                                              \
     return Nan::ThrowError("Invalid GL context");                                                  \
+  }                                                                                                \
+  if (inst->commandWords && inst->commandWords[0] > 0) {                                           \
+    inst->flushCommands();                                                                         \
   }
 
 bool ContextSupportsExtensions(WebGLRenderingContext *inst,
@@ -171,6 +180,99 @@ bool ContextSupportsExtensions(WebGLRenderingContext *inst,
   return true;
 }
 
+// Maps a backend name to the EGL_PLATFORM_ANGLE_TYPE_ANGLE and
+// EGL_PLATFORM_ANGLE_DEVICE_TYPE_ANGLE attributes passed to eglGetPlatformDisplay.
+// A device type of EGL_NONE means ANGLE picks the device.
+struct ANGLEBackend {
+  const char *name;
+  EGLAttrib platformType;
+  EGLAttrib deviceType;
+};
+
+static const ANGLEBackend ANGLE_BACKENDS[] = {
+    {"swiftshader", EGL_PLATFORM_ANGLE_TYPE_VULKAN_ANGLE,
+     EGL_PLATFORM_ANGLE_DEVICE_TYPE_SWIFTSHADER_ANGLE},
+    {"vulkan", EGL_PLATFORM_ANGLE_TYPE_VULKAN_ANGLE, EGL_NONE},
+    {"gl", EGL_PLATFORM_ANGLE_TYPE_OPENGL_ANGLE, EGL_NONE},
+    {"gles", EGL_PLATFORM_ANGLE_TYPE_OPENGLES_ANGLE, EGL_NONE},
+    {"d3d11", EGL_PLATFORM_ANGLE_TYPE_D3D11_ANGLE, EGL_NONE},
+    {"metal", EGL_PLATFORM_ANGLE_TYPE_METAL_ANGLE, EGL_NONE},
+    {"null", EGL_PLATFORM_ANGLE_TYPE_NULL_ANGLE, EGL_PLATFORM_ANGLE_DEVICE_TYPE_NULL_ANGLE},
+};
+
+EGLDisplay WebGLRenderingContext::GetDisplay(const std::string &backend,
+                                             std::string &errorMessage) {
+  auto cached = DISPLAYS.find(backend);
+  if (cached != DISPLAYS.end()) {
+    return cached->second;
+  }
+
+  EGLDisplay display = EGL_NO_DISPLAY;
+  if (backend == "default") {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  } else {
+    const ANGLEBackend *match = NULL;
+    for (const ANGLEBackend &candidate : ANGLE_BACKENDS) {
+      if (backend == candidate.name) {
+        match = &candidate;
+        break;
+      }
+    }
+    if (!match) {
+      errorMessage = "Unknown ANGLE backend '" + backend + "'.";
+      return EGL_NO_DISPLAY;
+    }
+
+    std::vector<EGLAttrib> displayAttribs = {EGL_PLATFORM_ANGLE_TYPE_ANGLE, match->platformType};
+    if (match->deviceType != EGL_NONE) {
+      displayAttribs.push_back(EGL_PLATFORM_ANGLE_DEVICE_TYPE_ANGLE);
+      displayAttribs.push_back(match->deviceType);
+    }
+    displayAttribs.push_back(EGL_NONE);
+    display = eglGetPlatformDisplay(EGL_PLATFORM_ANGLE_ANGLE,
+                                    reinterpret_cast<void *>(EGL_DEFAULT_DISPLAY),
+                                    displayAttribs.data());
+  }
+  if (display == EGL_NO_DISPLAY) {
+    errorMessage = "Error retrieving EGL display for backend '" + backend + "'.";
+    return EGL_NO_DISPLAY;
+  }
+
+  // Initialize EGL
+  if (!eglInitialize(display, NULL, NULL)) {
+    errorMessage = "Error initializing EGL for backend '" + backend + "'.";
+    return EGL_NO_DISPLAY;
+  }
+
+  DISPLAYS[backend] = display;
+  ProgramCache::Attach(display);
+  return display;
+}
+
+bool WebGLRenderingContext::GetSurface(EGLDisplay display, EGLConfig config, EGLSurface &surface,
+                                       std::string &errorMessage) {
+  std::pair<EGLDisplay, EGLConfig> key(display, config);
+  auto cached = SURFACES.find(key);
+  if (cached != SURFACES.end()) {
+    surface = cached->second;
+    return true;
+  }
+
+  surface = EGL_NO_SURFACE;
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+    EGLint surfaceAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+      errorMessage = "Error creating EGL surface.";
+      return false;
+    }
+  }
+
+  SURFACES[key] = surface;
+  return true;
+}
+
 bool CaseInsensitiveCompare(const std::string &a, const std::string &b) {
   std::string aLower = a;
   std::string bLower = b;
@@ -181,45 +283,35 @@ bool CaseInsensitiveCompare(const std::string &a, const std::string &b) {
   return aLower < bLower;
 };
 
-WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha, bool depth,
-                                             bool stencil, bool antialias, bool premultipliedAlpha,
+WebGLRenderingContext::WebGLRenderingContext(bool alpha, bool depth, bool stencil,
+                                             bool antialias, bool premultipliedAlpha,
                                              bool preserveDrawingBuffer,
                                              bool preferLowPowerToHighPerformance,
                                              bool failIfMajorPerformanceCaveat,
-                                             bool createWebGL2Context)
-    : state(GLCONTEXT_STATE_INIT), unpack_flip_y(false), unpack_premultiply_alpha(false),
-      unpack_colorspace_conversion(0x9244), unpack_alignment(4),
-      webGLToANGLEExtensions(&CaseInsensitiveCompare), next(NULL), prev(NULL) {
+                                             bool createWebGL2Context,
+                                             const std::string &backend)
+    : display(EGL_NO_DISPLAY), state(GLCONTEXT_STATE_INIT), isWebGL2(createWebGL2Context),
+      unpack_flip_y(false), unpack_premultiply_alpha(false), unpack_colorspace_conversion(0x9244),
+      unpack_alignment(4), webGLToANGLEExtensions(&CaseInsensitiveCompare), next(NULL),
+      prev(NULL), nextReadback(0), errorBits(0), requestedExtensions(false), commandWords(NULL),
+      commandCapacity(0) {
 
   if (!eglGetProcAddress) {
-    if (!eglLibrary.open("libEGL")) {
+    if (!EGL_LIBRARY.open("libEGL")) {
       errorMessage = "Error opening ANGLE shared library.";
       state = GLCONTEXT_STATE_ERROR;
       return;
     }
 
-    auto getProcAddress = eglLibrary.getFunction<PFNEGLGETPROCADDRESSPROC>("eglGetProcAddress");
+    auto getProcAddress = EGL_LIBRARY.getFunction<PFNEGLGETPROCADDRESSPROC>("eglGetProcAddress");
     ::LoadEGL(getProcAddress);
   }
 
   // Get display
-  if (!HAS_DISPLAY) {
-    DISPLAY = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    if (DISPLAY == EGL_NO_DISPLAY) {
-      errorMessage = "Error retrieving EGL default display.";
-      state = GLCONTEXT_STATE_ERROR;
-      return;
-    }
-
-    // Initialize EGL
-    if (!eglInitialize(DISPLAY, NULL, NULL)) {
-      errorMessage = "Error initializing EGL.";
-      state = GLCONTEXT_STATE_ERROR;
-      return;
-    }
-
-    // Save display
-    HAS_DISPLAY = true;
+  display = GetDisplay(backend, errorMessage);
+  if (display == EGL_NO_DISPLAY) {
+    state = GLCONTEXT_STATE_ERROR;
+    return;
   }
 
   // Set up configuration
@@ -242,7 +334,7 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
                           renderableTypeBit,
                           EGL_NONE};
   EGLint num_config;
-  if (!eglChooseConfig(DISPLAY, attrib_list, &config, 1, &num_config) || num_config != 1) {
+  if (!eglChooseConfig(display, attrib_list, &config, 1, &num_config) || num_config != 1) {
     errorMessage = "Error choosing EGL config.";
     state = GLCONTEXT_STATE_ERROR;
     return;
@@ -258,23 +350,22 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
                              EGL_ROBUST_RESOURCE_INITIALIZATION_ANGLE,
                              EGL_TRUE,
                              EGL_NONE};
-  context = eglCreateContext(DISPLAY, config, EGL_NO_CONTEXT, contextAttribs);
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
   if (context == EGL_NO_CONTEXT) {
     state = GLCONTEXT_STATE_ERROR;
     return;
   }
 
-  EGLint surfaceAttribs[] = {EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE};
-  surface = eglCreatePbufferSurface(DISPLAY, config, surfaceAttribs);
-  if (surface == EGL_NO_SURFACE) {
-    errorMessage = "Error creating EGL surface.";
+  if (!GetSurface(display, config, surface, errorMessage)) {
+    eglDestroyContext(display, context);
     state = GLCONTEXT_STATE_ERROR;
     return;
   }
 
   // Set active
-  if (!eglMakeCurrent(DISPLAY, surface, surface, context)) {
+  if (!eglMakeCurrent(display, surface, surface, context)) {
     errorMessage = "Error making context current.";
+    eglDestroyContext(display, context);
     state = GLCONTEXT_STATE_ERROR;
     return;
   }
@@ -284,7 +375,12 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
   registerContext();
   ACTIVE = this;
 
-  LoadGLES(eglGetProcAddress);
+  // ANGLE hands out the same GLES entry points for every display and context, so they only need
+  // to be resolved once, with the first context made current
+  if (!glGetString) {
+    LoadGLES(eglGetProcAddress);
+  }
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &stateCache.textureUnits);
 
   // Enable the debug callback to debug GL errors.
   // EnableDebugCallback(nullptr);
@@ -317,9 +413,13 @@ WebGLRenderingContext::WebGLRenderingContext(int width, int height, bool alpha,
   // Each WebGL extension maps to one or more required ANGLE extensions.
   webGLToANGLEExtensions.insert({"STACKGL_destroy_context", {}});
   webGLToANGLEExtensions.insert({"STACKGL_resize_drawingbuffer", {}});
+  webGLToANGLEExtensions.insert({"STACKGL_state_cache", {}});
+  webGLToANGLEExtensions.insert({"STACKGL_scratch_memory", {}});
   webGLToANGLEExtensions.insert(
       {"EXT_texture_filter_anisotropic", {"GL_EXT_texture_filter_anisotropic"}});
   webGLToANGLEExtensions.insert({"OES_texture_float_linear", {"GL_OES_texture_float_linear"}});
+  webGLToANGLEExtensions.insert(
+      {"KHR_parallel_shader_compile", {"GL_KHR_parallel_shader_compile"}});
   if (createWebGL2Context) {
     webGLToANGLEExtensions.insert({"EXT_color_buffer_float", {"GL_EXT_color_buffer_float"}});
   } else {
@@ -351,7 +451,7 @@ bool WebGLRenderingContext::setActive() {
   if (this == ACTIVE) {
     return true;
   }
-  if (!eglMakeCurrent(DISPLAY, surface, surface, context)) {
+  if (!eglMakeCurrent(display, surface, surface, context)) {
     state = GLCONTEXT_STATE_ERROR;
     return false;
   }
@@ -359,26 +459,293 @@ bool WebGLRenderingContext::setActive() {
   return true;
 }
 
+// Error codes in the order getError() reports them, indexed by errorBits bit.
+static const GLenum ERROR_CODES[] = {
+    GL_INVALID_ENUM,   GL_INVALID_VALUE,      GL_INVALID_OPERATION, GL_OUT_OF_MEMORY,
+    GL_INVALID_FRAMEBUFFER_OPERATION, 0x9242, // CONTEXT_LOST_WEBGL
+};
+static const size_t ERROR_CODE_COUNT = sizeof(ERROR_CODES) / sizeof(ERROR_CODES[0]);
+
 void WebGLRenderingContext::setError(GLenum error) {
-  if (error == GL_NO_ERROR || errorSet.count(error) > 0) {
+  for (size_t i = 0; i < ERROR_CODE_COUNT; ++i) {
+    if (ERROR_CODES[i] == error) {
+      errorBits |= 1u << i;
+      return;
+    }
+  }
+}
+
+void WebGLRenderingContext::beginCheckedCall() {
+  for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+    setError(error);
+  }
+}
+
+GLenum WebGLRenderingContext::endCheckedCall() {
+  GLenum result = glGetError();
+  if (result != GL_NO_ERROR) {
+    setError(result);
+    beginCheckedCall();
+  }
+  return result;
+}
+
+// Two specific enums are accepted by ANGLE when they shouldn't be. This shows up
+// for headless, but not browsers, because browsers do additional validation.
+// The ANGLE fix is to make EXT_multisample_compatibility "enableable".
+bool IsBuggedANGLECap(GLenum cap) { return cap == GL_MULTISAMPLE || cap == GL_SAMPLE_ALPHA_TO_ONE; }
+
+// Redundant state elimination
+//
+// The cached* methods forward a call to GL only if the shadow in stateCache says it would change
+// something. A value is only recorded once the call is known to have succeeded, otherwise a
+// repeated invalid call would be dropped instead of raising its error again.
+
+void GLStateCache::invalidate() {
+  activeTexture = UNKNOWN;
+  for (GLint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+    for (int target = 0; target < GLSTATE_TEXTURE_TARGET_COUNT; ++target) {
+      textures[unit][target] = UNKNOWN;
+    }
+  }
+  arrayBuffer = UNKNOWN;
+  elementArrayBuffer = UNKNOWN;
+  program = UNKNOWN;
+  capsKnown = 0;
+  capsEnabled = 0;
+  for (int i = 0; i < 4; ++i) {
+    blendFunc[i] = UNKNOWN;
+  }
+  depthFunc = UNKNOWN;
+  viewport[2] = -1;
+  scissor[2] = -1;
+}
+
+// Deleting a bound buffer or texture reverts the binding to 0, and the name may be handed out
+// again by the next create call, so the old entry must not produce a hit for the new object.
+void GLStateCache::forgetBuffer(GLuint buffer) {
+  if (arrayBuffer == buffer) {
+    arrayBuffer = UNKNOWN;
+  }
+  if (elementArrayBuffer == buffer) {
+    elementArrayBuffer = UNKNOWN;
+  }
+}
+
+void GLStateCache::forgetTexture(GLuint texture) {
+  for (GLint unit = 0; unit < MAX_TEXTURE_UNITS; ++unit) {
+    for (int target = 0; target < GLSTATE_TEXTURE_TARGET_COUNT; ++target) {
+      if (textures[unit][target] == texture) {
+        textures[unit][target] = UNKNOWN;
+      }
+    }
+  }
+}
+
+void GLStateCache::forgetProgram(GLuint prog) {
+  if (program == prog) {
+    program = UNKNOWN;
+  }
+}
+
+GLuint *GLStateCache::textureBinding(GLenum target) {
+  if (activeTexture == UNKNOWN) {
+    return NULL;
+  }
+  GLint unit = static_cast<GLint>(activeTexture - GL_TEXTURE0);
+  if (unit >= MAX_TEXTURE_UNITS) {
+    return NULL;
+  }
+  switch (target) {
+  case GL_TEXTURE_2D:
+    return &textures[unit][GLSTATE_TEXTURE_2D];
+  case GL_TEXTURE_CUBE_MAP:
+    return &textures[unit][GLSTATE_TEXTURE_CUBE_MAP];
+  case GL_TEXTURE_3D:
+    return &textures[unit][GLSTATE_TEXTURE_3D];
+  case GL_TEXTURE_2D_ARRAY:
+    return &textures[unit][GLSTATE_TEXTURE_2D_ARRAY];
+  default:
+    return NULL;
+  }
+}
+
+// Bit of a capability in GLStateCache::capsKnown and capsEnabled, or 0 if it is not tracked
+static uint32_t CapabilityBit(GLenum cap, bool isWebGL2) {
+  switch (cap) {
+  case GL_BLEND:
+    return 1u << 0;
+  case GL_CULL_FACE:
+    return 1u << 1;
+  case GL_DEPTH_TEST:
+    return 1u << 2;
+  case GL_DITHER:
+    return 1u << 3;
+  case GL_POLYGON_OFFSET_FILL:
+    return 1u << 4;
+  case GL_SAMPLE_ALPHA_TO_COVERAGE:
+    return 1u << 5;
+  case GL_SAMPLE_COVERAGE:
+    return 1u << 6;
+  case GL_SCISSOR_TEST:
+    return 1u << 7;
+  case GL_STENCIL_TEST:
+    return 1u << 8;
+  case GL_RASTERIZER_DISCARD:
+    return isWebGL2 ? 1u << 9 : 0;
+  default:
+    return 0;
+  }
+}
+
+void WebGLRenderingContext::cachedActiveTexture(GLenum texture) {
+  if (stateCache.activeTexture == texture) {
+    stateCache.hits++;
     return;
   }
-  errorSet.insert(error);
+  stateCache.misses++;
+  glActiveTexture(texture);
+  if (texture >= GL_TEXTURE0 &&
+      texture < GL_TEXTURE0 + static_cast<GLenum>(stateCache.textureUnits)) {
+    stateCache.activeTexture = texture;
+  }
 }
 
-void WebGLRenderingContext::dispose() {
-  // Unregister context
-  unregisterContext();
+void WebGLRenderingContext::cachedBindBuffer(GLenum target, GLuint buffer) {
+  GLuint *binding = NULL;
+  if (target == GL_ARRAY_BUFFER) {
+    binding = &stateCache.arrayBuffer;
+  } else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    binding = &stateCache.elementArrayBuffer;
+  }
+  if (binding && *binding == buffer && buffer != GLStateCache::UNKNOWN) {
+    stateCache.hits++;
+    return;
+  }
+  stateCache.misses++;
+  // Only record the binding once GL accepted it, like the other cached binds
+  beginCheckedCall();
+  glBindBuffer(target, buffer);
+  if (endCheckedCall() == GL_NO_ERROR && binding) {
+    *binding = buffer;
+  }
+}
 
-  if (!setActive()) {
-    state = GLCONTEXT_STATE_ERROR;
+GLenum WebGLRenderingContext::cachedBindTexture(GLenum target, GLuint texture) {
+  GLuint *binding = stateCache.textureBinding(target);
+  if (binding && *binding == texture && texture != GLStateCache::UNKNOWN) {
+    stateCache.hits++;
+    return GL_NO_ERROR;
+  }
+  stateCache.misses++;
+  beginCheckedCall();
+  glBindTexture(target, texture);
+  GLenum error = endCheckedCall();
+  if (binding && error == GL_NO_ERROR) {
+    *binding = texture;
+  }
+  return error;
+}
+
+void WebGLRenderingContext::cachedUseProgram(GLuint program) {
+  if (stateCache.program == program && program != GLStateCache::UNKNOWN) {
+    stateCache.hits++;
     return;
   }
+  stateCache.misses++;
+  // Using a program whose last link failed is an error the JS layer does not catch
+  beginCheckedCall();
+  glUseProgram(program);
+  if (endCheckedCall() == GL_NO_ERROR) {
+    stateCache.program = program;
+  }
+}
 
-  // Update state
-  state = GLCONTEXT_STATE_DESTROY;
+void WebGLRenderingContext::cachedSetCapability(GLenum cap, bool enabled) {
+  if (IsBuggedANGLECap(cap)) {
+    setError(GL_INVALID_ENUM);
+    return;
+  }
+  uint32_t bit = CapabilityBit(cap, isWebGL2);
+  if ((stateCache.capsKnown & bit) && ((stateCache.capsEnabled & bit) != 0) == enabled) {
+    stateCache.hits++;
+    return;
+  }
+  stateCache.misses++;
+  if (enabled) {
+    glEnable(cap);
+    stateCache.capsEnabled |= bit;
+  } else {
+    glDisable(cap);
+    stateCache.capsEnabled &= ~bit;
+  }
+  stateCache.capsKnown |= bit;
+}
 
-  // Destroy all object references
+void WebGLRenderingContext::cachedBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB,
+                                                    GLenum srcAlpha, GLenum dstAlpha) {
+  GLenum *blendFunc = stateCache.blendFunc;
+  if (blendFunc[0] == srcRGB && blendFunc[1] == dstRGB && blendFunc[2] == srcAlpha &&
+      blendFunc[3] == dstAlpha) {
+    stateCache.hits++;
+    return;
+  }
+  stateCache.misses++;
+  glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+  // The JS layer validates the factors, except that WebGL 1 rejects SRC_ALPHA_SATURATE as a
+  // destination factor, so calls using it are never recorded
+  if (srcRGB == GL_SRC_ALPHA_SATURATE || dstRGB == GL_SRC_ALPHA_SATURATE ||
+      srcAlpha == GL_SRC_ALPHA_SATURATE || dstAlpha == GL_SRC_ALPHA_SATURATE) {
+    blendFunc[0] = GLStateCache::UNKNOWN;
+    return;
+  }
+  blendFunc[0] = srcRGB;
+  blendFunc[1] = dstRGB;
+  blendFunc[2] = srcAlpha;
+  blendFunc[3] = dstAlpha;
+}
+
+void WebGLRenderingContext::cachedDepthFunc(GLenum func) {
+  if (stateCache.depthFunc == func) {
+    stateCache.hits++;
+    return;
+  }
+  stateCache.misses++;
+  glDepthFunc(func);
+  if (func >= GL_NEVER && func <= GL_ALWAYS) {
+    stateCache.depthFunc = func;
+  }
+}
+
+// Updates a cached viewport or scissor rectangle, returns false if it already matched. Negative
+// sizes raise INVALID_VALUE and leave the rectangle unknown.
+static bool UpdateCachedRect(GLStateCache &cache, GLint *rect, GLint x, GLint y, GLsizei width,
+                             GLsizei height) {
+  if (width >= 0 && rect[0] == x && rect[1] == y && rect[2] == width && rect[3] == height) {
+    cache.hits++;
+    return false;
+  }
+  cache.misses++;
+  rect[0] = x;
+  rect[1] = y;
+  rect[2] = width < 0 || height < 0 ? -1 : width;
+  rect[3] = height;
+  return true;
+}
+
+void WebGLRenderingContext::cachedViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (UpdateCachedRect(stateCache, stateCache.viewport, x, y, width, height)) {
+    glViewport(x, y, width, height);
+  }
+}
+
+void WebGLRenderingContext::cachedScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+  if (UpdateCachedRect(stateCache, stateCache.scissor, x, y, width, height)) {
+    glScissor(x, y, width, height);
+  }
+}
+
+void WebGLRenderingContext::deleteObjects() {
   for (std::map<std::pair<GLuint, GLObjectType>, bool>::iterator iter = objects.begin();
        iter != objects.end(); ++iter) {
 
@@ -406,20 +773,179 @@ void WebGLRenderingContext::dispose() {
     case GLOBJECT_TYPE_VERTEX_ARRAY:
       glDeleteVertexArraysOES(1, &obj);
       break;
+    case GLOBJECT_TYPE_QUERY:
+      glDeleteQueries(1, &obj);
+      break;
+    case GLOBJECT_TYPE_SAMPLER:
+      glDeleteSamplers(1, &obj);
+      break;
+    case GLOBJECT_TYPE_TRANSFORM_FEEDBACK:
+      glDeleteTransformFeedbacks(1, &obj);
+      break;
     default:
       break;
     }
   }
+  objects.clear();
+
+  shaderSources.clear();
+  compiledSources.clear();
+  attribBindings.clear();
+  feedbackVaryings.clear();
+  unsharedPrograms.clear();
+}
+
+// Returns false, leaving the context untouched, if it cannot be handed to another user
+bool WebGLRenderingContext::resetState() {
+  if (requestedExtensions) {
+    return false;
+  }
+  finishUploads();
+  releaseReadbacks();
+
+  // Unbind everything first so deleted names cannot linger in any binding point
+  glUseProgram(0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  if (isWebGL2) {
+    glBindVertexArray(0);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  } else if (enabledExtensions.count("GL_OES_vertex_array_object")) {
+    glBindVertexArrayOES(0);
+  }
+
+  GLint numTextureUnits = 0;
+  glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &numTextureUnits);
+  for (GLint i = numTextureUnits - 1; i >= 0; --i) {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    if (isWebGL2) {
+      glBindTexture(GL_TEXTURE_3D, 0);
+      glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+      glBindSampler(i, 0);
+    }
+  }
+
+  deleteObjects();
+
+  // Vertex attributes
+  GLint numAttribs = 0;
+  glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &numAttribs);
+  for (GLint i = 0; i < numAttribs; ++i) {
+    glDisableVertexAttribArray(i);
+    glVertexAttrib4f(i, 0, 0, 0, 1);
+    if (isWebGL2) {
+      glVertexAttribDivisor(i, 0);
+    } else if (enabledExtensions.count("GL_ANGLE_instanced_arrays")) {
+      glVertexAttribDivisorANGLE(i, 0);
+    }
+  }
+
+  // Capabilities
+  glDisable(GL_BLEND);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_DITHER);
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+  glDisable(GL_SAMPLE_COVERAGE);
+  glDisable(GL_SCISSOR_TEST);
+  glDisable(GL_STENCIL_TEST);
+  if (isWebGL2) {
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
+
+  // Fixed function state
+  glBlendColor(0, 0, 0, 0);
+  glBlendEquation(GL_FUNC_ADD);
+  glBlendFunc(GL_ONE, GL_ZERO);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glCullFace(GL_BACK);
+  glDepthFunc(GL_LESS);
+  glDepthMask(GL_TRUE);
+  glDepthRangef(0, 1);
+  glFrontFace(GL_CCW);
+  glHint(GL_GENERATE_MIPMAP_HINT, GL_DONT_CARE);
+  glLineWidth(1);
+  glPolygonOffset(0, 0);
+  glSampleCoverage(1, GL_FALSE);
+  glStencilFunc(GL_ALWAYS, 0, 0xffffffff);
+  glStencilMask(0xffffffff);
+  glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+  glClearColor(0, 0, 0, 0);
+  glClearDepthf(1);
+  glClearStencil(0);
+
+  // Pixel storage
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (isWebGL2) {
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_PACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_PACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_IMAGE_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_IMAGES, 0);
+  }
+  unpack_flip_y = false;
+  unpack_premultiply_alpha = false;
+  unpack_colorspace_conversion = 0x9244;
+  unpack_alignment = 4;
+
+  // The next user starts with an empty shadow and fresh counters
+  stateCache.invalidate();
+  stateCache.hits = 0;
+  stateCache.misses = 0;
+  scratch.resetStats();
+
+  // Drop any errors generated by the reset and any left over from the previous user
+  errorBits = 0;
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  return true;
+}
+
+void WebGLRenderingContext::dispose() {
+  // Unregister context
+  unregisterContext();
+  scratch.clear();
+
+  if (!setActive()) {
+    state = GLCONTEXT_STATE_ERROR;
+    return;
+  }
+
+  // Update state
+  state = GLCONTEXT_STATE_DESTROY;
+  commandWords = NULL;
+  commandBuffer.Reset();
+
+  // Let pending uploads finish before their buffers go away
+  finishUploads();
+  releaseUploads();
+  releaseReadbacks();
+
+  // Destroy all object references
+  deleteObjects();
+  stateCache.invalidate();
 
   // Deactivate context
-  eglMakeCurrent(DISPLAY, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
   ACTIVE = NULL;
 
-  // Destroy surface and context
-
-  // FIXME:  This shouldn't be commented out
-  // eglDestroySurface(DISPLAY, surface);
-  eglDestroyContext(DISPLAY, context);
+  // Destroy the context, its surface is shared and destroyed by DisposeAll
+  eglDestroyContext(display, context);
 }
 
 WebGLRenderingContext::~WebGLRenderingContext() { dispose(); }
@@ -436,29 +962,82 @@ GL_METHOD(DisposeAll) {
     CONTEXT_LIST_HEAD->dispose();
   }
 
-  if (WebGLRenderingContext::HAS_DISPLAY) {
-    eglTerminate(WebGLRenderingContext::DISPLAY);
-    WebGLRenderingContext::HAS_DISPLAY = false;
+  for (auto &entry : WebGLRenderingContext::SURFACES) {
+    if (entry.second != EGL_NO_SURFACE) {
+      eglDestroySurface(entry.first.first, entry.second);
+    }
+  }
+  WebGLRenderingContext::SURFACES.clear();
+
+  for (auto &entry : WebGLRenderingContext::DISPLAYS) {
+    eglTerminate(entry.second);
   }
+  WebGLRenderingContext::DISPLAYS.clear();
+
+  ProgramCache::Shutdown();
+}
+
+GL_METHOD(SetProgramCache) {
+  Nan::HandleScope();
+
+  Nan::Utf8String directory(info[0]);
+  double maxBytes = Nan::To<double>(info[1]).ToChecked();
+
+  std::string errorMessage;
+  if (!ProgramCache::Configure(std::string(*directory, directory.length()),
+                               static_cast<size_t>(maxBytes), errorMessage)) {
+    return Nan::ThrowError(errorMessage.c_str());
+  }
+
+  // Displays created before the cache was configured start using it now
+  for (auto &entry : WebGLRenderingContext::DISPLAYS) {
+    ProgramCache::Attach(entry.second);
+  }
+}
+
+GL_METHOD(FlushProgramCache) {
+  Nan::HandleScope();
+
+  ProgramCache::Flush();
+}
+
+GL_METHOD(GetProgramCacheStats) {
+  Nan::HandleScope();
+
+  ProgramCacheStats cacheStats = ProgramCache::GetStats();
+  v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+  Nan::Set(stats, Nan::New("enabled").ToLocalChecked(),
+           Nan::New<v8::Boolean>(ProgramCache::IsConfigured()));
+  Nan::Set(stats, Nan::New("hits").ToLocalChecked(), Nan::New<v8::Number>(cacheStats.hits));
+  Nan::Set(stats, Nan::New("misses").ToLocalChecked(), Nan::New<v8::Number>(cacheStats.misses));
+  Nan::Set(stats, Nan::New("stores").ToLocalChecked(), Nan::New<v8::Number>(cacheStats.stores));
+  Nan::Set(stats, Nan::New("evictions").ToLocalChecked(),
+           Nan::New<v8::Number>(cacheStats.evictions));
+  Nan::Set(stats, Nan::New("entries").ToLocalChecked(), Nan::New<v8::Number>(cacheStats.entries));
+  Nan::Set(stats, Nan::New("bytes").ToLocalChecked(), Nan::New<v8::Number>(cacheStats.bytes));
+  info.GetReturnValue().Set(stats);
 }
 
 GL_METHOD(New) {
   Nan::HandleScope();
 
-  bool createWebGL2Context = Nan::To<bool>(info[10]).ToChecked();
+  bool createWebGL2Context = Nan::To<bool>(info[8]).ToChecked();
+  std::string backend = "default";
+  if (info[9]->IsString()) {
+    backend = *Nan::Utf8String(info[9]);
+  }
 
   WebGLRenderingContext *instance =
-      new WebGLRenderingContext(Nan::To<int32_t>(info[0]).ToChecked(), // Width
-                                Nan::To<int32_t>(info[1]).ToChecked(), // Height
-                                Nan::To<bool>(info[2]).ToChecked(),    // Alpha
-                                Nan::To<bool>(info[3]).ToChecked(),    // Depth
-                                Nan::To<bool>(info[4]).ToChecked(),    // Stencil
-                                Nan::To<bool>(info[5]).ToChecked(),    // antialias
-                                Nan::To<bool>(info[6]).ToChecked(),    // premultipliedAlpha
-                                Nan::To<bool>(info[7]).ToChecked(),    // preserve drawing buffer
-                                Nan::To<bool>(info[8]).ToChecked(),    // low power
-                                Nan::To<bool>(info[9]).ToChecked(),    // fail if crap
-                                createWebGL2Context);
+      new WebGLRenderingContext(Nan::To<bool>(info[0]).ToChecked(), // Alpha
+                                Nan::To<bool>(info[1]).ToChecked(), // Depth
+                                Nan::To<bool>(info[2]).ToChecked(), // Stencil
+                                Nan::To<bool>(info[3]).ToChecked(), // antialias
+                                Nan::To<bool>(info[4]).ToChecked(), // premultipliedAlpha
+                                Nan::To<bool>(info[5]).ToChecked(), // preserve drawing buffer
+                                Nan::To<bool>(info[6]).ToChecked(), // low power
+                                Nan::To<bool>(info[7]).ToChecked(), // fail if crap
+                                createWebGL2Context,
+                                backend);
 
   if (instance->state != GLCONTEXT_STATE_OK) {
     if (!instance->errorMessage.empty()) {
@@ -471,10 +1050,6 @@ GL_METHOD(New) {
 
   instance->Wrap(info.This());
 
-  if (createWebGL2Context) {
-    BindWebGL2(info);
-  }
-
   info.GetReturnValue().Set(info.This());
 }
 
@@ -484,6 +1059,47 @@ GL_METHOD(Destroy) {
   inst->dispose();
 }
 
+GL_METHOD(ResetContext) {
+  GL_BOILERPLATE;
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(inst->resetState()));
+}
+
+GL_METHOD(GetStateCacheStats) {
+  GL_BOILERPLATE;
+
+  v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+  Nan::Set(stats, Nan::New("hits").ToLocalChecked(), Nan::New<v8::Number>(inst->stateCache.hits));
+  Nan::Set(stats, Nan::New("misses").ToLocalChecked(),
+           Nan::New<v8::Number>(inst->stateCache.misses));
+  info.GetReturnValue().Set(stats);
+}
+
+GL_METHOD(GetScratchStats) {
+  GL_BOILERPLATE;
+
+  const ScratchArena &scratch = inst->scratch;
+  v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+  Nan::Set(stats, Nan::New("capacity").ToLocalChecked(),
+           Nan::New<v8::Number>(static_cast<double>(scratch.capacity)));
+  Nan::Set(stats, Nan::New("limit").ToLocalChecked(),
+           Nan::New<v8::Number>(static_cast<double>(scratch.limit)));
+  Nan::Set(stats, Nan::New("highWater").ToLocalChecked(),
+           Nan::New<v8::Number>(static_cast<double>(scratch.highWater)));
+  Nan::Set(stats, Nan::New("reuses").ToLocalChecked(), Nan::New<v8::Number>(scratch.reuses));
+  Nan::Set(stats, Nan::New("grows").ToLocalChecked(), Nan::New<v8::Number>(scratch.grows));
+  Nan::Set(stats, Nan::New("oversized").ToLocalChecked(),
+           Nan::New<v8::Number>(scratch.oversizedAllocations));
+  info.GetReturnValue().Set(stats);
+}
+
+GL_METHOD(SetScratchLimit) {
+  GL_BOILERPLATE;
+
+  double limit = Nan::To<double>(info[0]).ToChecked();
+  inst->scratch.setLimit(limit > 0 ? static_cast<size_t>(limit) : 0);
+}
+
 GL_METHOD(Uniform1f) {
   GL_BOILERPLATE;
 
@@ -568,6 +1184,78 @@ GL_METHOD(Uniform4i) {
   glUniform4i(location, x, y, z, w);
 }
 
+GL_METHOD(Uniform1fv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLfloat> data(info[1]);
+
+  glUniform1fv(location, data.length(), *data);
+}
+
+GL_METHOD(Uniform1iv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLint> data(info[1]);
+
+  glUniform1iv(location, data.length(), *data);
+}
+
+GL_METHOD(Uniform2fv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLfloat> data(info[1]);
+
+  glUniform2fv(location, data.length() / 2, *data);
+}
+
+GL_METHOD(Uniform2iv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLint> data(info[1]);
+
+  glUniform2iv(location, data.length() / 2, *data);
+}
+
+GL_METHOD(Uniform3fv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLfloat> data(info[1]);
+
+  glUniform3fv(location, data.length() / 3, *data);
+}
+
+GL_METHOD(Uniform3iv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLint> data(info[1]);
+
+  glUniform3iv(location, data.length() / 3, *data);
+}
+
+GL_METHOD(Uniform4fv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLfloat> data(info[1]);
+
+  glUniform4fv(location, data.length() / 4, *data);
+}
+
+GL_METHOD(Uniform4iv) {
+  GL_BOILERPLATE;
+
+  GLint location = Nan::To<int32_t>(info[0]).ToChecked();
+  Nan::TypedArrayContents<GLint> data(info[1]);
+
+  glUniform4iv(location, data.length() / 4, *data);
+}
+
 GL_METHOD(PixelStorei) {
   GL_BOILERPLATE;
 
@@ -610,18 +1298,19 @@ GL_METHOD(BindAttribLocation) {
   GLint index = Nan::To<int32_t>(info[1]).ToChecked();
   Nan::Utf8String name(info[2]);
 
-  glBindAttribLocation(program, index, *name);
+  inst->bindAttribLocation(program, index, *name);
 }
 
 GLenum WebGLRenderingContext::getError() {
-  GLenum error = GL_NO_ERROR;
-  if (errorSet.empty()) {
-    error = glGetError();
-  } else {
-    error = *errorSet.begin();
-    errorSet.erase(errorSet.begin());
+  if (errorBits == 0) {
+    return glGetError();
   }
-  return error;
+  size_t i = 0;
+  while (!(errorBits & (1u << i))) {
+    ++i;
+  }
+  errorBits &= ~(1u << i);
+  return ERROR_CODES[i];
 }
 
 GL_METHOD(GetError) {
@@ -640,6 +1329,7 @@ GL_METHOD(VertexAttribDivisorANGLE) {
 
 GL_METHOD(DrawArraysInstancedANGLE) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLint first = Nan::To<int32_t>(info[1]).ToChecked();
@@ -651,6 +1341,7 @@ GL_METHOD(DrawArraysInstancedANGLE) {
 
 GL_METHOD(DrawElementsInstancedANGLE) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLint count = Nan::To<int32_t>(info[1]).ToChecked();
@@ -664,6 +1355,7 @@ GL_METHOD(DrawElementsInstancedANGLE) {
 
 GL_METHOD(DrawArrays) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLint first = Nan::To<int32_t>(info[1]).ToChecked();
@@ -704,6 +1396,7 @@ GL_METHOD(UniformMatrix4fv) {
 
 GL_METHOD(GenerateMipmap) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLint target = Nan::To<int32_t>(info[0]).ToChecked();
   glGenerateMipmap(target);
@@ -723,7 +1416,7 @@ GL_METHOD(GetAttribLocation) {
 GL_METHOD(DepthFunc) {
   GL_BOILERPLATE;
 
-  glDepthFunc(Nan::To<int32_t>(info[0]).ToChecked());
+  inst->cachedDepthFunc(Nan::To<int32_t>(info[0]).ToChecked());
 }
 
 GL_METHOD(Viewport) {
@@ -734,7 +1427,7 @@ GL_METHOD(Viewport) {
   GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
 
-  glViewport(x, y, width, height);
+  inst->cachedViewport(x, y, width, height);
 }
 
 GL_METHOD(CreateShader) {
@@ -756,12 +1449,28 @@ GL_METHOD(ShaderSource) {
   GLint length = code.length();
 
   glShaderSource(id, 1, codes, &length);
+
+  if (SHARED_PROGRAMS.maxBytes > 0) {
+    inst->shaderSources[id].assign(*code, length);
+  }
 }
 
 GL_METHOD(CompileShader) {
   GL_BOILERPLATE;
 
-  glCompileShader(Nan::To<int32_t>(info[0]).ToChecked());
+  GLuint shader = Nan::To<int32_t>(info[0]).ToChecked();
+
+  inst->beginCheckedCall();
+  glCompileShader(shader);
+  GLenum error = inst->endCheckedCall();
+
+  auto source = inst->shaderSources.find(shader);
+  if (error == GL_NO_ERROR && source != inst->shaderSources.end()) {
+    inst->compiledSources[shader] = source->second;
+  } else {
+    inst->compiledSources.erase(shader);
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(error));
 }
 
 GL_METHOD(FrontFace) {
@@ -782,6 +1491,18 @@ GL_METHOD(GetShaderParameter) {
   info.GetReturnValue().Set(Nan::New<v8::Integer>(value));
 }
 
+GL_METHOD(MaxShaderCompilerThreads) {
+  GL_BOILERPLATE;
+
+  GLuint count = Nan::To<uint32_t>(info[0]).ToChecked();
+
+  if (inst->enabledExtensions.count("GL_KHR_parallel_shader_compile") == 0) {
+    inst->setError(GL_INVALID_OPERATION);
+    return;
+  }
+  glMaxShaderCompilerThreadsKHR(count);
+}
+
 GL_METHOD(GetShaderInfoLog) {
   GL_BOILERPLATE;
 
@@ -801,31 +1522,246 @@ GL_METHOD(GetShaderInfoLog) {
 GL_METHOD(CreateProgram) {
   GL_BOILERPLATE;
 
-  GLuint program = glCreateProgram();
-  inst->registerGLObj(GLOBJECT_TYPE_PROGRAM, program);
+  GLuint program = glCreateProgram();
+  inst->registerGLObj(GLOBJECT_TYPE_PROGRAM, program);
+
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(program));
+}
+
+GL_METHOD(AttachShader) {
+  GL_BOILERPLATE;
+
+  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint shader = Nan::To<int32_t>(info[1]).ToChecked();
+
+  inst->beginCheckedCall();
+  glAttachShader(program, shader);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
+}
+
+GL_METHOD(ValidateProgram) {
+  GL_BOILERPLATE;
+
+  inst->beginCheckedCall();
+  glValidateProgram(Nan::To<int32_t>(info[0]).ToChecked());
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
+}
+
+// Cross-context program sharing
+
+const SharedProgramBinary *SharedProgramCache::find(const std::string &key) {
+  auto found = entries.find(key);
+  if (found == entries.end()) {
+    return NULL;
+  }
+  found->second.lastUse = ++clock;
+  return &found->second;
+}
+
+void SharedProgramCache::insert(const std::string &key, GLenum format,
+                                std::vector<uint8_t> &&data) {
+  const size_t size = key.size() + data.size();
+  if (size > maxBytes) {
+    return;
+  }
+
+  auto existing = entries.find(key);
+  if (existing != entries.end()) {
+    bytes -= key.size() + existing->second.data.size();
+    entries.erase(existing);
+  }
+
+  SharedProgramBinary &entry = entries[key];
+  entry.format = format;
+  entry.data = std::move(data);
+  entry.lastUse = ++clock;
+  bytes += size;
+  resize(maxBytes);
+}
+
+void SharedProgramCache::resize(size_t newMaxBytes) {
+  maxBytes = newMaxBytes;
+  while (bytes > maxBytes && !entries.empty()) {
+    auto oldest = entries.begin();
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->second.lastUse < oldest->second.lastUse) {
+        oldest = it;
+      }
+    }
+    bytes -= oldest->first.size() + oldest->second.data.size();
+    entries.erase(oldest);
+  }
+}
+
+void WebGLRenderingContext::bindAttribLocation(GLuint program, GLint index, const char *name) {
+  attribBindings[program][name] = index;
+  glBindAttribLocation(program, index, name);
+}
+
+// WebGL 1 contexts only use binaries if GL_OES_get_program_binary is already enabled. Requesting
+// it here would change what getParameter and friends accept on the user's context.
+bool WebGLRenderingContext::supportsProgramBinaries() {
+  if (!isWebGL2 && enabledExtensions.count("GL_OES_get_program_binary") == 0) {
+    return false;
+  }
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  return formats > 0;
+}
+
+// Everything that decides the outcome of linking program: the display and context version, the
+// enabled extensions, the sources the attached shaders were compiled from, the attribute bindings
+// and the transform feedback varyings. Empty if an attached shader was compiled before sharing
+// was enabled, or not at all.
+std::string WebGLRenderingContext::programBinaryKey(GLuint program) {
+  GLint attached = 0;
+  glGetProgramiv(program, GL_ATTACHED_SHADERS, &attached);
+  std::vector<GLuint> shaders(std::max(attached, 1));
+  GLsizei count = 0;
+  glGetAttachedShaders(program, attached, &count, shaders.data());
+
+  std::vector<std::pair<GLint, const std::string *>> sources;
+  for (GLsizei i = 0; i < count; ++i) {
+    auto compiled = compiledSources.find(shaders[i]);
+    if (compiled == compiledSources.end()) {
+      return std::string();
+    }
+    GLint type = 0;
+    glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type);
+    sources.push_back({type, &compiled->second});
+  }
+  std::sort(sources.begin(), sources.end());
+
+  std::ostringstream key;
+  key << display << (isWebGL2 ? " webgl2\n" : " webgl1\n");
+  for (const std::string &extension : enabledExtensions) {
+    key << extension << ' ';
+  }
+  key << '\n';
+  for (const auto &source : sources) {
+    key << "shader " << source.first << ' ' << source.second->size() << '\n' << *source.second;
+  }
+  auto bindings = attribBindings.find(program);
+  if (bindings != attribBindings.end()) {
+    for (const auto &binding : bindings->second) {
+      key << "\nattribute " << binding.second << ' ' << binding.first;
+    }
+  }
+  auto varyings = feedbackVaryings.find(program);
+  if (varyings != feedbackVaryings.end()) {
+    key << "\nvaryings " << varyings->second.first;
+    for (const std::string &varying : varyings->second.second) {
+      key << ' ' << varying;
+    }
+  }
+  return key.str();
+}
+
+// Loads the binary of an identical program linked by any context if there is one, and links
+// normally otherwise. Returns the GL error raised by the link.
+GLenum WebGLRenderingContext::linkProgram(GLuint program) {
+  unsharedPrograms.erase(program);
+
+  std::string key;
+  if (SHARED_PROGRAMS.maxBytes > 0 && supportsProgramBinaries()) {
+    key = programBinaryKey(program);
+  }
+
+  if (!key.empty()) {
+    // Rejected binaries count as misses, like keys that are not in the cache
+    const SharedProgramBinary *shared = SHARED_PROGRAMS.find(key);
+    if (shared) {
+      beginCheckedCall();
+      if (isWebGL2) {
+        glProgramBinary(program, shared->format, shared->data.data(), GLsizei(shared->data.size()));
+      } else {
+        glProgramBinaryOES(program, shared->format, shared->data.data(),
+                           GLint(shared->data.size()));
+      }
+      GLint linked = GL_FALSE;
+      glGetProgramiv(program, GL_LINK_STATUS, &linked);
+      if (endCheckedCall() == GL_NO_ERROR && linked) {
+        SHARED_PROGRAMS.hits++;
+        return GL_NO_ERROR;
+      }
+    }
+    SHARED_PROGRAMS.misses++;
+    unsharedPrograms[program] = key;
+  }
+
+  beginCheckedCall();
+  glLinkProgram(program);
+  return endCheckedCall();
+}
+
+// Called once a link has resolved. Programs that were linked from source and succeeded hand
+// their binary to the shared cache.
+void WebGLRenderingContext::shareProgramBinary(GLuint program) {
+  auto unshared = unsharedPrograms.find(program);
+  if (unshared == unsharedPrograms.end()) {
+    return;
+  }
+  std::string key = std::move(unshared->second);
+  unsharedPrograms.erase(unshared);
+
+  GLint linked = GL_FALSE;
+  GLint length = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (!linked || length <= 0) {
+    return;
+  }
+
+  std::vector<uint8_t> data(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  if (isWebGL2) {
+    glGetProgramBinary(program, length, &written, &format, data.data());
+  } else {
+    glGetProgramBinaryOES(program, length, &written, &format, data.data());
+  }
+  if (written > 0) {
+    data.resize(written);
+    SHARED_PROGRAMS.insert(key, format, std::move(data));
+  }
+}
 
-  info.GetReturnValue().Set(Nan::New<v8::Integer>(program));
+void WebGLRenderingContext::forgetProgramSharing(GLuint program) {
+  attribBindings.erase(program);
+  feedbackVaryings.erase(program);
+  unsharedPrograms.erase(program);
 }
 
-GL_METHOD(AttachShader) {
+GL_METHOD(LinkProgram) {
   GL_BOILERPLATE;
 
-  GLint program = Nan::To<int32_t>(info[0]).ToChecked();
-  GLint shader = Nan::To<int32_t>(info[1]).ToChecked();
+  GLuint program = Nan::To<int32_t>(info[0]).ToChecked();
 
-  glAttachShader(program, shader);
+  // A failed relink makes using the program an error again
+  inst->stateCache.forgetProgram(program);
+
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->linkProgram(program)));
 }
 
-GL_METHOD(ValidateProgram) {
-  GL_BOILERPLATE;
+GL_METHOD(SetSharedProgramCacheSize) {
+  Nan::HandleScope();
 
-  glValidateProgram(Nan::To<int32_t>(info[0]).ToChecked());
+  double maxBytes = Nan::To<double>(info[0]).ToChecked();
+  SHARED_PROGRAMS.resize(maxBytes > 0 ? static_cast<size_t>(maxBytes) : 0);
 }
 
-GL_METHOD(LinkProgram) {
-  GL_BOILERPLATE;
+GL_METHOD(GetSharedProgramStats) {
+  Nan::HandleScope();
 
-  glLinkProgram(Nan::To<int32_t>(info[0]).ToChecked());
+  v8::Local<v8::Object> stats = Nan::New<v8::Object>();
+  Nan::Set(stats, Nan::New("hits").ToLocalChecked(), Nan::New<v8::Number>(SHARED_PROGRAMS.hits));
+  Nan::Set(stats, Nan::New("misses").ToLocalChecked(),
+           Nan::New<v8::Number>(SHARED_PROGRAMS.misses));
+  Nan::Set(stats, Nan::New("entries").ToLocalChecked(),
+           Nan::New<v8::Number>(double(SHARED_PROGRAMS.entries.size())));
+  Nan::Set(stats, Nan::New("bytes").ToLocalChecked(),
+           Nan::New<v8::Number>(double(SHARED_PROGRAMS.bytes)));
+  info.GetReturnValue().Set(stats);
 }
 
 GL_METHOD(GetProgramParameter) {
@@ -868,33 +1804,16 @@ GL_METHOD(ClearDepth) {
   glClearDepthf(depth);
 }
 
-// Two specific enums are accepted by ANGLE when they shouldn't be. This shows up
-// for headless, but not browsers, because browsers do additional validation.
-// The ANGLE fix is to make EXT_multisample_compatibility "enableable".
-bool IsBuggedANGLECap(GLenum cap) { return cap == GL_MULTISAMPLE || cap == GL_SAMPLE_ALPHA_TO_ONE; }
-
 GL_METHOD(Disable) {
   GL_BOILERPLATE;
 
-  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
-
-  if (IsBuggedANGLECap(cap)) {
-    inst->setError(GL_INVALID_ENUM);
-  } else {
-    glDisable(cap);
-  }
+  inst->cachedSetCapability(Nan::To<int32_t>(info[0]).ToChecked(), false);
 }
 
 GL_METHOD(Enable) {
   GL_BOILERPLATE;
 
-  GLenum cap = Nan::To<int32_t>(info[0]).ToChecked();
-
-  if (IsBuggedANGLECap(cap)) {
-    inst->setError(GL_INVALID_ENUM);
-  } else {
-    glEnable(cap);
-  }
+  inst->cachedSetCapability(Nan::To<int32_t>(info[0]).ToChecked(), true);
 }
 
 GL_METHOD(CreateTexture) {
@@ -913,90 +1832,71 @@ GL_METHOD(BindTexture) {
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint texture = Nan::To<int32_t>(info[1]).ToChecked();
 
-  glBindTexture(target, texture);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->cachedBindTexture(target, texture)));
 }
 
-std::vector<uint8_t> WebGLRenderingContext::unpackPixels(GLenum type, GLenum format, GLint width,
-                                                         GLint height, unsigned char *pixels) {
+uint8_t *ScratchArena::acquire(size_t bytes) {
+  highWater = std::max(highWater, bytes);
+  if (bytes <= capacity) {
+    reuses++;
+    return block.get();
+  }
+  if (bytes > limit) {
+    oversizedAllocations++;
+    oversized.reset(new uint8_t[bytes]);
+    return oversized.get();
+  }
+  grows++;
+  capacity = std::min(limit, std::max(bytes, capacity * 2));
+  block.reset(new uint8_t[capacity]);
+  return block.get();
+}
 
-  // Compute pixel size
-  GLint pixelSize = 1;
-  if (type == GL_UNSIGNED_BYTE || type == GL_FLOAT) {
-    if (type == GL_FLOAT) {
-      pixelSize = 4;
-    }
-    switch (format) {
-    case GL_ALPHA:
-    case GL_LUMINANCE:
-      break;
-    case GL_LUMINANCE_ALPHA:
-      pixelSize *= 2;
-      break;
-    case GL_RGB:
-      pixelSize *= 3;
-      break;
-    case GL_RGBA:
-      pixelSize *= 4;
-      break;
-    }
-  } else {
-    pixelSize = 2;
+void ScratchArena::setLimit(size_t bytes) {
+  limit = bytes;
+  if (capacity > limit) {
+    clear();
+  }
+}
+
+void ScratchArena::resetStats() {
+  highWater = 0;
+  reuses = 0;
+  grows = 0;
+  oversizedAllocations = 0;
+}
+
+uint8_t *WebGLRenderingContext::unpackPixels(GLenum type, GLenum format, GLint width,
+                                             GLint height, unsigned char *pixels, size_t length,
+                                             size_t &size) {
+  size_t pixelSize = PixelKernels::BytesPerPixel(format, type);
+  if (pixelSize == 0 || width <= 0 || height <= 0) {
+    return NULL;
   }
 
   // Compute row stride
-  GLint rowStride = pixelSize * width;
+  size_t rowStride = pixelSize * width;
   if ((rowStride % unpack_alignment) != 0) {
     rowStride += unpack_alignment - (rowStride % unpack_alignment);
   }
 
-  GLint imageSize = rowStride * height;
-  std::vector<uint8_t> unpacked(imageSize);
+  // The last row does not need to be padded. Anything shorter is passed through unchanged, so
+  // the robust entry points can report the error.
+  if (length < rowStride * (height - 1) + pixelSize * width) {
+    return NULL;
+  }
 
-  if (unpack_flip_y) {
-    for (int i = 0, j = height - 1; j >= 0; ++i, --j) {
-      memcpy(&unpacked[j * rowStride], reinterpret_cast<void *>(pixels + i * rowStride),
-             width * pixelSize);
-    }
-  } else {
-    memcpy(unpacked.data(), reinterpret_cast<void *>(pixels), imageSize);
-  }
-
-  // Premultiply alpha unpacking
-  if (unpack_premultiply_alpha && (format == GL_LUMINANCE_ALPHA || format == GL_RGBA)) {
-
-    for (int row = 0; row < height; ++row) {
-      for (int col = 0; col < width; ++col) {
-        uint8_t *pixel = &unpacked[(row * rowStride) + (col * pixelSize)];
-        if (format == GL_LUMINANCE_ALPHA) {
-          pixel[0] *= pixel[1] / 255.0;
-        } else if (type == GL_UNSIGNED_BYTE) {
-          float scale = pixel[3] / 255.0;
-          pixel[0] *= scale;
-          pixel[1] *= scale;
-          pixel[2] *= scale;
-        } else if (type == GL_UNSIGNED_SHORT_4_4_4_4) {
-          int r = pixel[0] & 0x0f;
-          int g = pixel[0] >> 4;
-          int b = pixel[1] & 0x0f;
-          int a = pixel[1] >> 4;
-
-          float scale = a / 15.0;
-          r *= scale;
-          g *= scale;
-          b *= scale;
-
-          pixel[0] = r + (g << 4);
-          pixel[1] = b + (a << 4);
-        } else if (type == GL_UNSIGNED_SHORT_5_5_5_1) {
-          if ((pixel[0] & 1) == 0) {
-            pixel[0] = 1; // why does this get set to 1?!?!?!
-            pixel[1] = 0;
-          }
-        }
-      }
-    }
+  PixelKernels::RowKernel premultiply =
+      unpack_premultiply_alpha ? PixelKernels::PremultiplyKernel(format, type) : nullptr;
+  if (!unpack_flip_y && !premultiply) {
+    return NULL;
   }
 
+  // The source belongs to the caller, so the conversion writes straight into scratch memory
+  size = rowStride * height;
+  uint8_t *unpacked = scratch.acquire(size);
+  PixelKernels::Unpack(pixels, unpacked, width, height, pixelSize, rowStride, unpack_flip_y,
+                       premultiply);
   return unpacked;
 }
 
@@ -1017,6 +1917,7 @@ void CallTexImage2D(GLenum target, GLint level, GLenum internalformat, GLsizei w
 
 GL_METHOD(TexImage2D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint level = Nan::To<int32_t>(info[1]).ToChecked();
@@ -1028,11 +1929,18 @@ GL_METHOD(TexImage2D) {
   GLint type = Nan::To<int32_t>(info[7]).ToChecked();
   Nan::TypedArrayContents<unsigned char> pixels(info[8]);
 
+  inst->beginCheckedCall();
   if (*pixels) {
+    uint8_t *unpacked = NULL;
+    size_t unpackedSize = 0;
     if (inst->unpack_flip_y || inst->unpack_premultiply_alpha) {
-      std::vector<uint8_t> unpacked = inst->unpackPixels(type, format, width, height, *pixels);
+      unpacked = inst->unpackPixels(type, format, width, height, *pixels, pixels.length(),
+                                    unpackedSize);
+    }
+    if (unpacked) {
       CallTexImage2D(target, level, internalformat, width, height, border, format, type,
-                     unpacked.size(), unpacked.data());
+                     unpackedSize, unpacked);
+      inst->scratch.release();
     } else {
       CallTexImage2D(target, level, internalformat, width, height, border, format, type,
                      pixels.length(), *pixels);
@@ -1040,10 +1948,12 @@ GL_METHOD(TexImage2D) {
   } else {
     CallTexImage2D(target, level, internalformat, width, height, border, format, type, 0, nullptr);
   }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(TexSubImage2D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint level = Nan::To<int32_t>(info[1]).ToChecked();
@@ -1055,14 +1965,323 @@ GL_METHOD(TexSubImage2D) {
   GLenum type = Nan::To<int32_t>(info[7]).ToChecked();
   Nan::TypedArrayContents<unsigned char> pixels(info[8]);
 
-  if (inst->unpack_flip_y || inst->unpack_premultiply_alpha) {
-    std::vector<uint8_t> unpacked = inst->unpackPixels(type, format, width, height, *pixels);
+  uint8_t *unpacked = NULL;
+  size_t unpackedSize = 0;
+  if (*pixels && (inst->unpack_flip_y || inst->unpack_premultiply_alpha)) {
+    unpacked = inst->unpackPixels(type, format, width, height, *pixels, pixels.length(),
+                                  unpackedSize);
+  }
+  inst->beginCheckedCall();
+  if (unpacked) {
     glTexSubImage2DRobustANGLE(target, level, xoffset, yoffset, width, height, format, type,
-                               unpacked.size(), unpacked.data());
+                               unpackedSize, unpacked);
+    inst->scratch.release();
   } else {
     glTexSubImage2DRobustANGLE(target, level, xoffset, yoffset, width, height, format, type,
                                pixels.length(), *pixels);
   }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
+}
+
+// Asynchronous texture uploads
+
+UploadSlot *WebGLRenderingContext::acquireUploadSlot(size_t &index) {
+  if (uploads.slots.empty()) {
+    uploads.slots.resize(UploadRing::SLOT_COUNT);
+    for (UploadSlot &slot : uploads.slots) {
+      glGenBuffers(1, &slot.buffer);
+      slot.size = 0;
+      slot.fence = NULL;
+      slot.busy = false;
+    }
+  }
+
+  index = uploads.next;
+  uploads.next = (index + 1) % uploads.slots.size();
+  UploadSlot &slot = uploads.slots[index];
+
+  // Hand everything up to the previous upload from this slot to GL, then wait for GL to finish
+  // reading from it. If that does not happen within FENCE_TIMEOUT the slot is left alone and the
+  // caller uploads synchronously; a fence that cannot be waited on is dropped.
+  while (slot.busy && issueNextUpload(true)) {
+  }
+  if (slot.fence) {
+    GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                     UploadRing::FENCE_TIMEOUT);
+    if (status == GL_TIMEOUT_EXPIRED) {
+      return NULL;
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = NULL;
+    if (status == GL_WAIT_FAILED) {
+      return NULL;
+    }
+  }
+  return &slot;
+}
+
+bool WebGLRenderingContext::issueNextUpload(bool wait) {
+  if (uploads.pending.empty()) {
+    return false;
+  }
+  std::shared_ptr<PendingUpload> upload = uploads.pending.front();
+  {
+    std::unique_lock<std::mutex> lock(uploads.mutex);
+    if (!upload->copied) {
+      if (!wait) {
+        return false;
+      }
+      uploads.copied.wait(lock, [&upload] { return upload->copied; });
+    }
+  }
+  uploads.pending.pop_front();
+  UploadSlot &slot = uploads.slots[upload->slot];
+
+  GLenum bindTarget = upload->target == GL_TEXTURE_2D ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP;
+  GLint unpackBuffer = 0, texture = 0, rowLength = 0, skipRows = 0, skipPixels = 0;
+  glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+  glGetIntegerv(bindTarget == GL_TEXTURE_2D ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_CUBE_MAP,
+                &texture);
+  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+  glGetIntegerv(GL_UNPACK_SKIP_ROWS, &skipRows);
+  glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &skipPixels);
+
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+  glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+  // The texture may have been deleted while the pixels were being copied
+  GLenum error = GL_NO_ERROR;
+  if (upload->texture && glIsTexture(upload->texture)) {
+    glBindTexture(bindTarget, upload->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, upload->alignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, upload->rowLength);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, upload->skipRows);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, upload->skipPixels);
+    beginCheckedCall();
+    glTexSubImage2D(upload->target, upload->level, upload->xoffset, upload->yoffset,
+                    upload->width, upload->height, upload->format, upload->type, nullptr);
+    error = endCheckedCall();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, skipRows);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, skipPixels);
+    glBindTexture(bindTarget, texture);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+
+  slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  slot.busy = false;
+  uploads.issuedUnreported.push_back(error);
+  return true;
+}
+
+void WebGLRenderingContext::finishUploads() {
+  while (issueNextUpload(true)) {
+  }
+}
+
+// Pending uploads into a deleted texture are dropped, so they cannot land in a texture that is
+// created later under the same name. Their promises still resolve, in order.
+void WebGLRenderingContext::cancelUploads(GLuint texture) {
+  for (const std::shared_ptr<PendingUpload> &upload : uploads.pending) {
+    if (upload->texture == texture) {
+      upload->texture = 0;
+    }
+  }
+}
+
+void WebGLRenderingContext::releaseUploads() {
+  for (UploadSlot &slot : uploads.slots) {
+    if (slot.fence) {
+      glDeleteSync(slot.fence);
+    }
+    glDeleteBuffers(1, &slot.buffer);
+  }
+  uploads.slots.clear();
+  uploads.next = 0;
+}
+
+// Copies the pixels of one upload into its mapped staging buffer on the threadpool. Back on the
+// main thread it hands every upload whose copy is done to GL, in order, and passes the JS side the
+// error of each upload issued since the last callback.
+class UploadWorker : public Nan::AsyncWorker {
+public:
+  UploadWorker(Nan::Callback *callback, WebGLRenderingContext *inst,
+               std::shared_ptr<PendingUpload> upload, const uint8_t *src, uint8_t *dst,
+               size_t size, size_t pixelSize, size_t rowStride, bool flipY,
+               PixelKernels::RowKernel premultiply)
+      : Nan::AsyncWorker(callback, "webgl:texSubImage2DAsync"), inst(inst), upload(upload),
+        src(src), dst(dst), size(size), pixelSize(pixelSize), rowStride(rowStride), flipY(flipY),
+        premultiply(premultiply) {}
+
+  void Execute() override {
+    if (flipY || premultiply) {
+      PixelKernels::Unpack(src, dst, upload->width, upload->height, pixelSize, rowStride, flipY,
+                           premultiply);
+    } else {
+      memcpy(dst, src, size);
+    }
+    std::lock_guard<std::mutex> lock(inst->uploads.mutex);
+    upload->copied = true;
+    inst->uploads.copied.notify_all();
+  }
+
+  void HandleOKCallback() override {
+    Nan::HandleScope scope;
+    if (inst->setActive()) {
+      while (inst->issueNextUpload(false)) {
+      }
+    }
+    std::vector<GLenum> &issued = inst->uploads.issuedUnreported;
+    v8::Local<v8::Array> errors = Nan::New<v8::Array>(issued.size());
+    for (size_t i = 0; i < issued.size(); ++i) {
+      Nan::Set(errors, i, Nan::New<v8::Integer>(issued[i]));
+    }
+    issued.clear();
+    v8::Local<v8::Value> argv[] = {errors};
+    callback->Call(1, argv, async_resource);
+  }
+
+private:
+  WebGLRenderingContext *inst;
+  std::shared_ptr<PendingUpload> upload;
+  const uint8_t *src;
+  uint8_t *dst;
+  size_t size;
+  size_t pixelSize;
+  size_t rowStride;
+  bool flipY;
+  PixelKernels::RowKernel premultiply;
+};
+
+GL_METHOD(TexSubImage2DAsync) {
+  GL_BOILERPLATE;
+
+  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint level = Nan::To<int32_t>(info[1]).ToChecked();
+  GLint xoffset = Nan::To<int32_t>(info[2]).ToChecked();
+  GLint yoffset = Nan::To<int32_t>(info[3]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[4]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[5]).ToChecked();
+  GLenum format = Nan::To<int32_t>(info[6]).ToChecked();
+  GLenum type = Nan::To<int32_t>(info[7]).ToChecked();
+  Nan::TypedArrayContents<unsigned char> pixels(info[8]);
+  GLuint texture = Nan::To<uint32_t>(info[9]).ToChecked();
+
+  // Returning false tells the caller to upload synchronously instead. Every upload that could
+  // fail once staged goes that way, so invalid arguments raise the same error texSubImage2D does,
+  // before the call returns.
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(false));
+  if (!inst->isWebGL2 || !*pixels || !info[10]->IsFunction() || level < 0 || xoffset < 0 ||
+      yoffset < 0 || width <= 0 || height <= 0) {
+    return;
+  }
+  size_t pixelSize = PixelKernels::BytesPerPixel(format, type);
+  if (pixelSize == 0) {
+    return;
+  }
+
+  // The region has to fit the texture level, and the level has to exist. The extension for the
+  // query is only requested here, by the first context that uploads asynchronously. Without
+  // GL_ANGLE_get_tex_level_parameter the query fails with INVALID_OPERATION, the size is left
+  // unset and only the deferred call can catch a region that does not fit.
+  if (inst->enabledExtensions.count("GL_ANGLE_get_tex_level_parameter") == 0 &&
+      inst->requestableExtensions.count("GL_ANGLE_get_tex_level_parameter")) {
+    glRequestExtensionANGLE("GL_ANGLE_get_tex_level_parameter");
+    inst->enabledExtensions.insert("GL_ANGLE_get_tex_level_parameter");
+  }
+  inst->beginCheckedCall();
+  GLint levelWidth = -1;
+  GLint levelHeight = -1;
+  glGetTexLevelParameterivANGLE(target, level, GL_TEXTURE_WIDTH, &levelWidth);
+  glGetTexLevelParameterivANGLE(target, level, GL_TEXTURE_HEIGHT, &levelHeight);
+  GLenum queryError = glGetError();
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  if (queryError == GL_INVALID_VALUE ||
+      (levelWidth >= 0 && levelHeight >= 0 &&
+       (width > levelWidth - xoffset || height > levelHeight - yoffset))) {
+    return;
+  }
+
+  // Flipping and premultiplying happen while copying into the staging buffer. They write rows
+  // padded only to the unpack alignment, so GL reads those without row length or skips.
+  PixelKernels::RowKernel premultiply =
+      inst->unpack_premultiply_alpha ? PixelKernels::PremultiplyKernel(format, type) : nullptr;
+  bool flipY = inst->unpack_flip_y;
+  GLint rowLength = 0, skipRows = 0, skipPixels = 0;
+  if (!flipY && !premultiply) {
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+    glGetIntegerv(GL_UNPACK_SKIP_ROWS, &skipRows);
+    glGetIntegerv(GL_UNPACK_SKIP_PIXELS, &skipPixels);
+  }
+  size_t rowStride = pixelSize * (rowLength > 0 ? rowLength : width);
+  if ((rowStride % inst->unpack_alignment) != 0) {
+    rowStride += inst->unpack_alignment - (rowStride % inst->unpack_alignment);
+  }
+  size_t size = pixels.length();
+  if (size < rowStride * (skipRows + height - 1) + pixelSize * (skipPixels + width)) {
+    return;
+  }
+  if (flipY || premultiply) {
+    size = rowStride * height;
+  }
+
+  // Failures from here on fall back to the synchronous path, which reports any real error, so
+  // they are kept out of the context's error flags
+  size_t index = 0;
+  UploadSlot *slot = inst->acquireUploadSlot(index);
+  if (!slot) {
+    return;
+  }
+  GLint unpackBuffer = 0;
+  glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot->buffer);
+  if (slot->size < size) {
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    slot->size = glGetError() == GL_NO_ERROR ? size : 0;
+  }
+  void *mapped = NULL;
+  if (slot->size >= size) {
+    mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                  GL_MAP_UNSYNCHRONIZED_BIT);
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+  while (glGetError() != GL_NO_ERROR) {
+  }
+  if (!mapped) {
+    return;
+  }
+
+  std::shared_ptr<PendingUpload> upload = std::make_shared<PendingUpload>();
+  upload->slot = index;
+  upload->target = target;
+  upload->texture = texture;
+  upload->level = level;
+  upload->xoffset = xoffset;
+  upload->yoffset = yoffset;
+  upload->width = width;
+  upload->height = height;
+  upload->format = format;
+  upload->type = type;
+  upload->alignment = inst->unpack_alignment;
+  upload->rowLength = rowLength;
+  upload->skipRows = skipRows;
+  upload->skipPixels = skipPixels;
+  upload->copied = false;
+  slot->busy = true;
+  inst->uploads.pending.push_back(upload);
+
+  UploadWorker *worker = new UploadWorker(
+      new Nan::Callback(info[10].As<v8::Function>()), inst, upload, *pixels,
+      static_cast<uint8_t *>(mapped), size, pixelSize, rowStride, flipY, premultiply);
+  // Keeps the context and the source pixels alive until the copy is done
+  worker->SaveToPersistent("context", info.This());
+  worker->SaveToPersistent("pixels", info[8]);
+  Nan::AsyncQueueWorker(worker);
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(true));
 }
 
 GL_METHOD(TexParameteri) {
@@ -1087,6 +2306,7 @@ GL_METHOD(TexParameterf) {
 
 GL_METHOD(Clear) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   glClear(Nan::To<int32_t>(info[0]).ToChecked());
 }
@@ -1094,7 +2314,7 @@ GL_METHOD(Clear) {
 GL_METHOD(UseProgram) {
   GL_BOILERPLATE;
 
-  glUseProgram(Nan::To<int32_t>(info[0]).ToChecked());
+  inst->cachedUseProgram(Nan::To<int32_t>(info[0]).ToChecked());
 }
 
 GL_METHOD(CreateBuffer) {
@@ -1113,7 +2333,7 @@ GL_METHOD(BindBuffer) {
   GLenum target = (GLenum)Nan::To<int32_t>(info[0]).ToChecked();
   GLuint buffer = (GLuint)Nan::To<uint32_t>(info[1]).ToChecked();
 
-  glBindBuffer(target, buffer);
+  inst->cachedBindBuffer(target, buffer);
 }
 
 GL_METHOD(CreateFramebuffer) {
@@ -1132,7 +2352,9 @@ GL_METHOD(BindFramebuffer) {
   GLint target = (GLint)Nan::To<int32_t>(info[0]).ToChecked();
   GLint buffer = (GLint)(Nan::To<int32_t>(info[1]).ToChecked());
 
+  inst->beginCheckedCall();
   glBindFramebuffer(target, buffer);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(FramebufferTexture2D) {
@@ -1159,12 +2381,14 @@ GL_METHOD(BufferData) {
   GLint target = Nan::To<int32_t>(info[0]).ToChecked();
   GLenum usage = Nan::To<int32_t>(info[2]).ToChecked();
 
+  inst->beginCheckedCall();
   if (info[1]->IsObject()) {
     Nan::TypedArrayContents<char> array(info[1]);
     glBufferData(target, array.length(), static_cast<void *>(*array), usage);
   } else if (info[1]->IsNumber()) {
     glBufferData(target, Nan::To<int32_t>(info[1]).ToChecked(), NULL, usage);
   }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(BufferSubData) {
@@ -1191,7 +2415,7 @@ GL_METHOD(BlendFunc) {
   GLenum sfactor = Nan::To<int32_t>(info[0]).ToChecked();
   GLenum dfactor = Nan::To<int32_t>(info[1]).ToChecked();
 
-  glBlendFunc(sfactor, dfactor);
+  inst->cachedBlendFuncSeparate(sfactor, dfactor, sfactor, dfactor);
 }
 
 GL_METHOD(EnableVertexAttribArray) {
@@ -1216,11 +2440,12 @@ GL_METHOD(VertexAttribPointer) {
 GL_METHOD(ActiveTexture) {
   GL_BOILERPLATE;
 
-  glActiveTexture(Nan::To<int32_t>(info[0]).ToChecked());
+  inst->cachedActiveTexture(Nan::To<int32_t>(info[0]).ToChecked());
 }
 
 GL_METHOD(DrawElements) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLint count = Nan::To<int32_t>(info[1]).ToChecked();
@@ -1312,7 +2537,7 @@ GL_METHOD(BlendFuncSeparate) {
   GLenum src_alpha = Nan::To<int32_t>(info[2]).ToChecked();
   GLenum dst_alpha = Nan::To<int32_t>(info[3]).ToChecked();
 
-  glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+  inst->cachedBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
 }
 
 GL_METHOD(ClearStencil) {
@@ -1336,6 +2561,7 @@ GL_METHOD(ColorMask) {
 
 GL_METHOD(CopyTexImage2D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint level = Nan::To<int32_t>(info[1]).ToChecked();
@@ -1346,11 +2572,14 @@ GL_METHOD(CopyTexImage2D) {
   GLsizei height = Nan::To<int32_t>(info[6]).ToChecked();
   GLint border = Nan::To<int32_t>(info[7]).ToChecked();
 
+  inst->beginCheckedCall();
   glCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(CopyTexSubImage2D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint level = Nan::To<int32_t>(info[1]).ToChecked();
@@ -1361,7 +2590,9 @@ GL_METHOD(CopyTexSubImage2D) {
   GLsizei width = Nan::To<int32_t>(info[6]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[7]).ToChecked();
 
+  inst->beginCheckedCall();
   glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(CullFace) {
@@ -1449,7 +2680,7 @@ GL_METHOD(Scissor) {
   GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
 
-  glScissor(x, y, width, height);
+  inst->cachedScissor(x, y, width, height);
 }
 
 GL_METHOD(StencilFunc) {
@@ -1537,6 +2768,7 @@ GL_METHOD(DeleteBuffer) {
   GLuint buffer = (GLuint)Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_BUFFER, buffer);
+  inst->stateCache.forgetBuffer(buffer);
 
   glDeleteBuffers(1, &buffer);
 }
@@ -1557,6 +2789,8 @@ GL_METHOD(DeleteProgram) {
   GLuint program = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_PROGRAM, program);
+  inst->stateCache.forgetProgram(program);
+  inst->forgetProgramSharing(program);
 
   glDeleteProgram(program);
 }
@@ -1577,6 +2811,8 @@ GL_METHOD(DeleteShader) {
   GLuint shader = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_SHADER, shader);
+  inst->shaderSources.erase(shader);
+  inst->compiledSources.erase(shader);
 
   glDeleteShader(shader);
 }
@@ -1587,6 +2823,8 @@ GL_METHOD(DeleteTexture) {
   GLuint texture = Nan::To<uint32_t>(info[0]).ToChecked();
 
   inst->unregisterGLObj(GLOBJECT_TYPE_TEXTURE, texture);
+  inst->stateCache.forgetTexture(texture);
+  inst->cancelUploads(texture);
 
   glDeleteTextures(1, &texture);
 }
@@ -1638,80 +2876,473 @@ GL_METHOD(IsFramebuffer) {
       Nan::New<v8::Boolean>(glIsFramebuffer(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
 }
 
-GL_METHOD(IsProgram) {
+GL_METHOD(IsProgram) {
+  GL_BOILERPLATE;
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Boolean>(glIsProgram(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+}
+
+GL_METHOD(IsRenderbuffer) {
+  GL_BOILERPLATE;
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Boolean>(glIsRenderbuffer(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+}
+
+GL_METHOD(IsShader) {
+  GL_BOILERPLATE;
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Boolean>(glIsShader(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+}
+
+GL_METHOD(IsTexture) {
+  GL_BOILERPLATE;
+
+  info.GetReturnValue().Set(
+      Nan::New<v8::Boolean>(glIsTexture(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+}
+
+GL_METHOD(RenderbufferStorage) {
+  GL_BOILERPLATE;
+
+  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
+  GLenum internalformat = Nan::To<int32_t>(info[1]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
+
+  // In WebGL, we map GL_DEPTH_STENCIL to GL_DEPTH24_STENCIL8
+  if (internalformat == GL_DEPTH_STENCIL_OES) {
+    internalformat = GL_DEPTH24_STENCIL8_OES;
+  } else if (internalformat == GL_DEPTH_COMPONENT32_OES) {
+    internalformat = inst->preferredDepth;
+  }
+
+  inst->beginCheckedCall();
+  glRenderbufferStorage(target, internalformat, width, height);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
+}
+
+GL_METHOD(GetShaderSource) {
+  GL_BOILERPLATE;
+
+  GLint shader = Nan::To<int32_t>(info[0]).ToChecked();
+
+  GLint len;
+  glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &len);
+
+  GLchar *source = new GLchar[len];
+  glGetShaderSource(shader, len, NULL, source);
+  v8::Local<v8::String> str = Nan::New<v8::String>(source).ToLocalChecked();
+  delete[] source;
+
+  info.GetReturnValue().Set(str);
+}
+
+// Readback options follow the other arguments as output format, flip and unpremultiply. They only
+// apply to RGBA/UNSIGNED_BYTE reads into client memory.
+static ReadbackOptions ReadbackOptionsFromArgs(Nan::NAN_METHOD_ARGS_TYPE info, int first) {
+  ReadbackOptions options = {false, PixelKernels::PACK_RGBA, false, false};
+  if (info.Length() > first && !info[first]->IsUndefined()) {
+    options.enabled = true;
+    options.format = Nan::To<int32_t>(info[first]).ToChecked();
+    options.flipY = Nan::To<bool>(info[first + 1]).ToChecked();
+    options.unpremultiply = Nan::To<bool>(info[first + 2]).ToChecked();
+  }
+  return options;
+}
+
+// When active, overrides the pack parameters for the lifetime of the scope so glReadPixels writes
+// tightly packed rows, which is the layout PixelKernels::Pack reads.
+struct TightPackScope {
+  bool active, webgl2;
+  GLint alignment, rowLength, skipRows, skipPixels;
+
+  TightPackScope(bool active, bool webgl2)
+      : active(active), webgl2(webgl2), alignment(4), rowLength(0), skipRows(0), skipPixels(0) {
+    if (!active) {
+      return;
+    }
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    if (webgl2) {
+      glGetIntegerv(GL_PACK_ROW_LENGTH, &rowLength);
+      glGetIntegerv(GL_PACK_SKIP_ROWS, &skipRows);
+      glGetIntegerv(GL_PACK_SKIP_PIXELS, &skipPixels);
+      glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+      glPixelStorei(GL_PACK_SKIP_ROWS, 0);
+      glPixelStorei(GL_PACK_SKIP_PIXELS, 0);
+    }
+  }
+
+  ~TightPackScope() {
+    if (!active) {
+      return;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+    if (webgl2) {
+      glPixelStorei(GL_PACK_ROW_LENGTH, rowLength);
+      glPixelStorei(GL_PACK_SKIP_ROWS, skipRows);
+      glPixelStorei(GL_PACK_SKIP_PIXELS, skipPixels);
+    }
+  }
+};
+
+GL_METHOD(ReadPixels) {
+  GL_BOILERPLATE;
+  inst->finishUploads();
+
+  GLint x = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint y = Nan::To<int32_t>(info[1]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
+  GLenum format = Nan::To<int32_t>(info[4]).ToChecked();
+  GLenum type = Nan::To<int32_t>(info[5]).ToChecked();
+  Nan::TypedArrayContents<char> pixels(info[6]);
+  ReadbackOptions options = ReadbackOptionsFromArgs(info, 7);
+
+  if (!options.enabled) {
+    glReadPixels(x, y, width, height, format, type, *pixels);
+    return;
+  }
+
+  GLint packBuffer = 0;
+  if (inst->isWebGL2) {
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+  }
+  PixelKernels::PackFormat packFormat = static_cast<PixelKernels::PackFormat>(options.format);
+  size_t outSize = PixelKernels::PackedPixelSize(packFormat);
+  if (width < 0 || height < 0) {
+    inst->setError(GL_INVALID_VALUE);
+    return;
+  }
+  if (format != GL_RGBA || type != GL_UNSIGNED_BYTE || packBuffer != 0 ||
+      pixels.length() < outSize * width * height) {
+    inst->setError(GL_INVALID_OPERATION);
+    return;
+  }
+
+  // Read into scratch memory and repack from there straight into the destination
+  size_t size = static_cast<size_t>(width) * height * 4;
+  uint8_t *staging = inst->scratch.acquire(size);
+  {
+    TightPackScope tight(true, inst->isWebGL2);
+    glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, staging);
+  }
+  PixelKernels::Pack(staging, reinterpret_cast<uint8_t *>(*pixels), width, height, width * 4,
+                     width * outSize, options.flipY, packFormat, options.unpremultiply);
+  inst->scratch.release();
+}
+
+// Asynchronous readback
+
+ReadbackBuffer WebGLRenderingContext::acquireReadbackBuffer(size_t size) {
+  // Prefer the smallest spare buffer that fits, otherwise grow the largest one
+  std::vector<ReadbackBuffer>::iterator best = spareReadbackBuffers.end();
+  for (std::vector<ReadbackBuffer>::iterator it = spareReadbackBuffers.begin();
+       it != spareReadbackBuffers.end(); ++it) {
+    if (best == spareReadbackBuffers.end()) {
+      best = it;
+    } else if (it->capacity >= size) {
+      if (best->capacity < size || it->capacity < best->capacity) {
+        best = it;
+      }
+    } else if (best->capacity < size && it->capacity > best->capacity) {
+      best = it;
+    }
+  }
+  if (best != spareReadbackBuffers.end()) {
+    ReadbackBuffer buffer = *best;
+    spareReadbackBuffers.erase(best);
+    return buffer;
+  }
+  ReadbackBuffer buffer = {0, 0};
+  glGenBuffers(1, &buffer.buffer);
+  return buffer;
+}
+
+void WebGLRenderingContext::recycleReadbackBuffer(const ReadbackBuffer &buffer) {
+  if (spareReadbackBuffers.size() < MAX_SPARE_READBACK_BUFFERS) {
+    spareReadbackBuffers.push_back(buffer);
+  } else {
+    glDeleteBuffers(1, &buffer.buffer);
+  }
+}
+
+void WebGLRenderingContext::releaseReadbacks() {
+  for (std::map<uint32_t, PendingReadback>::iterator it = readbacks.begin();
+       it != readbacks.end(); ++it) {
+    glDeleteSync(it->second.fence);
+    glDeleteBuffers(1, &it->second.buffer.buffer);
+  }
+  readbacks.clear();
+  for (const ReadbackBuffer &buffer : spareReadbackBuffers) {
+    glDeleteBuffers(1, &buffer.buffer);
+  }
+  spareReadbackBuffers.clear();
+}
+
+GL_METHOD(ReadPixelsAsync) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
-  info.GetReturnValue().Set(
-      Nan::New<v8::Boolean>(glIsProgram(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
-}
+  GLint x = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint y = Nan::To<int32_t>(info[1]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
+  GLenum format = Nan::To<int32_t>(info[4]).ToChecked();
+  GLenum type = Nan::To<int32_t>(info[5]).ToChecked();
+  // Byte length of the destination, or -1 if the pixels go to a new array
+  double destinationLength = Nan::To<double>(info[6]).ToChecked();
+  ReadbackOptions options = ReadbackOptionsFromArgs(info, 7);
+
+  // Returning 0 tells the caller to read synchronously instead, -1 that the destination cannot
+  // hold the pixels
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(0));
+  size_t pixelSize = PixelKernels::BytesPerPixel(format, type);
+  if (!inst->isWebGL2 || pixelSize == 0 || width <= 0 || height <= 0) {
+    return;
+  }
 
-GL_METHOD(IsRenderbuffer) {
-  GL_BOILERPLATE;
+  size_t size;
+  if (options.enabled) {
+    if (format != GL_RGBA || type != GL_UNSIGNED_BYTE) {
+      return;
+    }
+    // Tightly packed RGBA, repacked by ReadPixelsAsyncFinish
+    size = static_cast<size_t>(width) * height * 4;
+  } else {
+    // Same layout glReadPixels would write to client memory
+    GLint alignment = 4, rowLength = 0, skipRows = 0, skipPixels = 0;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+    glGetIntegerv(GL_PACK_ROW_LENGTH, &rowLength);
+    glGetIntegerv(GL_PACK_SKIP_ROWS, &skipRows);
+    glGetIntegerv(GL_PACK_SKIP_PIXELS, &skipPixels);
+    size_t rowStride = pixelSize * (rowLength > 0 ? rowLength : width);
+    if ((rowStride % alignment) != 0) {
+      rowStride += alignment - (rowStride % alignment);
+    }
+    size = (skipRows + height - 1) * rowStride + (skipPixels + width) * pixelSize;
+  }
 
-  info.GetReturnValue().Set(
-      Nan::New<v8::Boolean>(glIsRenderbuffer(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
-}
+  // Checked like readPixels does, before any pack buffer is set aside for the read
+  size_t outputSize = size;
+  if (options.enabled) {
+    PixelKernels::PackFormat packFormat = static_cast<PixelKernels::PackFormat>(options.format);
+    outputSize = static_cast<size_t>(width) * height * PixelKernels::PackedPixelSize(packFormat);
+  }
+  if (destinationLength >= 0 && destinationLength < outputSize) {
+    inst->setError(GL_INVALID_OPERATION);
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(-1));
+    return;
+  }
 
-GL_METHOD(IsShader) {
-  GL_BOILERPLATE;
+  ReadbackBuffer buffer = inst->acquireReadbackBuffer(size);
+  GLint packBuffer = 0;
+  glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
 
-  info.GetReturnValue().Set(
-      Nan::New<v8::Boolean>(glIsShader(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+  inst->beginCheckedCall();
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.buffer);
+  if (buffer.capacity < size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    buffer.capacity = size;
+  }
+  {
+    TightPackScope tight(options.enabled, true);
+    glReadPixels(x, y, width, height, format, type, nullptr);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer);
+  if (inst->endCheckedCall() != GL_NO_ERROR) {
+    glDeleteBuffers(1, &buffer.buffer);
+    return;
+  }
+
+  // Flush so the readback starts now rather than when something else submits work
+  PendingReadback readback = {
+      buffer, size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), width, height, options};
+  glFlush();
+
+  uint32_t id = ++inst->nextReadback;
+  if (id == 0) {
+    id = ++inst->nextReadback;
+  }
+  inst->readbacks[id] = readback;
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(id));
 }
 
-GL_METHOD(IsTexture) {
+GL_METHOD(ReadPixelsAsyncPoll) {
   GL_BOILERPLATE;
 
-  info.GetReturnValue().Set(
-      Nan::New<v8::Boolean>(glIsTexture(Nan::To<uint32_t>(info[0]).ToChecked()) != 0));
+  uint32_t id = Nan::To<uint32_t>(info[0]).ToChecked();
+  std::map<uint32_t, PendingReadback>::iterator it = inst->readbacks.find(id);
+  bool done = it == inst->readbacks.end() ||
+              glClientWaitSync(it->second.fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(done));
 }
 
-GL_METHOD(RenderbufferStorage) {
+// Copies a finished readback into the typed array passed in, or into a new Uint8Array, and
+// returns it. Readbacks started with options are repacked while they are copied. Returns null if
+// the readback was dropped by a context reset.
+GL_METHOD(ReadPixelsAsyncFinish) {
   GL_BOILERPLATE;
 
-  GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
-  GLenum internalformat = Nan::To<int32_t>(info[1]).ToChecked();
-  GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
-  GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
+  uint32_t id = Nan::To<uint32_t>(info[0]).ToChecked();
+  info.GetReturnValue().SetNull();
+  std::map<uint32_t, PendingReadback>::iterator it = inst->readbacks.find(id);
+  if (it == inst->readbacks.end()) {
+    return;
+  }
+  PendingReadback readback = it->second;
+  inst->readbacks.erase(it);
+  glDeleteSync(readback.fence);
+
+  const ReadbackOptions &options = readback.options;
+  PixelKernels::PackFormat packFormat = static_cast<PixelKernels::PackFormat>(options.format);
+  size_t outSize = PixelKernels::PackedPixelSize(packFormat);
+  size_t outputSize = options.enabled
+                          ? static_cast<size_t>(readback.width) * readback.height * outSize
+                          : readback.size;
+
+  v8::Local<v8::Value> result;
+  uint8_t *dst = NULL;
+  size_t length = 0;
+  if (info[1]->IsArrayBufferView()) {
+    Nan::TypedArrayContents<uint8_t> pixels(info[1]);
+    result = info[1];
+    length = std::min(outputSize, pixels.length());
+    // Repacking needs room for every row
+    if (!options.enabled || length == outputSize) {
+      dst = *pixels;
+    }
+  } else {
+    v8::Local<v8::ArrayBuffer> buffer =
+        v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), outputSize);
+    result = v8::Uint8Array::New(buffer, 0, outputSize);
+    dst = static_cast<uint8_t *>(buffer->GetBackingStore()->Data());
+    length = outputSize;
+  }
 
-  // In WebGL, we map GL_DEPTH_STENCIL to GL_DEPTH24_STENCIL8
-  if (internalformat == GL_DEPTH_STENCIL_OES) {
-    internalformat = GL_DEPTH24_STENCIL8_OES;
-  } else if (internalformat == GL_DEPTH_COMPONENT32_OES) {
-    internalformat = inst->preferredDepth;
+  GLint packBuffer = 0;
+  glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.buffer);
+  const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readback.size, GL_MAP_READ_BIT);
+  if (mapped && dst && options.enabled) {
+    PixelKernels::Pack(static_cast<const uint8_t *>(mapped), dst, readback.width, readback.height,
+                       readback.width * 4, readback.width * outSize, options.flipY, packFormat,
+                       options.unpremultiply);
+  } else if (mapped && dst) {
+    memcpy(dst, mapped, length);
   }
+  if (mapped) {
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer);
+  inst->recycleReadbackBuffer(readback.buffer);
 
-  glRenderbufferStorage(target, internalformat, width, height);
+  info.GetReturnValue().Set(result);
 }
 
-GL_METHOD(GetShaderSource) {
-  GL_BOILERPLATE;
+// Frame encoding
 
-  GLint shader = Nan::To<int32_t>(info[0]).ToChecked();
+// Encodes the pixels read by EncodeFrame on the libuv threadpool and hands the image to JS as a
+// Buffer.
+class EncodeWorker : public Nan::AsyncWorker {
+public:
+  EncodeWorker(Nan::Callback *callback, uint8_t *pixels, size_t width, size_t height, bool alpha,
+               bool unpremultiply, int level)
+      : Nan::AsyncWorker(callback, "webgl:encodeFrame"), pixels(pixels), width(width),
+        height(height), alpha(alpha), unpremultiply(unpremultiply), level(level) {}
 
-  GLint len;
-  glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &len);
+  void Execute() override {
+    // Rows come out of glReadPixels bottom-up
+    if (!PngEncoder::Encode(pixels.get(), width, height, alpha, true, unpremultiply, level, png)) {
+      SetErrorMessage("PNG encoding failed");
+    }
+    pixels.reset();
+  }
 
-  GLchar *source = new GLchar[len];
-  glGetShaderSource(shader, len, NULL, source);
-  v8::Local<v8::String> str = Nan::New<v8::String>(source).ToLocalChecked();
-  delete[] source;
+  void HandleOKCallback() override {
+    Nan::HandleScope scope;
+    v8::Local<v8::Value> argv[] = {
+        Nan::Null(),
+        Nan::CopyBuffer(reinterpret_cast<const char *>(png.data()), png.size()).ToLocalChecked()};
+    callback->Call(2, argv, async_resource);
+  }
 
-  info.GetReturnValue().Set(str);
-}
+private:
+  std::unique_ptr<uint8_t[]> pixels;
+  size_t width;
+  size_t height;
+  bool alpha;
+  bool unpremultiply;
+  int level;
+  std::vector<uint8_t> png;
+};
 
-GL_METHOD(ReadPixels) {
+// Reads a rectangle of the read framebuffer and queues it for encoding. Returns false, without
+// calling back, if the pixels could not be read.
+GL_METHOD(EncodeFrame) {
   GL_BOILERPLATE;
+  inst->finishUploads();
 
   GLint x = Nan::To<int32_t>(info[0]).ToChecked();
   GLint y = Nan::To<int32_t>(info[1]).ToChecked();
   GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
-  GLenum format = Nan::To<int32_t>(info[4]).ToChecked();
-  GLenum type = Nan::To<int32_t>(info[5]).ToChecked();
-  Nan::TypedArrayContents<char> pixels(info[6]);
+  GLint right = Nan::To<int32_t>(info[4]).ToChecked();
+  GLint top = Nan::To<int32_t>(info[5]).ToChecked();
+  bool alpha = Nan::To<bool>(info[6]).ToChecked();
+  bool unpremultiply = Nan::To<bool>(info[7]).ToChecked();
+  int level = Nan::To<int32_t>(info[8]).ToChecked();
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(false));
+  if (width <= 0 || height <= 0 || !info[9]->IsFunction()) {
+    return;
+  }
+  // Zeroed, so pixels outside the framebuffer, which glReadPixels leaves alone, encode as zero
+  std::unique_ptr<uint8_t[]> pixels(
+      new (std::nothrow) uint8_t[static_cast<size_t>(width) * height * 4]());
+  if (!pixels) {
+    inst->setError(GL_OUT_OF_MEMORY);
+    return;
+  }
+
+  // Only the pixels left of `right` and below `top` are read. A drawing buffer whose storage is
+  // larger than its size passes its size, so what lies past it encodes as zero too.
+  GLsizei readWidth = std::min<GLsizei>(width, right - x);
+  GLsizei readHeight = std::min<GLsizei>(height, top - y);
+
+  // The pixels go straight to the encoder, never through a pack buffer or a JS array
+  GLint packBuffer = 0;
+  if (inst->isWebGL2) {
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  }
+  inst->beginCheckedCall();
+  {
+    TightPackScope tight(true, inst->isWebGL2);
+    if (readWidth == width) {
+      glReadPixels(x, y, width, std::max(readHeight, 0), GL_RGBA, GL_UNSIGNED_BYTE, pixels.get());
+    } else {
+      for (GLsizei row = 0; row < readHeight; ++row) {
+        glReadPixels(x, y + row, std::max(readWidth, 0), 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                     pixels.get() + static_cast<size_t>(row) * width * 4);
+      }
+    }
+  }
+  GLenum error = inst->endCheckedCall();
+  if (inst->isWebGL2) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, packBuffer);
+  }
+  if (error != GL_NO_ERROR) {
+    return;
+  }
 
-  glReadPixels(x, y, width, height, format, type, *pixels);
+  Nan::AsyncQueueWorker(new EncodeWorker(new Nan::Callback(info[9].As<v8::Function>()),
+                                         pixels.release(), width, height, alpha, unpremultiply,
+                                         level));
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(true));
 }
 
 GL_METHOD(GetTexParameter) {
@@ -1793,6 +3424,116 @@ GL_METHOD(GetActiveUniform) {
   delete[] name;
 }
 
+// Link status, attribute, uniform, uniform block and varying counts
+static const size_t PROGRAM_REFLECTION_HEADER = 5;
+
+// Everything _fixupLink needs after a link in one call. Returns { layout, names }: layout is an
+// Int32Array holding the link status and the number of active attributes, uniforms, uniform
+// blocks and transform feedback varyings, followed by one record per item except blocks:
+//   attribute: type, size
+//   uniform:   type, size, location, and for arrays whose name ends in [0] the locations of
+//              elements 1 to size - 1
+//   varying:   type, size
+// names holds the name of every item in the same order, blocks included, each terminated by
+// '\0'. Active attributes are also bound to the location the link gave them, so relinking
+// keeps them.
+GL_METHOD(GetProgramReflection) {
+  GL_BOILERPLATE;
+
+  GLuint program = Nan::To<int32_t>(info[0]).ToChecked();
+
+  std::vector<int32_t> layout(PROGRAM_REFLECTION_HEADER, 0);
+  std::string names;
+  std::vector<char> name;
+
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  layout[0] = linked;
+  inst->shareProgramBinary(program);
+
+  if (linked) {
+    GLint count = 0;
+    GLint maxLength = 0;
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize(std::max(maxLength, 1));
+    layout[1] = count;
+    for (GLint i = 0; i < count; ++i) {
+      length = 0;
+      glGetActiveAttrib(program, i, maxLength, &length, &size, &type, name.data());
+      name[length] = '\0';
+      GLint location = glGetAttribLocation(program, name.data());
+      if (location >= 0) {
+        inst->bindAttribLocation(program, location, name.data());
+      }
+      layout.insert(layout.end(), {int32_t(type), size});
+      names.append(name.data(), length + 1);
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    name.resize(std::max(maxLength, 1));
+    layout[2] = count;
+    for (GLint i = 0; i < count; ++i) {
+      length = 0;
+      glGetActiveUniform(program, i, maxLength, &length, &size, &type, name.data());
+      name[length] = '\0';
+      GLint location = glGetUniformLocation(program, name.data());
+      layout.insert(layout.end(), {int32_t(type), size, location});
+      names.append(name.data(), length + 1);
+
+      // GL does not have to give array elements consecutive locations
+      if (size > 1 && location >= 0 && length >= 3 && strcmp(name.data() + length - 3, "[0]") == 0) {
+        std::string element(name.data(), length - 3);
+        for (GLint j = 1; j < size; ++j) {
+          layout.push_back(
+              glGetUniformLocation(program, (element + "[" + std::to_string(j) + "]").c_str()));
+        }
+      }
+    }
+
+    if (inst->isWebGL2) {
+      glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+      glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+      name.resize(std::max(maxLength, 1));
+      layout[3] = count;
+      for (GLint i = 0; i < count; ++i) {
+        length = 0;
+        glGetActiveUniformBlockName(program, i, maxLength, &length, name.data());
+        names.append(name.data(), length);
+        names.push_back('\0');
+      }
+
+      glGetProgramiv(program, GL_TRANSFORM_FEEDBACK_VARYINGS, &count);
+      glGetProgramiv(program, GL_TRANSFORM_FEEDBACK_VARYING_MAX_LENGTH, &maxLength);
+      name.resize(std::max(maxLength, 1));
+      layout[4] = count;
+      for (GLint i = 0; i < count; ++i) {
+        length = 0;
+        glGetTransformFeedbackVarying(program, i, maxLength, &length, &size, &type, name.data());
+        layout.insert(layout.end(), {int32_t(type), size});
+        names.append(name.data(), length);
+        names.push_back('\0');
+      }
+    }
+  }
+
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(v8::Isolate::GetCurrent(), layout.size() * sizeof(int32_t));
+  memcpy(buffer->GetBackingStore()->Data(), layout.data(), layout.size() * sizeof(int32_t));
+
+  v8::Local<v8::Object> reflection = Nan::New<v8::Object>();
+  Nan::Set(reflection, Nan::New("layout").ToLocalChecked(),
+           v8::Int32Array::New(buffer, 0, layout.size()));
+  Nan::Set(reflection, Nan::New("names").ToLocalChecked(),
+           Nan::New<v8::String>(names.data(), int(names.size())).ToLocalChecked());
+  info.GetReturnValue().Set(reflection);
+}
+
 GL_METHOD(GetAttachedShaders) {
   GL_BOILERPLATE;
 
@@ -1986,9 +3727,14 @@ GL_METHOD(GetFramebufferAttachmentParameter) {
   GLenum pname = Nan::To<int32_t>(info[2]).ToChecked();
 
   GLint params = 0;
+  inst->beginCheckedCall();
   glGetFramebufferAttachmentParameteriv(target, attachment, pname, &params);
 
-  info.GetReturnValue().Set(Nan::New<v8::Integer>(params));
+  if (inst->endCheckedCall() != GL_NO_ERROR) {
+    info.GetReturnValue().Set(Nan::Null());
+  } else {
+    info.GetReturnValue().Set(Nan::New<v8::Integer>(params));
+  }
 }
 
 GL_METHOD(GetProgramInfoLog) {
@@ -2134,6 +3880,7 @@ GL_METHOD(GetExtension) {
         printf("Warning: could not enable ANGLE extension: %s\n", ext.c_str());
       } else if (inst->enabledExtensions.count(ext.c_str()) == 0) {
         glRequestExtensionANGLE(ext.c_str());
+        inst->requestedExtensions = true;
         const char *extensionsString = (const char *)glGetString(GL_EXTENSIONS);
         inst->enabledExtensions = GetStringSetFromCString(extensionsString);
       }
@@ -2250,6 +3997,8 @@ GL_METHOD(BindVertexArrayOES) {
 
   GLuint array = Nan::To<uint32_t>(info[0]).ToChecked();
 
+  // The element array buffer binding belongs to the vertex array object
+  inst->stateCache.elementArrayBuffer = GLStateCache::UNKNOWN;
   glBindVertexArrayOES(array);
 }
 
@@ -2268,6 +4017,7 @@ GL_METHOD(DeleteVertexArrayOES) {
 
   GLuint array = Nan::To<uint32_t>(info[0]).ToChecked();
   inst->unregisterGLObj(GLOBJECT_TYPE_VERTEX_ARRAY, array);
+  inst->stateCache.elementArrayBuffer = GLStateCache::UNKNOWN;
 
   glDeleteVertexArraysOES(1, &array);
 }
@@ -2301,6 +4051,7 @@ GL_METHOD(GetBufferSubData) {
 
 GL_METHOD(BlitFramebuffer) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLint srcX0 = Nan::To<int32_t>(info[0]).ToChecked();
   GLint srcY0 = Nan::To<int32_t>(info[1]).ToChecked();
   GLint srcX1 = Nan::To<int32_t>(info[2]).ToChecked();
@@ -2378,8 +4129,164 @@ GL_METHOD(RenderbufferStorageMultisample) {
   glRenderbufferStorageMultisample(target, samples, internalformat, width, height);
 }
 
+// Multisampled drawing buffer
+
+bool WebGLRenderingContext::enableDrawingBufferMultisample() {
+  if (isWebGL2) {
+    return true;
+  }
+  static const char *const REQUIRED[] = {"GL_ANGLE_framebuffer_multisample",
+                                         "GL_ANGLE_framebuffer_blit", "GL_OES_rgb8_rgba8"};
+  for (const char *extension : REQUIRED) {
+    if (enabledExtensions.count(extension)) {
+      continue;
+    }
+    if (!requestableExtensions.count(extension)) {
+      return false;
+    }
+    glRequestExtensionANGLE(extension);
+    enabledExtensions.insert(extension);
+  }
+  return true;
+}
+
+// Largest sample count up to the requested one that the drawing buffer can use, or 0 if it
+// cannot be multisampled.
+GL_METHOD(DrawingBufferSamples) {
+  GL_BOILERPLATE;
+
+  GLint requested = Nan::To<int32_t>(info[0]).ToChecked();
+  GLint samples = 0;
+  if (requested > 0 && inst->enableDrawingBufferMultisample()) {
+    glGetIntegerv(GL_MAX_SAMPLES, &samples);
+    samples = std::min(samples, requested);
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(samples));
+}
+
+// Multisampled storage for the bound renderbuffer, taking the same formats the drawing buffer
+// uses for its single sampled attachments.
+GL_METHOD(DrawingBufferStorageMultisample) {
+  GL_BOILERPLATE;
+
+  GLsizei samples = Nan::To<int32_t>(info[0]).ToChecked();
+  GLenum internalformat = Nan::To<int32_t>(info[1]).ToChecked();
+  GLsizei width = Nan::To<int32_t>(info[2]).ToChecked();
+  GLsizei height = Nan::To<int32_t>(info[3]).ToChecked();
+
+  if (internalformat == GL_DEPTH_STENCIL_OES) {
+    internalformat = GL_DEPTH24_STENCIL8_OES;
+  } else if (internalformat == GL_DEPTH_COMPONENT32_OES) {
+    internalformat = inst->preferredDepth;
+  } else if (internalformat == GL_RGBA) {
+    internalformat = GL_RGBA8_OES;
+  } else if (internalformat == GL_RGB) {
+    internalformat = GL_RGB8_OES;
+  }
+
+  inst->beginCheckedCall();
+  if (inst->isWebGL2) {
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalformat, width, height);
+  } else {
+    glRenderbufferStorageMultisampleANGLE(GL_RENDERBUFFER, samples, internalformat, width, height);
+  }
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
+}
+
+// Resolves the multisampled framebuffer `src` into `dst` and leaves `dst` bound for reading, so
+// the call that needs the pixels reads the resolved ones. The blit ignores the scissor test and
+// cannot raise errors of its own.
+GL_METHOD(ResolveDrawingBuffer) {
+  GL_BOILERPLATE;
+
+  GLuint src = Nan::To<uint32_t>(info[0]).ToChecked();
+  GLuint dst = Nan::To<uint32_t>(info[1]).ToChecked();
+  GLint width = Nan::To<int32_t>(info[2]).ToChecked();
+  GLint height = Nan::To<int32_t>(info[3]).ToChecked();
+
+  inst->beginCheckedCall();
+  GLint drawFramebuffer = 0;
+  glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+  GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+  if (scissor) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, src);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst);
+  if (inst->isWebGL2) {
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  } else {
+    glBlitFramebufferANGLE(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT,
+                           GL_NEAREST);
+  }
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, dst);
+  if (scissor) {
+    glEnable(GL_SCISSOR_TEST);
+  }
+  while (glGetError() != GL_NO_ERROR) {
+  }
+}
+
+// Clears the bound framebuffer to the contents of a freshly allocated drawing buffer, whatever
+// clear values, write masks and scissor test the user has set. The state is restored afterwards.
+GL_METHOD(ClearDrawingBuffer) {
+  GL_BOILERPLATE;
+
+  GLbitfield mask = Nan::To<uint32_t>(info[0]).ToChecked();
+
+  inst->beginCheckedCall();
+  GLfloat clearColor[4];
+  GLfloat clearDepth = 1;
+  GLint clearStencil = 0;
+  GLboolean colorMask[4];
+  GLboolean depthMask = GL_TRUE;
+  GLint stencilMask = 0;
+  GLint stencilBackMask = 0;
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+  glGetFloatv(GL_DEPTH_CLEAR_VALUE, &clearDepth);
+  glGetIntegerv(GL_STENCIL_CLEAR_VALUE, &clearStencil);
+  glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+  glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+  glGetIntegerv(GL_STENCIL_WRITEMASK, &stencilMask);
+  glGetIntegerv(GL_STENCIL_BACK_WRITEMASK, &stencilBackMask);
+  GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+  GLboolean discard = inst->isWebGL2 && glIsEnabled(GL_RASTERIZER_DISCARD);
+
+  if (scissor) {
+    glDisable(GL_SCISSOR_TEST);
+  }
+  if (discard) {
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
+  glClearColor(0, 0, 0, 0);
+  glClearDepthf(1);
+  glClearStencil(0);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  glDepthMask(GL_TRUE);
+  glStencilMask(0xffffffffu);
+  glClear(mask);
+
+  glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+  glClearDepthf(clearDepth);
+  glClearStencil(clearStencil);
+  glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+  glDepthMask(depthMask);
+  glStencilMaskSeparate(GL_FRONT, stencilMask);
+  glStencilMaskSeparate(GL_BACK, stencilBackMask);
+  if (scissor) {
+    glEnable(GL_SCISSOR_TEST);
+  }
+  if (discard) {
+    glEnable(GL_RASTERIZER_DISCARD);
+  }
+  while (glGetError() != GL_NO_ERROR) {
+  }
+}
+
 GL_METHOD(TexStorage2D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLsizei levels = Nan::To<int32_t>(info[1]).ToChecked();
   GLenum internalformat = Nan::To<int32_t>(info[2]).ToChecked();
@@ -2450,6 +4357,7 @@ GL_METHOD(TexSubImage3D) {
 
 GL_METHOD(CopyTexSubImage3D) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum target = Nan::To<int32_t>(info[0]).ToChecked();
   GLint level = Nan::To<int32_t>(info[1]).ToChecked();
   GLint xoffset = Nan::To<int32_t>(info[2]).ToChecked();
@@ -2459,7 +4367,9 @@ GL_METHOD(CopyTexSubImage3D) {
   GLint y = Nan::To<int32_t>(info[6]).ToChecked();
   GLsizei width = Nan::To<int32_t>(info[7]).ToChecked();
   GLsizei height = Nan::To<int32_t>(info[8]).ToChecked();
+  inst->beginCheckedCall();
   glCopyTexSubImage3D(target, level, xoffset, yoffset, zoffset, x, y, width, height);
+  info.GetReturnValue().Set(Nan::New<v8::Integer>(inst->endCheckedCall()));
 }
 
 GL_METHOD(CompressedTexImage3D) {
@@ -2703,6 +4613,7 @@ GL_METHOD(VertexAttribDivisor) {
 
 GL_METHOD(DrawArraysInstanced) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLint first = Nan::To<int32_t>(info[1]).ToChecked();
   GLsizei count = Nan::To<int32_t>(info[2]).ToChecked();
@@ -2712,6 +4623,7 @@ GL_METHOD(DrawArraysInstanced) {
 
 GL_METHOD(DrawElementsInstanced) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLsizei count = Nan::To<int32_t>(info[1]).ToChecked();
   GLenum type = Nan::To<int32_t>(info[2]).ToChecked();
@@ -2722,6 +4634,7 @@ GL_METHOD(DrawElementsInstanced) {
 
 GL_METHOD(DrawRangeElements) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum mode = Nan::To<int32_t>(info[0]).ToChecked();
   GLuint start = Nan::To<uint32_t>(info[1]).ToChecked();
   GLuint end = Nan::To<uint32_t>(info[2]).ToChecked();
@@ -2746,6 +4659,7 @@ GL_METHOD(DrawBuffers) {
 
 GL_METHOD(ClearBufferfv) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum buffer = Nan::To<int32_t>(info[0]).ToChecked();
   GLint drawbuffer = Nan::To<int32_t>(info[1]).ToChecked();
   auto values = info[2].As<v8::ArrayBufferView>();
@@ -2755,6 +4669,7 @@ GL_METHOD(ClearBufferfv) {
 
 GL_METHOD(ClearBufferiv) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum buffer = Nan::To<int32_t>(info[0]).ToChecked();
   GLint drawbuffer = Nan::To<int32_t>(info[1]).ToChecked();
   auto values = info[2].As<v8::ArrayBufferView>();
@@ -2764,6 +4679,7 @@ GL_METHOD(ClearBufferiv) {
 
 GL_METHOD(ClearBufferuiv) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum buffer = Nan::To<int32_t>(info[0]).ToChecked();
   GLint drawbuffer = Nan::To<int32_t>(info[1]).ToChecked();
   auto values = info[2].As<v8::ArrayBufferView>();
@@ -2773,6 +4689,7 @@ GL_METHOD(ClearBufferuiv) {
 
 GL_METHOD(ClearBufferfi) {
   GL_BOILERPLATE;
+  inst->finishUploads();
   GLenum buffer = Nan::To<int32_t>(info[0]).ToChecked();
   GLint drawbuffer = Nan::To<int32_t>(info[1]).ToChecked();
   GLfloat depth = Nan::To<double>(info[2]).ToChecked();
@@ -2784,12 +4701,14 @@ GL_METHOD(CreateQuery) {
   GL_BOILERPLATE;
   GLuint query;
   glGenQueries(1, &query);
+  inst->registerGLObj(GLOBJECT_TYPE_QUERY, query);
   info.GetReturnValue().Set(Nan::New(query));
 }
 
 GL_METHOD(DeleteQuery) {
   GL_BOILERPLATE;
   GLuint query = Nan::To<uint32_t>(info[0]).ToChecked();
+  inst->unregisterGLObj(GLOBJECT_TYPE_QUERY, query);
   glDeleteQueries(1, &query);
 }
 
@@ -2835,12 +4754,14 @@ GL_METHOD(CreateSampler) {
   GL_BOILERPLATE;
   GLuint sampler;
   glGenSamplers(1, &sampler);
+  inst->registerGLObj(GLOBJECT_TYPE_SAMPLER, sampler);
   info.GetReturnValue().Set(Nan::New(sampler));
 }
 
 GL_METHOD(DeleteSampler) {
   GL_BOILERPLATE;
   GLuint sampler = Nan::To<uint32_t>(info[0]).ToChecked();
+  inst->unregisterGLObj(GLOBJECT_TYPE_SAMPLER, sampler);
   glDeleteSamplers(1, &sampler);
 }
 
@@ -2941,12 +4862,14 @@ GL_METHOD(CreateTransformFeedback) {
   GL_BOILERPLATE;
   GLuint tf;
   glGenTransformFeedbacks(1, &tf);
+  inst->registerGLObj(GLOBJECT_TYPE_TRANSFORM_FEEDBACK, tf);
   info.GetReturnValue().Set(Nan::New(tf));
 }
 
 GL_METHOD(DeleteTransformFeedback) {
   GL_BOILERPLATE;
   GLuint tf = Nan::To<uint32_t>(info[0]).ToChecked();
+  inst->unregisterGLObj(GLOBJECT_TYPE_TRANSFORM_FEEDBACK, tf);
   glDeleteTransformFeedbacks(1, &tf);
 }
 
@@ -2981,13 +4904,16 @@ GL_METHOD(TransformFeedbackVaryings) {
   auto varyings = info[1].As<v8::Array>();
   GLenum bufferMode = Nan::To<int32_t>(info[2]).ToChecked();
   GLsizei count = varyings->Length();
-  const char **varyingStrings = new const char *[count];
+  std::vector<std::string> names(count);
+  std::vector<const char *> varyingStrings(count);
   for (GLsizei i = 0; i < count; i++) {
     Nan::Utf8String str(Nan::Get(varyings, i).ToLocalChecked());
-    varyingStrings[i] = *str;
+    names[i].assign(*str, str.length());
+    varyingStrings[i] = names[i].c_str();
   }
-  glTransformFeedbackVaryings(program, count, varyingStrings, bufferMode);
-  delete[] varyingStrings;
+  glTransformFeedbackVaryings(program, count, varyingStrings.data(), bufferMode);
+
+  inst->feedbackVaryings[program] = {bufferMode, std::move(names)};
 }
 
 GL_METHOD(GetTransformFeedbackVarying) {
@@ -3125,12 +5051,15 @@ GL_METHOD(CreateVertexArray) {
   GL_BOILERPLATE;
   GLuint vao;
   glGenVertexArrays(1, &vao);
+  inst->registerGLObj(GLOBJECT_TYPE_VERTEX_ARRAY, vao);
   info.GetReturnValue().Set(Nan::New(vao));
 }
 
 GL_METHOD(DeleteVertexArray) {
   GL_BOILERPLATE;
   GLuint vao = Nan::To<uint32_t>(info[0]).ToChecked();
+  inst->unregisterGLObj(GLOBJECT_TYPE_VERTEX_ARRAY, vao);
+  inst->stateCache.elementArrayBuffer = GLStateCache::UNKNOWN;
   glDeleteVertexArrays(1, &vao);
 }
 
@@ -3144,5 +5073,390 @@ GL_METHOD(IsVertexArray) {
 GL_METHOD(BindVertexArray) {
   GL_BOILERPLATE;
   GLuint vao = Nan::To<uint32_t>(info[0]).ToChecked();
+  inst->stateCache.elementArrayBuffer = GLStateCache::UNKNOWN;
   glBindVertexArray(vao);
 }
+
+// Command buffer
+//
+// Side-effect only calls can be recorded by the JS layer into an Int32Array and replayed here in a
+// single crossing. Each command is an opcode followed by its arguments, one 32-bit word each.
+// The argument signature uses 'i' for GLint/GLenum, 'u' for GLuint and byte offsets, 'b' for
+// GLboolean and 'f' for GLfloat, which is stored as its bit pattern.
+
+enum CommandOpcode {
+  CMD_ACTIVE_TEXTURE,
+  CMD_BIND_BUFFER,
+  CMD_BIND_RENDERBUFFER,
+  CMD_BLEND_COLOR,
+  CMD_BLEND_EQUATION,
+  CMD_BLEND_EQUATION_SEPARATE,
+  CMD_BLEND_FUNC,
+  CMD_BLEND_FUNC_SEPARATE,
+  CMD_CLEAR,
+  CMD_CLEAR_COLOR,
+  CMD_CLEAR_DEPTH,
+  CMD_CLEAR_STENCIL,
+  CMD_COLOR_MASK,
+  CMD_CULL_FACE,
+  CMD_DEPTH_FUNC,
+  CMD_DEPTH_MASK,
+  CMD_DEPTH_RANGE,
+  CMD_DISABLE,
+  CMD_DISABLE_VERTEX_ATTRIB_ARRAY,
+  CMD_DRAW_ARRAYS,
+  CMD_DRAW_ELEMENTS,
+  CMD_ENABLE,
+  CMD_ENABLE_VERTEX_ATTRIB_ARRAY,
+  CMD_FRONT_FACE,
+  CMD_LINE_WIDTH,
+  CMD_POLYGON_OFFSET,
+  CMD_SCISSOR,
+  CMD_STENCIL_FUNC,
+  CMD_STENCIL_FUNC_SEPARATE,
+  CMD_STENCIL_MASK,
+  CMD_STENCIL_MASK_SEPARATE,
+  CMD_STENCIL_OP,
+  CMD_STENCIL_OP_SEPARATE,
+  CMD_UNIFORM1F,
+  CMD_UNIFORM2F,
+  CMD_UNIFORM3F,
+  CMD_UNIFORM4F,
+  CMD_UNIFORM1I,
+  CMD_UNIFORM2I,
+  CMD_UNIFORM3I,
+  CMD_UNIFORM4I,
+  CMD_USE_PROGRAM,
+  CMD_VERTEX_ATTRIB1F,
+  CMD_VERTEX_ATTRIB2F,
+  CMD_VERTEX_ATTRIB3F,
+  CMD_VERTEX_ATTRIB4F,
+  CMD_VERTEX_ATTRIB_POINTER,
+  CMD_VIEWPORT,
+  CMD_DRAW_ARRAYS_INSTANCED_ANGLE,
+  CMD_DRAW_ELEMENTS_INSTANCED_ANGLE,
+  CMD_VERTEX_ATTRIB_DIVISOR_ANGLE,
+  CMD_BIND_VERTEX_ARRAY,
+  CMD_DRAW_ARRAYS_INSTANCED,
+  CMD_DRAW_ELEMENTS_INSTANCED,
+  CMD_VERTEX_ATTRIB_DIVISOR,
+  CMD_COUNT
+};
+
+struct CommandInfo {
+  const char *name;
+  const char *args;
+};
+
+// Indexed by CommandOpcode, names match the methods registered in bindings.cc
+static const CommandInfo COMMANDS[CMD_COUNT] = {
+    {"activeTexture", "i"},
+    {"bindBuffer", "iu"},
+    {"bindRenderbuffer", "iu"},
+    {"blendColor", "ffff"},
+    {"blendEquation", "i"},
+    {"blendEquationSeparate", "ii"},
+    {"blendFunc", "ii"},
+    {"blendFuncSeparate", "iiii"},
+    {"clear", "i"},
+    {"clearColor", "ffff"},
+    {"clearDepth", "f"},
+    {"clearStencil", "i"},
+    {"colorMask", "bbbb"},
+    {"cullFace", "i"},
+    {"depthFunc", "i"},
+    {"depthMask", "b"},
+    {"depthRange", "ff"},
+    {"disable", "i"},
+    {"disableVertexAttribArray", "i"},
+    {"drawArrays", "iii"},
+    {"drawElements", "iiiu"},
+    {"enable", "i"},
+    {"enableVertexAttribArray", "i"},
+    {"frontFace", "i"},
+    {"lineWidth", "f"},
+    {"polygonOffset", "ff"},
+    {"scissor", "iiii"},
+    {"stencilFunc", "iiu"},
+    {"stencilFuncSeparate", "iiiu"},
+    {"stencilMask", "u"},
+    {"stencilMaskSeparate", "iu"},
+    {"stencilOp", "iii"},
+    {"stencilOpSeparate", "iiii"},
+    {"uniform1f", "if"},
+    {"uniform2f", "iff"},
+    {"uniform3f", "ifff"},
+    {"uniform4f", "iffff"},
+    {"uniform1i", "ii"},
+    {"uniform2i", "iii"},
+    {"uniform3i", "iiii"},
+    {"uniform4i", "iiiii"},
+    {"useProgram", "i"},
+    {"vertexAttrib1f", "if"},
+    {"vertexAttrib2f", "iff"},
+    {"vertexAttrib3f", "ifff"},
+    {"vertexAttrib4f", "iffff"},
+    {"vertexAttribPointer", "iiibiu"},
+    {"viewport", "iiii"},
+    {"_drawArraysInstancedANGLE", "iiuu"},
+    {"_drawElementsInstancedANGLE", "iiiiu"},
+    {"_vertexAttribDivisorANGLE", "uu"},
+    {"bindVertexArray", "u"},
+    {"drawArraysInstanced", "iiii"},
+    {"drawElementsInstanced", "iiiui"},
+    {"vertexAttribDivisor", "uu"},
+};
+
+static inline GLfloat CommandFloat(int32_t word) {
+  GLfloat value;
+  std::memcpy(&value, &word, sizeof(value));
+  return value;
+}
+
+v8::Local<v8::Object> WebGLRenderingContext::CommandBufferOps() {
+  Nan::EscapableHandleScope scope;
+  v8::Local<v8::Object> ops = Nan::New<v8::Object>();
+  for (int opcode = 0; opcode < CMD_COUNT; ++opcode) {
+    v8::Local<v8::Object> op = Nan::New<v8::Object>();
+    Nan::Set(op, Nan::New("opcode").ToLocalChecked(), Nan::New(opcode));
+    Nan::Set(op, Nan::New("args").ToLocalChecked(), Nan::New(COMMANDS[opcode].args).ToLocalChecked());
+    Nan::Set(ops, Nan::New(COMMANDS[opcode].name).ToLocalChecked(), op);
+  }
+  return scope.Escape(ops);
+}
+
+void WebGLRenderingContext::executeCommands(const int32_t *words, size_t length) {
+  size_t pos = 0;
+  while (pos < length) {
+    int32_t opcode = words[pos++];
+    if (opcode < 0 || opcode >= CMD_COUNT) {
+      setError(GL_INVALID_OPERATION);
+      return;
+    }
+    size_t argc = std::strlen(COMMANDS[opcode].args);
+    if (pos + argc > length) {
+      setError(GL_INVALID_OPERATION);
+      return;
+    }
+    const int32_t *a = words + pos;
+    pos += argc;
+
+    switch (opcode) {
+    case CMD_ACTIVE_TEXTURE:
+      cachedActiveTexture(a[0]);
+      break;
+    case CMD_BIND_BUFFER:
+      cachedBindBuffer(a[0], static_cast<GLuint>(a[1]));
+      break;
+    case CMD_BIND_RENDERBUFFER:
+      glBindRenderbuffer(a[0], static_cast<GLuint>(a[1]));
+      break;
+    case CMD_BLEND_COLOR:
+      glBlendColor(CommandFloat(a[0]), CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]));
+      break;
+    case CMD_BLEND_EQUATION:
+      glBlendEquation(a[0]);
+      break;
+    case CMD_BLEND_EQUATION_SEPARATE:
+      glBlendEquationSeparate(a[0], a[1]);
+      break;
+    case CMD_BLEND_FUNC:
+      cachedBlendFuncSeparate(a[0], a[1], a[0], a[1]);
+      break;
+    case CMD_BLEND_FUNC_SEPARATE:
+      cachedBlendFuncSeparate(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_CLEAR:
+      glClear(a[0]);
+      break;
+    case CMD_CLEAR_COLOR:
+      glClearColor(CommandFloat(a[0]), CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]));
+      break;
+    case CMD_CLEAR_DEPTH:
+      glClearDepthf(CommandFloat(a[0]));
+      break;
+    case CMD_CLEAR_STENCIL:
+      glClearStencil(a[0]);
+      break;
+    case CMD_COLOR_MASK:
+      glColorMask(a[0] != 0, a[1] != 0, a[2] != 0, a[3] != 0);
+      break;
+    case CMD_CULL_FACE:
+      glCullFace(a[0]);
+      break;
+    case CMD_DEPTH_FUNC:
+      cachedDepthFunc(a[0]);
+      break;
+    case CMD_DEPTH_MASK:
+      glDepthMask(a[0] != 0);
+      break;
+    case CMD_DEPTH_RANGE:
+      glDepthRangef(CommandFloat(a[0]), CommandFloat(a[1]));
+      break;
+    case CMD_DISABLE:
+      cachedSetCapability(a[0], false);
+      break;
+    case CMD_DISABLE_VERTEX_ATTRIB_ARRAY:
+      glDisableVertexAttribArray(a[0]);
+      break;
+    case CMD_DRAW_ARRAYS:
+      glDrawArrays(a[0], a[1], a[2]);
+      break;
+    case CMD_DRAW_ELEMENTS:
+      glDrawElements(a[0], a[1], a[2],
+                     reinterpret_cast<GLvoid *>(static_cast<size_t>(static_cast<uint32_t>(a[3]))));
+      break;
+    case CMD_ENABLE:
+      cachedSetCapability(a[0], true);
+      break;
+    case CMD_ENABLE_VERTEX_ATTRIB_ARRAY:
+      glEnableVertexAttribArray(a[0]);
+      break;
+    case CMD_FRONT_FACE:
+      glFrontFace(a[0]);
+      break;
+    case CMD_LINE_WIDTH:
+      glLineWidth(CommandFloat(a[0]));
+      break;
+    case CMD_POLYGON_OFFSET:
+      glPolygonOffset(CommandFloat(a[0]), CommandFloat(a[1]));
+      break;
+    case CMD_SCISSOR:
+      cachedScissor(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_STENCIL_FUNC:
+      glStencilFunc(a[0], a[1], static_cast<GLuint>(a[2]));
+      break;
+    case CMD_STENCIL_FUNC_SEPARATE:
+      glStencilFuncSeparate(a[0], a[1], a[2], static_cast<GLuint>(a[3]));
+      break;
+    case CMD_STENCIL_MASK:
+      glStencilMask(static_cast<GLuint>(a[0]));
+      break;
+    case CMD_STENCIL_MASK_SEPARATE:
+      glStencilMaskSeparate(a[0], static_cast<GLuint>(a[1]));
+      break;
+    case CMD_STENCIL_OP:
+      glStencilOp(a[0], a[1], a[2]);
+      break;
+    case CMD_STENCIL_OP_SEPARATE:
+      glStencilOpSeparate(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_UNIFORM1F:
+      glUniform1f(a[0], CommandFloat(a[1]));
+      break;
+    case CMD_UNIFORM2F:
+      glUniform2f(a[0], CommandFloat(a[1]), CommandFloat(a[2]));
+      break;
+    case CMD_UNIFORM3F:
+      glUniform3f(a[0], CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]));
+      break;
+    case CMD_UNIFORM4F:
+      glUniform4f(a[0], CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]),
+                  CommandFloat(a[4]));
+      break;
+    case CMD_UNIFORM1I:
+      glUniform1i(a[0], a[1]);
+      break;
+    case CMD_UNIFORM2I:
+      glUniform2i(a[0], a[1], a[2]);
+      break;
+    case CMD_UNIFORM3I:
+      glUniform3i(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_UNIFORM4I:
+      glUniform4i(a[0], a[1], a[2], a[3], a[4]);
+      break;
+    case CMD_USE_PROGRAM:
+      cachedUseProgram(a[0]);
+      break;
+    case CMD_VERTEX_ATTRIB1F:
+      glVertexAttrib1f(a[0], CommandFloat(a[1]));
+      break;
+    case CMD_VERTEX_ATTRIB2F:
+      glVertexAttrib2f(a[0], CommandFloat(a[1]), CommandFloat(a[2]));
+      break;
+    case CMD_VERTEX_ATTRIB3F:
+      glVertexAttrib3f(a[0], CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]));
+      break;
+    case CMD_VERTEX_ATTRIB4F:
+      glVertexAttrib4f(a[0], CommandFloat(a[1]), CommandFloat(a[2]), CommandFloat(a[3]),
+                       CommandFloat(a[4]));
+      break;
+    case CMD_VERTEX_ATTRIB_POINTER:
+      glVertexAttribPointer(
+          a[0], a[1], a[2], a[3] != 0, a[4],
+          reinterpret_cast<GLvoid *>(static_cast<size_t>(static_cast<uint32_t>(a[5]))));
+      break;
+    case CMD_VIEWPORT:
+      cachedViewport(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_DRAW_ARRAYS_INSTANCED_ANGLE:
+      glDrawArraysInstancedANGLE(a[0], a[1], static_cast<GLuint>(a[2]), static_cast<GLuint>(a[3]));
+      break;
+    case CMD_DRAW_ELEMENTS_INSTANCED_ANGLE:
+      glDrawElementsInstancedANGLE(a[0], a[1], a[2],
+                                   reinterpret_cast<GLvoid *>(static_cast<uintptr_t>(a[3])),
+                                   static_cast<GLuint>(a[4]));
+      break;
+    case CMD_VERTEX_ATTRIB_DIVISOR_ANGLE:
+      glVertexAttribDivisorANGLE(static_cast<GLuint>(a[0]), static_cast<GLuint>(a[1]));
+      break;
+    case CMD_BIND_VERTEX_ARRAY:
+      stateCache.elementArrayBuffer = GLStateCache::UNKNOWN;
+      glBindVertexArray(static_cast<GLuint>(a[0]));
+      break;
+    case CMD_DRAW_ARRAYS_INSTANCED:
+      glDrawArraysInstanced(a[0], a[1], a[2], a[3]);
+      break;
+    case CMD_DRAW_ELEMENTS_INSTANCED:
+      glDrawElementsInstanced(
+          a[0], a[1], a[2],
+          reinterpret_cast<const void *>(static_cast<uintptr_t>(static_cast<uint32_t>(a[3]))), a[4]);
+      break;
+    case CMD_VERTEX_ATTRIB_DIVISOR:
+      glVertexAttribDivisor(static_cast<GLuint>(a[0]), static_cast<GLuint>(a[1]));
+      break;
+    default:
+      // Every opcode in COMMANDS must be executed here, a recorded call must never be dropped
+      assert(false && "command buffer opcode without a case in executeCommands");
+      setError(GL_INVALID_OPERATION);
+      return;
+    }
+  }
+}
+
+// Runs the recorded commands and empties the buffer. Called by GL_BOILERPLATE before every method
+// of a context with pending commands, so the native call order matches the JS call order.
+void WebGLRenderingContext::flushCommands() {
+  finishUploads();
+
+  size_t length = static_cast<uint32_t>(commandWords[0]);
+  commandWords[0] = 0;
+  if (length > commandCapacity - 1) {
+    length = commandCapacity - 1;
+  }
+  executeCommands(commandWords + 1, length);
+}
+
+GL_METHOD(SetCommandBuffer) {
+  GL_BOILERPLATE;
+
+  inst->commandBuffer.Reset();
+  inst->commandWords = NULL;
+  inst->commandCapacity = 0;
+  if (!info[0]->IsInt32Array()) {
+    return;
+  }
+  v8::Local<v8::Int32Array> words = info[0].As<v8::Int32Array>();
+  if (words->Length() == 0) {
+    return;
+  }
+  inst->commandBuffer.Reset(words);
+  inst->commandWords = reinterpret_cast<int32_t *>(
+      static_cast<uint8_t *>(words->Buffer()->GetBackingStore()->Data()) + words->ByteOffset());
+  inst->commandCapacity = words->Length();
+}
+
+// Pending commands already ran in GL_BOILERPLATE
+GL_METHOD(ExecuteCommandBuffer) { GL_BOILERPLATE; }
@@ -2,8 +2,14 @@
 #define WEBGL_H_
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -26,6 +32,9 @@ enum GLObjectType {
   GLOBJECT_TYPE_SHADER,
   GLOBJECT_TYPE_TEXTURE,
   GLOBJECT_TYPE_VERTEX_ARRAY,
+  GLOBJECT_TYPE_QUERY,
+  GLOBJECT_TYPE_SAMPLER,
+  GLOBJECT_TYPE_TRANSFORM_FEEDBACK,
 };
 
 enum GLContextState {
@@ -41,18 +50,213 @@ using GLObjectReference = std::pair<GLuint, GLObjectType>;
 using WebGLToANGLEExtensionsMap =
     std::map<std::string, std::vector<std::string>, decltype(&CaseInsensitiveCompare)>;
 
+enum GLStateTextureTarget {
+  GLSTATE_TEXTURE_2D,
+  GLSTATE_TEXTURE_CUBE_MAP,
+  GLSTATE_TEXTURE_3D,
+  GLSTATE_TEXTURE_2D_ARRAY,
+  GLSTATE_TEXTURE_TARGET_COUNT
+};
+
+// Shadow of the bindings and fixed-function state that scene graphs re-set most often. An entry is
+// UNKNOWN until a call through the cache has set it, and goes back to UNKNOWN whenever GL may have
+// changed the value behind the cache's back. Viewport and scissor use a negative width instead.
+struct GLStateCache {
+  static const GLuint UNKNOWN = 0xffffffffu;
+  static const GLint MAX_TEXTURE_UNITS = 32;
+
+  GLint textureUnits;
+  GLenum activeTexture;
+  GLuint textures[MAX_TEXTURE_UNITS][GLSTATE_TEXTURE_TARGET_COUNT];
+  GLuint arrayBuffer;
+  GLuint elementArrayBuffer;
+  GLuint program;
+  uint32_t capsKnown;
+  uint32_t capsEnabled;
+  GLenum blendFunc[4];
+  GLenum depthFunc;
+  GLint viewport[4];
+  GLint scissor[4];
+
+  // Calls dropped because they would not change anything, and calls forwarded to GL
+  double hits;
+  double misses;
+
+  GLStateCache() : textureUnits(0), hits(0), misses(0) { invalidate(); }
+
+  void invalidate();
+  void forgetBuffer(GLuint buffer);
+  void forgetTexture(GLuint texture);
+  void forgetProgram(GLuint program);
+
+  // Binding slot for target on the active texture unit, or NULL if it is not tracked
+  GLuint *textureBinding(GLenum target);
+};
+
+// Grow-only staging memory for pixel conversions, so steady-state uploads do not allocate.
+// Requests up to `limit` bytes are served from one block that is kept between calls and grows
+// geometrically. Larger requests get a block of their own, which release() frees again.
+struct ScratchArena {
+  static const size_t DEFAULT_LIMIT = 64 * 1024 * 1024;
+
+  std::unique_ptr<uint8_t[]> block;
+  size_t capacity;
+  size_t limit;
+  std::unique_ptr<uint8_t[]> oversized;
+
+  // Largest request so far, requests served without allocating, block reallocations and
+  // requests over the limit
+  size_t highWater;
+  double reuses;
+  double grows;
+  double oversizedAllocations;
+
+  ScratchArena()
+      : capacity(0), limit(DEFAULT_LIMIT), highWater(0), reuses(0), grows(0),
+        oversizedAllocations(0) {}
+
+  uint8_t *acquire(size_t bytes);
+  void release() { oversized.reset(); }
+  void clear() {
+    block.reset();
+    capacity = 0;
+    release();
+  }
+
+  // Frees the block if it is larger than the new limit
+  void setLimit(size_t bytes);
+  void resetStats();
+};
+
+// Streaming texture uploads for WebGL 2 contexts. Each slot owns a PIXEL_UNPACK_BUFFER that is
+// mapped on the main thread and filled by a libuv worker. Once the copy is done the buffer is
+// unmapped and handed to glTexSubImage2D, and a fence marks when GL has finished reading it.
+// Slots are used round robin, so uploads are also issued to GL in the order they were made.
+struct UploadSlot {
+  GLuint buffer;
+  size_t size;
+  GLsync fence;
+  bool busy;
+};
+
+struct PendingUpload {
+  size_t slot;
+  GLenum target;
+  GLuint texture;
+  GLint level;
+  GLint xoffset;
+  GLint yoffset;
+  GLsizei width;
+  GLsizei height;
+  GLenum format;
+  GLenum type;
+
+  // Unpack state when the upload was made, GL reads the staging buffer with it
+  GLint alignment;
+  GLint rowLength;
+  GLint skipRows;
+  GLint skipPixels;
+
+  // Set by the worker, guarded by UploadRing::mutex
+  bool copied;
+};
+
+struct UploadRing {
+  static const size_t SLOT_COUNT = 3;
+
+  // Nanoseconds to wait for GL to finish reading a slot before uploading synchronously instead
+  static const GLuint64 FENCE_TIMEOUT = 1000000000;
+
+  std::vector<UploadSlot> slots;
+  size_t next;
+  std::deque<std::shared_ptr<PendingUpload>> pending;
+
+  // Errors of the uploads handed to GL that the JS side has not been told about yet, oldest first
+  std::vector<GLenum> issuedUnreported;
+
+  std::mutex mutex;
+  std::condition_variable copied;
+
+  UploadRing() : next(0) {}
+};
+
+// readPixels into a PIXEL_PACK_BUFFER for WebGL 2 contexts. The fence is polled from JS, and the
+// pixels are only mapped once GL has written them, so nothing waits for the pipeline to drain.
+// Buffers go back to a small free list once read.
+struct ReadbackBuffer {
+  GLuint buffer;
+  size_t capacity;
+};
+
+// Conversions readPixels applies on the way out when it is passed options, see PixelKernels::Pack.
+// The pixels are read from GL as tightly packed RGBA rows and written tightly packed in `format`.
+struct ReadbackOptions {
+  bool enabled;
+  int format; // PixelKernels::PackFormat
+  bool flipY;
+  bool unpremultiply;
+};
+
+struct PendingReadback {
+  ReadbackBuffer buffer;
+  size_t size;
+  GLsync fence;
+  GLsizei width;
+  GLsizei height;
+  ReadbackOptions options;
+};
+
+// Linked program binaries shared by every context in the process. Entries are keyed by
+// WebGLRenderingContext::programBinaryKey, which covers everything that decides the outcome of a
+// link, so a context linking a program another context already linked can load its binary instead.
+// The least recently used binaries are dropped once the keys and binaries exceed maxBytes, a
+// budget of 0 disables sharing.
+struct SharedProgramBinary {
+  GLenum format;
+  std::vector<uint8_t> data;
+  uint64_t lastUse;
+};
+
+struct SharedProgramCache {
+  size_t maxBytes;
+  size_t bytes;
+  uint64_t clock;
+  double hits;
+  double misses;
+  std::unordered_map<std::string, SharedProgramBinary> entries;
+
+  SharedProgramCache() : maxBytes(0), bytes(0), clock(0), hits(0), misses(0) {}
+
+  const SharedProgramBinary *find(const std::string &key);
+  void insert(const std::string &key, GLenum format, std::vector<uint8_t> &&data);
+  void resize(size_t newMaxBytes);
+};
+
 struct WebGLRenderingContext : public node::ObjectWrap {
 
   // The underlying OpenGL context
-  static bool HAS_DISPLAY;
-  static EGLDisplay DISPLAY;
-
-  SharedLibrary eglLibrary;
+  // One initialized display per ANGLE backend, shared by all contexts using that backend
+  static std::map<std::string, EGLDisplay> DISPLAYS;
+  static EGLDisplay GetDisplay(const std::string &backend, std::string &errorMessage);
+
+  // Drawing buffers are framebuffers, so contexts never render to their EGL surface. Contexts
+  // are made current without one where the display has EGL_KHR_surfaceless_context, otherwise
+  // they share a 1x1 pbuffer per display and config. Surfaces live until DisposeAll.
+  static std::map<std::pair<EGLDisplay, EGLConfig>, EGLSurface> SURFACES;
+  static bool GetSurface(EGLDisplay display, EGLConfig config, EGLSurface &surface,
+                         std::string &errorMessage);
+
+  // libEGL stays loaded for the lifetime of the process, the entry points resolved from it are
+  // shared by every context
+  static SharedLibrary EGL_LIBRARY;
+
+  EGLDisplay display;
   EGLContext context;
   EGLConfig config;
   EGLSurface surface;
   GLContextState state;
   std::string errorMessage;
+  bool isWebGL2;
 
   // Pixel storage flags
   bool unpack_flip_y;
@@ -65,6 +269,10 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   std::set<std::string> supportedWebGLExtensions;
   WebGLToANGLEExtensionsMap webGLToANGLEExtensions;
 
+  // Enables what a multisampled drawing buffer needs, which WebGL 1 contexts only get from ANGLE
+  // extensions. Returns false if the context cannot resolve one.
+  bool enableDrawingBufferMultisample();
+
   // A list of object references, need do destroy them at program exit
   std::map<std::pair<GLuint, GLObjectType>, bool> objects;
   void registerGLObj(GLObjectType type, GLuint obj) { objects[std::make_pair(obj, type)] = true; }
@@ -95,37 +303,131 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   }
 
   // Constructor
-  WebGLRenderingContext(int width, int height, bool alpha, bool depth, bool stencil, bool antialias,
+  WebGLRenderingContext(bool alpha, bool depth, bool stencil, bool antialias,
                         bool premultipliedAlpha, bool preserveDrawingBuffer,
                         bool preferLowPowerToHighPerformance, bool failIfMajorPerformanceCaveat,
-                        bool createWebGL2Context);
+                        bool createWebGL2Context, const std::string &backend);
   virtual ~WebGLRenderingContext();
 
   // Context validation
   static WebGLRenderingContext *ACTIVE;
   bool setActive();
 
-  // Unpacks a buffer full of pixels into memory
-  std::vector<uint8_t> unpackPixels(GLenum type, GLenum format, GLint width, GLint height,
-                                    unsigned char *pixels);
-
-  // Error handling
-  std::set<GLenum> errorSet;
+  // Applies the UNPACK_FLIP_Y / UNPACK_PREMULTIPLY_ALPHA conversions to a buffer full of pixels.
+  // Returns the converted pixels in scratch memory and their size, or NULL if the pixels should
+  // be uploaded as they are. Call scratch.release() once the upload is done.
+  ScratchArena scratch;
+  uint8_t *unpackPixels(GLenum type, GLenum format, GLint width, GLint height,
+                        unsigned char *pixels, size_t length, size_t &size);
+
+  // Asynchronous uploads, see UploadRing. acquireUploadSlot waits for the next slot in the ring
+  // to be free and returns NULL if it stays busy, issueNextUpload hands the oldest copied upload to GL and returns false if there
+  // is none (or, with wait set, none left at all). finishUploads issues all of them; draws, clears,
+  // reads and texture calls run it first, so they see every upload made before them.
+  UploadRing uploads;
+  UploadSlot *acquireUploadSlot(size_t &index);
+  bool issueNextUpload(bool wait);
+  void finishUploads();
+  void cancelUploads(GLuint texture);
+  void releaseUploads();
+
+  // Asynchronous readbacks by id, see PendingReadback
+  static const size_t MAX_SPARE_READBACK_BUFFERS = 4;
+  std::map<uint32_t, PendingReadback> readbacks;
+  std::vector<ReadbackBuffer> spareReadbackBuffers;
+  uint32_t nextReadback;
+  ReadbackBuffer acquireReadbackBuffer(size_t size);
+  void recycleReadbackBuffer(const ReadbackBuffer &buffer);
+  void releaseReadbacks();
+
+  // Error handling. Each WebGL error flag is one bit, lowest code first, so
+  // recording and clearing an error never allocates.
+  uint32_t errorBits;
   void setError(GLenum error);
   GLenum getError();
+
+  // Brackets a native call whose outcome the JS layer needs. Pending driver
+  // errors are moved into errorBits first so the value returned afterwards
+  // belongs to the call alone; the error stays recorded for getError().
+  void beginCheckedCall();
+  GLenum endCheckedCall();
   static NAN_METHOD(SetError);
   static NAN_METHOD(GetError);
 
   // Preferred depth format
   GLenum preferredDepth;
 
+  // Redundant state elimination. Each context has its own GL state, so the cache stays valid
+  // across setActive() and only has to be dropped when the state is reset or destroyed.
+  GLStateCache stateCache;
+  void cachedActiveTexture(GLenum texture);
+  void cachedBindBuffer(GLenum target, GLuint buffer);
+  GLenum cachedBindTexture(GLenum target, GLuint texture);
+  void cachedUseProgram(GLuint program);
+  void cachedSetCapability(GLenum cap, bool enabled);
+  void cachedBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+  void cachedDepthFunc(GLenum func);
+  void cachedViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  void cachedScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+  static NAN_METHOD(GetStateCacheStats);
+  static NAN_METHOD(GetScratchStats);
+  static NAN_METHOD(SetScratchLimit);
+  static NAN_METHOD(DrawingBufferSamples);
+  static NAN_METHOD(DrawingBufferStorageMultisample);
+  static NAN_METHOD(ResolveDrawingBuffer);
+  static NAN_METHOD(ClearDrawingBuffer);
+
+  // Cross-context program sharing. While it is enabled the sources shaders were compiled from are
+  // tracked, since GL cannot report them. Attribute bindings and transform feedback varyings are
+  // always tracked, because they may be set on a program before sharing is enabled.
+  // Programs linked the regular way wait in unsharedPrograms until their link has resolved.
+  static SharedProgramCache SHARED_PROGRAMS;
+  std::map<GLuint, std::string> shaderSources;
+  std::map<GLuint, std::string> compiledSources;
+  std::map<GLuint, std::map<std::string, GLint>> attribBindings;
+  std::map<GLuint, std::pair<GLenum, std::vector<std::string>>> feedbackVaryings;
+  std::map<GLuint, std::string> unsharedPrograms;
+  void bindAttribLocation(GLuint program, GLint index, const char *name);
+  bool supportsProgramBinaries();
+  std::string programBinaryKey(GLuint program);
+  GLenum linkProgram(GLuint program);
+  void shareProgramBinary(GLuint program);
+  void forgetProgramSharing(GLuint program);
+  static NAN_METHOD(SetSharedProgramCacheSize);
+  static NAN_METHOD(GetSharedProgramStats);
+
+  // Pooling support: releases every tracked object and restores the default GL state, keeping
+  // the EGL context alive for reuse. GL cannot disable an extension again, so contexts whose user
+  // had GetExtension request one are not reset for another user.
+  bool requestedExtensions;
+  void deleteObjects();
+  bool resetState();
+
   // Destructors
   void dispose();
 
   static NAN_METHOD(DisposeAll);
 
+  // Process wide persistent program cache, see ProgramCache.h
+  static NAN_METHOD(SetProgramCache);
+  static NAN_METHOD(FlushProgramCache);
+  static NAN_METHOD(GetProgramCacheStats);
+
+  // Batched command submission. A batching context shares its command buffer with JS: word 0
+  // holds the number of recorded words that follow it. GL_BOILERPLATE runs pending commands
+  // before any method, so JS only has to intercept the methods it records.
+  Nan::Persistent<v8::Int32Array> commandBuffer;
+  int32_t *commandWords;
+  size_t commandCapacity;
+  static v8::Local<v8::Object> CommandBufferOps();
+  void executeCommands(const int32_t *words, size_t length);
+  void flushCommands();
+  static NAN_METHOD(SetCommandBuffer);
+  static NAN_METHOD(ExecuteCommandBuffer);
+
   static NAN_METHOD(New);
   static NAN_METHOD(Destroy);
+  static NAN_METHOD(ResetContext);
 
   static NAN_METHOD(VertexAttribDivisorANGLE);
   static NAN_METHOD(DrawArraysInstancedANGLE);
@@ -139,6 +441,14 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(Uniform2i);
   static NAN_METHOD(Uniform3i);
   static NAN_METHOD(Uniform4i);
+  static NAN_METHOD(Uniform1fv);
+  static NAN_METHOD(Uniform1iv);
+  static NAN_METHOD(Uniform2fv);
+  static NAN_METHOD(Uniform2iv);
+  static NAN_METHOD(Uniform3fv);
+  static NAN_METHOD(Uniform3iv);
+  static NAN_METHOD(Uniform4fv);
+  static NAN_METHOD(Uniform4iv);
 
   static NAN_METHOD(PixelStorei);
   static NAN_METHOD(BindAttribLocation);
@@ -154,6 +464,7 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(ShaderSource);
   static NAN_METHOD(CompileShader);
   static NAN_METHOD(GetShaderParameter);
+  static NAN_METHOD(MaxShaderCompilerThreads);
   static NAN_METHOD(GetShaderInfoLog);
   static NAN_METHOD(CreateProgram);
   static NAN_METHOD(AttachShader);
@@ -245,10 +556,16 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(ValidateProgram);
 
   static NAN_METHOD(TexSubImage2D);
+  static NAN_METHOD(TexSubImage2DAsync);
+  static NAN_METHOD(ReadPixelsAsync);
+  static NAN_METHOD(ReadPixelsAsyncPoll);
+  static NAN_METHOD(ReadPixelsAsyncFinish);
+  static NAN_METHOD(EncodeFrame);
   static NAN_METHOD(ReadPixels);
   static NAN_METHOD(GetTexParameter);
   static NAN_METHOD(GetActiveAttrib);
   static NAN_METHOD(GetActiveUniform);
+  static NAN_METHOD(GetProgramReflection);
   static NAN_METHOD(GetAttachedShaders);
   static NAN_METHOD(GetParameter);
   static NAN_METHOD(GetBufferParameter);
@@ -363,6 +680,4 @@ struct WebGLRenderingContext : public node::ObjectWrap {
   static NAN_METHOD(BindVertexArray);
 };
 
-void BindWebGL2(const Nan::FunctionCallbackInfo<v8::Value> &info);
-
 #endif
@@ -0,0 +1,142 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+
+const WIDTH = 16
+const HEIGHT = 16
+
+const VERT_SRC = [
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'void main() {',
+  '  gl_FragColor = vec4(1, 1, 1, 1);',
+  '}'
+].join('\n')
+
+// Clears to black and draws a white triangle whose hypotenuse crosses the
+// drawing buffer diagonally, so some pixels are only partially covered.
+function drawDiagonal (gl) {
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  gl.bindAttribLocation(program, 0, 'position')
+  gl.linkProgram(program)
+  gl.useProgram(program)
+
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-1, -1, 1, -1, -1, 0.9]), gl.STATIC_DRAW)
+  gl.enableVertexAttribArray(0)
+  gl.vertexAttribPointer(0, 2, gl.FLOAT, false, 0, 0)
+
+  gl.clearColor(0, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.drawArrays(gl.TRIANGLES, 0, 3)
+}
+
+function readRed (gl) {
+  const pixels = new Uint8Array(WIDTH * HEIGHT * 4)
+  gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  return pixels.filter((value, i) => i % 4 === 0)
+}
+
+function countPartial (values) {
+  return values.filter(value => value > 0 && value < 255).length
+}
+
+function testContexts (name, options) {
+  tape(`antialias - ${name}`, function (t) {
+    const aliased = createContext(WIDTH, HEIGHT, options)
+    t.equals(aliased.getContextAttributes().antialias, false, 'antialias defaults to false')
+    drawDiagonal(aliased)
+    t.equals(countPartial(readRed(aliased)), 0, 'edges are not smoothed')
+    aliased.getExtension('STACKGL_destroy_context').destroy()
+
+    const gl = createContext(WIDTH, HEIGHT, Object.assign({ antialias: true }, options))
+    if (!gl.getContextAttributes().antialias) {
+      t.pass('drawing buffer cannot be multisampled, skipping')
+      gl.getExtension('STACKGL_destroy_context').destroy()
+      t.end()
+      return
+    }
+
+    drawDiagonal(gl)
+    const values = readRed(gl)
+    t.ok(countPartial(values) > 0, 'edges are smoothed')
+    t.equals(values[0], 255, 'covered corner is white')
+    t.equals(values[WIDTH * HEIGHT - 1], 0, 'uncovered corner is black')
+    t.same(readRed(gl), values, 'reading twice gives the same pixels')
+
+    // Drawing after a read still goes to the multisampled buffer
+    gl.clear(gl.COLOR_BUFFER_BIT)
+    t.same(Array.from(readRed(gl)), new Array(WIDTH * HEIGHT).fill(0), 'draws after a read are resolved')
+    if (options.createWebGL2Context) {
+      gl.clearBufferfv(gl.COLOR, 0, [1, 1, 1, 1])
+      t.same(Array.from(readRed(gl)), new Array(WIDTH * HEIGHT).fill(255), 'clearBuffer after a read is resolved')
+    }
+    drawDiagonal(gl)
+
+    const texture = gl.createTexture()
+    gl.bindTexture(gl.TEXTURE_2D, texture)
+    gl.copyTexImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 0, 0, WIDTH, HEIGHT, 0)
+    t.equals(gl.getError(), gl.NO_ERROR, 'copyTexImage2D from the drawing buffer')
+
+    const framebuffer = gl.createFramebuffer()
+    gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+    gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+    t.same(readRed(gl), values, 'copied pixels are resolved')
+    gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+
+    gl.getExtension('STACKGL_resize_drawingbuffer').resize(WIDTH * 2, HEIGHT * 2)
+    t.equals(gl.checkFramebufferStatus(gl.FRAMEBUFFER), gl.FRAMEBUFFER_COMPLETE, 'complete after resize')
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+}
+
+testContexts('webgl1', {})
+testContexts('webgl2', { createWebGL2Context: true })
+
+tape('antialias - samples option', function (t) {
+  t.throws(function () {
+    createContext(1, 1, { antialias: true, samples: 0 })
+  }, TypeError, 'zero samples throws')
+  t.throws(function () {
+    createContext(1, 1, { antialias: true, samples: '4' })
+  }, TypeError, 'non-number samples throws')
+  t.end()
+})
+
+tape('antialias - webgl1 keeps its framebuffer targets and formats', function (t) {
+  const gl = createContext(WIDTH, HEIGHT, { antialias: true })
+  const READ_FRAMEBUFFER = 0x8CA8
+  const DRAW_FRAMEBUFFER = 0x8CA9
+  const RGBA8 = 0x8058
+
+  const framebuffer = gl.createFramebuffer()
+  for (const target of [READ_FRAMEBUFFER, DRAW_FRAMEBUFFER]) {
+    gl.bindFramebuffer(target, framebuffer)
+    t.equals(gl.getError(), gl.INVALID_ENUM, 'bindFramebuffer rejects ' + target.toString(16))
+    t.equals(gl.checkFramebufferStatus(target), 0, 'checkFramebufferStatus rejects ' + target.toString(16))
+    t.equals(gl.getError(), gl.INVALID_ENUM, 'INVALID_ENUM')
+  }
+  t.equals(gl.getParameter(gl.FRAMEBUFFER_BINDING), null, 'default framebuffer still bound')
+
+  const renderbuffer = gl.createRenderbuffer()
+  gl.bindRenderbuffer(gl.RENDERBUFFER, renderbuffer)
+  gl.renderbufferStorage(gl.RENDERBUFFER, RGBA8, WIDTH, HEIGHT)
+  t.equals(gl.getError(), gl.INVALID_ENUM, 'renderbufferStorage rejects RGBA8')
+  gl.renderbufferStorage(gl.RENDERBUFFER, gl.RGBA4, WIDTH, HEIGHT)
+  t.equals(gl.getError(), gl.NO_ERROR, 'RGBA4 is accepted')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
@@ -0,0 +1,50 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+tape('backend - default', function (t) {
+  const gl = createContext(4, 4)
+  t.equals(gl.getContextAttributes().backend, createContext.getDefaultBackend(), 'uses process default')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('backend - explicit default', function (t) {
+  const gl = createContext(4, 4, { backend: 'default' })
+  t.ok(gl, 'context created')
+  t.equals(gl.getContextAttributes().backend, 'default', 'backend attribute')
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [255, 0, 0, 255], 'renders')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('backend - dispatch only', function (t) {
+  const gl = createContext(4, 4, { dispatchOnly: true, backend: 'gl' })
+  t.ok(gl, 'context created')
+  t.equals(gl.getContextAttributes().backend, 'null', 'runs on the null backend')
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  t.equals(gl.getError(), gl.NO_ERROR, 'calls dispatch without errors')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('backend - validation', function (t) {
+  t.throws(function () {
+    createContext(4, 4, { backend: 'software-rasterizer' })
+  }, TypeError, 'unknown backend throws')
+  t.throws(function () {
+    createContext.setDefaultBackend('bogus')
+  }, TypeError, 'unknown default throws')
+
+  const previous = createContext.getDefaultBackend()
+  createContext.setDefaultBackend('swiftshader')
+  t.equals(createContext.getDefaultBackend(), 'swiftshader', 'default updated')
+  createContext.setDefaultBackend(previous)
+  t.end()
+})
@@ -0,0 +1,144 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const { WebGLRenderingContext, WebGL2RenderingContext } = require('../src/javascript/webgl-rendering-context')
+const drawTriangle = require('./util/draw-triangle')
+const makeShader = require('./util/make-program')
+
+const VERT_SRC = [
+  'precision mediump float;',
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'uniform vec4 color;',
+  'void main() {',
+  '  gl_FragColor = color;',
+  '}'
+].join('\n')
+
+function render (options) {
+  const gl = createContext(16, 16, options)
+  const program = makeShader(gl, VERT_SRC, FRAG_SRC)
+  gl.bindAttribLocation(program, 0, 'position')
+  gl.linkProgram(program)
+  gl.useProgram(program)
+
+  gl.clearColor(0, 0, 1, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.enable(gl.SCISSOR_TEST)
+  gl.scissor(0, 0, 8, 16)
+  gl.uniform4f(gl.getUniformLocation(program, 'color'), 1, 1, 0, 1)
+  drawTriangle(gl)
+  gl.disable(gl.SCISSOR_TEST)
+
+  const pixels = new Uint8Array(16 * 16 * 4)
+  gl.readPixels(0, 0, 16, 16, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  const error = gl.getError()
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  return { pixels, error }
+}
+
+tape('command buffer - matches direct submission', function (t) {
+  const direct = render()
+  const batched = render({ commandBuffer: true })
+  t.equals(batched.error, direct.error, 'same error state')
+  t.same(Array.from(batched.pixels), Array.from(direct.pixels), 'same pixels')
+  t.same(Array.from(batched.pixels.subarray(0, 4)), [255, 255, 0, 255], 'draw executed')
+  t.same(Array.from(batched.pixels.subarray(15 * 4, 16 * 4)), [0, 0, 255, 255], 'scissor executed')
+  t.end()
+})
+
+tape('command buffer - small buffer flushes when full', function (t) {
+  const gl = createContext(4, 4, { commandBuffer: 64 })
+  for (let i = 0; i < 100; ++i) {
+    gl.clearColor(i / 100, 0, 0, 1)
+    gl.viewport(0, 0, 4, 4)
+  }
+  gl.clearColor(0, 1, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), [0, 255, 0, 255], 'last clear color wins')
+  t.end()
+})
+
+tape('command buffer - errors from batched calls', function (t) {
+  const gl = createContext(4, 4, { commandBuffer: true })
+  gl.getError()
+  gl.drawArrays(gl.TRIANGLES, 0, 3)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'getError flushes and reports errors')
+  t.equals(gl.getParameter(gl.VIEWPORT)[2], 4, 'getParameter sees state')
+  t.end()
+})
+
+const INSTANCED_VERT_SRC = [
+  'precision mediump float;',
+  'attribute vec2 position;',
+  'attribute float offset;',
+  'void main() {',
+  '  gl_Position = vec4(position.x + offset, position.y, 0, 1);',
+  '}'
+].join('\n')
+
+// Two instances of a quad covering the left half, the second one moved to the
+// right half by a per-instance offset.
+function renderInstanced (options) {
+  const gl = createContext(16, 16, Object.assign({ createWebGL2Context: true }, options))
+  const program = makeShader(gl, INSTANCED_VERT_SRC, FRAG_SRC)
+  gl.bindAttribLocation(program, 0, 'position')
+  gl.bindAttribLocation(program, 1, 'offset')
+  gl.linkProgram(program)
+  gl.useProgram(program)
+  gl.uniform4f(gl.getUniformLocation(program, 'color'), 0, 1, 0, 1)
+
+  const positions = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, positions)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-1, -1, 0, -1, -1, 1, 0, 1]), gl.STATIC_DRAW)
+  gl.enableVertexAttribArray(0)
+  gl.vertexAttribPointer(0, 2, gl.FLOAT, false, 0, 0)
+
+  const offsets = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, offsets)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([0, 1]), gl.STATIC_DRAW)
+  gl.enableVertexAttribArray(1)
+  gl.vertexAttribPointer(1, 1, gl.FLOAT, false, 0, 0)
+  gl.vertexAttribDivisor(1, 1)
+
+  gl.clearColor(0, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.drawArraysInstanced(gl.TRIANGLE_STRIP, 0, 4, 2)
+
+  const pixels = new Uint8Array(16 * 16 * 4)
+  gl.readPixels(0, 0, 16, 16, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  const error = gl.getError()
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  return { pixels, error }
+}
+
+tape('command buffer - vertexAttribDivisor is executed', function (t) {
+  const direct = renderInstanced()
+  const batched = renderInstanced({ commandBuffer: true })
+  t.equals(batched.error, direct.error, 'same error state')
+  t.equals(batched.error, 0, 'no errors')
+  t.same(Array.from(batched.pixels), Array.from(direct.pixels), 'same pixels')
+  t.same(Array.from(batched.pixels.subarray(0, 4)), [0, 255, 0, 255], 'first instance drawn')
+  t.same(Array.from(batched.pixels.subarray(15 * 4, 16 * 4)), [0, 255, 0, 255], 'second instance drawn')
+  t.end()
+})
+
+tape('command buffer - contexts keep their classes', function (t) {
+  const gl = createContext(1, 1, { commandBuffer: true })
+  t.ok(gl instanceof WebGLRenderingContext, 'WebGL 1 context')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+
+  const gl2 = createContext(1, 1, { commandBuffer: true, createWebGL2Context: true })
+  t.ok(gl2 instanceof WebGL2RenderingContext, 'WebGL 2 context')
+  gl2.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
@@ -0,0 +1,89 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+tape('context pool - reuse', function (t) {
+  const pool = createContext.createContextPool()
+  t.equals(pool.prewarm(2, { stencil: true }), 2, 'prewarm creates contexts')
+
+  const gl = pool.acquire(16, 16, { stencil: true })
+  t.ok(gl, 'acquire returns a context')
+  t.equals(gl.drawingBufferWidth, 16, 'drawing buffer width')
+  t.equals(gl.drawingBufferHeight, 16, 'drawing buffer height')
+  t.equals(pool.stats().reused, 1, 'acquire reuses a prewarmed context')
+
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.enable(gl.BLEND)
+  gl.blendFunc(gl.SRC_ALPHA, gl.ONE_MINUS_SRC_ALPHA)
+  gl.clearColor(1, 0, 0, 1)
+  gl.pixelStorei(gl.UNPACK_ALIGNMENT, 1)
+  gl.viewport(0, 0, 4, 4)
+  t.ok(pool.release(gl), 'release')
+  t.notOk(pool.release(gl), 'double release is ignored')
+
+  const again = pool.acquire(8, 4, { stencil: true })
+  t.equals(again, gl, 'released context is handed out again')
+  t.equals(again.drawingBufferWidth, 8, 'drawing buffer resized')
+  t.equals(again.getError(), again.NO_ERROR, 'no errors carried over')
+  t.equals(again.isEnabled(again.BLEND), false, 'BLEND reset')
+  t.equals(again.getParameter(again.BLEND_SRC_RGB), again.ONE, 'BLEND_SRC_RGB reset')
+  t.same(Array.from(again.getParameter(again.COLOR_CLEAR_VALUE)), [0, 0, 0, 0], 'COLOR_CLEAR_VALUE reset')
+  t.equals(again.getParameter(again.UNPACK_ALIGNMENT), 4, 'UNPACK_ALIGNMENT reset')
+  t.same(Array.from(again.getParameter(again.VIEWPORT)), [0, 0, 8, 4], 'VIEWPORT matches new size')
+  t.equals(again.getParameter(again.TEXTURE_BINDING_2D), null, 'texture unbound')
+  t.equals(again.isTexture(texture), false, 'stale texture rejected')
+
+  again.clearColor(0, 1, 0, 1)
+  again.clear(again.COLOR_BUFFER_BIT)
+  const pixels = new Uint8Array(8 * 4 * 4)
+  again.readPixels(0, 0, 8, 4, again.RGBA, again.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels.subarray(0, 4)), [0, 255, 0, 255], 'renders after reuse')
+
+  pool.release(again)
+  pool.destroy()
+  t.end()
+})
+
+tape('context pool - attribute sets', function (t) {
+  const pool = createContext.createContextPool({ maxIdle: 1 })
+
+  const a = pool.acquire(4, 4, { alpha: true })
+  const b = pool.acquire(4, 4, { alpha: false })
+  t.ok(a && b, 'acquire both')
+  t.notEquals(a, b, 'different attributes get different contexts')
+  t.equals(a.getContextAttributes().alpha, true, 'alpha context')
+  t.equals(b.getContextAttributes().alpha, false, 'opaque context')
+
+  const c = pool.acquire(4, 4, { alpha: true })
+  pool.release(a)
+  pool.release(c)
+  const stats = pool.stats()
+  t.equals(stats.idle, 1, 'maxIdle limits idle contexts')
+  t.equals(stats.destroyed, 1, 'surplus context destroyed')
+  t.equals(stats.active, 1, 'one context still active')
+
+  t.equals(pool.acquire(0, 4), null, 'invalid size')
+
+  pool.destroy()
+  t.end()
+})
+
+tape('context pool - contexts with enabled extensions are not reused', function (t) {
+  const pool = createContext.createContextPool()
+
+  const gl = pool.acquire(4, 4)
+  t.ok(gl.getExtension('OES_texture_float'), 'extension enabled')
+  pool.release(gl)
+  t.equals(pool.stats().destroyed, 1, 'context destroyed on release')
+  t.equals(pool.stats().idle, 0, 'nothing kept idle')
+
+  const fresh = pool.acquire(4, 4)
+  t.notEquals(fresh, gl, 'next caller gets a new context')
+  pool.release(fresh)
+  t.equals(pool.stats().idle, 1, 'untouched context kept idle')
+
+  pool.destroy()
+  t.end()
+})
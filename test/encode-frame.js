@@ -0,0 +1,124 @@
+'use strict'
+
+const tape = require('tape')
+const zlib = require('zlib')
+const createContext = require('../index')
+
+// Just enough of a PNG decoder to check the pixels encodeFrame produced
+function decodePNG (png) {
+  let offset = 8
+  let header = null
+  const data = []
+  while (offset < png.length) {
+    const length = png.readUInt32BE(offset)
+    const type = png.toString('latin1', offset + 4, offset + 8)
+    const body = png.subarray(offset + 8, offset + 8 + length)
+    if (type === 'IHDR') {
+      header = { width: body.readUInt32BE(0), height: body.readUInt32BE(4), colorType: body[9] }
+    } else if (type === 'IDAT') {
+      data.push(body)
+    }
+    offset += length + 12
+  }
+
+  const pixelSize = header.colorType === 6 ? 4 : 3
+  const rowBytes = header.width * pixelSize
+  const raw = zlib.inflateSync(Buffer.concat(data))
+  const pixels = Buffer.alloc(rowBytes * header.height)
+  for (let y = 0; y < header.height; ++y) {
+    const filter = raw[y * (rowBytes + 1)]
+    for (let i = 0; i < rowBytes; ++i) {
+      const left = i >= pixelSize ? pixels[y * rowBytes + i - pixelSize] : 0
+      const up = y > 0 ? pixels[(y - 1) * rowBytes + i] : 0
+      const upLeft = y > 0 && i >= pixelSize ? pixels[(y - 1) * rowBytes + i - pixelSize] : 0
+      let predicted = 0
+      if (filter === 1) {
+        predicted = left
+      } else if (filter === 2) {
+        predicted = up
+      } else if (filter === 3) {
+        predicted = (left + up) >> 1
+      } else if (filter === 4) {
+        const estimate = left + up - upLeft
+        const toLeft = Math.abs(estimate - left)
+        const toUp = Math.abs(estimate - up)
+        const toUpLeft = Math.abs(estimate - upLeft)
+        predicted = toLeft <= toUp && toLeft <= toUpLeft ? left : toUp <= toUpLeft ? up : upLeft
+      }
+      pixels[y * rowBytes + i] = (raw[y * (rowBytes + 1) + 1 + i] + predicted) & 0xff
+    }
+  }
+  return { width: header.width, height: header.height, pixelSize, pixels }
+}
+
+// Red bottom half, semi-transparent green top half
+function draw (gl) {
+  gl.clearColor(0, 128 / 255, 0, 128 / 255)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.enable(gl.SCISSOR_TEST)
+  gl.scissor(0, 0, gl.drawingBufferWidth, gl.drawingBufferHeight >> 1)
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.disable(gl.SCISSOR_TEST)
+}
+
+function pixelAt (image, x, y) {
+  const offset = (y * image.width + x) * image.pixelSize
+  return Array.from(image.pixels.subarray(offset, offset + image.pixelSize))
+}
+
+tape('encodeFrame - encodes the drawing buffer top-down and unpremultiplied', function (t) {
+  const gl = createContext(16, 8)
+  draw(gl)
+  gl.encodeFrame().then(function (png) {
+    t.ok(Buffer.isBuffer(png), 'Buffer')
+    const image = decodePNG(png)
+    t.equals(image.width, 16, 'width')
+    t.equals(image.height, 8, 'height')
+    t.same(pixelAt(image, 0, 0), [0, 255, 0, 128], 'top row is unpremultiplied green')
+    t.same(pixelAt(image, 15, 7), [255, 0, 0, 255], 'bottom row is red')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('encodeFrame - rect and opaque drawing buffers', function (t) {
+  const gl = createContext(16, 8, { alpha: false })
+  draw(gl)
+  gl.encodeFrame({ rect: { x: 2, y: 0, width: 4, height: 2 }, compressionLevel: 0 }).then(function (png) {
+    const image = decodePNG(png)
+    t.equals(image.pixelSize, 3, 'RGB')
+    t.equals(image.width, 4, 'width')
+    t.equals(image.height, 2, 'height')
+    t.same(pixelAt(image, 0, 0), [255, 0, 0], 'red')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('encodeFrame - rect past a reused drawing buffer', function (t) {
+  const gl = createContext(4, 4, { reuseDrawingBuffer: true })
+  gl.resize(2, 2)
+  gl.clearColor(1, 0, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.encodeFrame({ rect: { x: 0, y: 0, width: 4, height: 4 } }).then(function (png) {
+    const image = decodePNG(png)
+    t.same(pixelAt(image, 0, 3), [255, 0, 0, 255], 'inside is red')
+    t.same(pixelAt(image, 3, 3), [0, 0, 0, 0], 'right of the drawing buffer is zero')
+    t.same(pixelAt(image, 0, 0), [0, 0, 0, 0], 'above the drawing buffer is zero')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('encodeFrame - rejects unsupported requests', function (t) {
+  const gl = createContext(4, 4)
+  Promise.all([
+    gl.encodeFrame({ format: 'jpeg' }).then(() => t.fail('jpeg'), () => t.pass('jpeg rejected')),
+    gl.encodeFrame({ compressionLevel: 12 }).then(() => t.fail('level'), () => t.pass('level rejected')),
+    gl.encodeFrame({ rect: { x: 0, y: 0, width: 0, height: 4 } }).then(() => t.fail('empty'), () => t.pass('empty rect rejected'))
+  ]).then(function () {
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
@@ -0,0 +1,71 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeShader = require('./util/make-shader')
+
+const VERT_SRC = [
+  'attribute vec4 a;',
+  'attribute vec4 b;',
+  'attribute vec4 c;',
+  'void main() {',
+  '  gl_Position = a + b + c;',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'void main() {',
+  '  gl_FragColor = vec4(1);',
+  '}'
+].join('\n')
+
+function createProgram (gl) {
+  const program = gl.createProgram()
+  gl.attachShader(program, makeShader(gl, gl.VERTEX_SHADER, VERT_SRC))
+  gl.attachShader(program, makeShader(gl, gl.FRAGMENT_SHADER, FRAG_SRC))
+  return program
+}
+
+function locations (gl, program) {
+  return ['a', 'b', 'c'].map(function (name) {
+    return gl.getAttribLocation(program, name)
+  })
+}
+
+tape('linkProgram - attribute locations survive relinking', function (t) {
+  const gl = createContext(1, 1)
+  const program = createProgram(gl)
+
+  gl.linkProgram(program)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'links')
+  const first = locations(gl, program)
+  first.forEach(function (location) {
+    t.ok(location >= 0, 'attribute is active')
+  })
+
+  gl.linkProgram(program)
+  t.same(locations(gl, program), first, 'relink keeps the locations')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('linkProgram - explicit bindings are honored', function (t) {
+  const gl = createContext(1, 1)
+  const program = createProgram(gl)
+
+  gl.bindAttribLocation(program, 5, 'a')
+  gl.bindAttribLocation(program, 3, 'c')
+  gl.linkProgram(program)
+  t.equals(gl.getAttribLocation(program, 'a'), 5, 'a bound before the first link')
+  t.equals(gl.getAttribLocation(program, 'c'), 3, 'c bound before the first link')
+
+  gl.bindAttribLocation(program, 7, 'b')
+  gl.linkProgram(program)
+  t.equals(gl.getAttribLocation(program, 'b'), 7, 'b rebound before relinking')
+  t.equals(gl.getAttribLocation(program, 'a'), 5, 'a keeps its binding')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
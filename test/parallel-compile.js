@@ -0,0 +1,85 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+const VERT_SRC = [
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'void main() {',
+  '  gl_FragColor = vec4(1, 0, 0, 1);',
+  '}'
+].join('\n')
+
+function shader (gl, type, src) {
+  const s = gl.createShader(type)
+  gl.shaderSource(s, src)
+  return s
+}
+
+tape('parallel compile - extension', function (t) {
+  const gl = createContext(1, 1)
+  const ext = gl.getExtension('KHR_parallel_shader_compile')
+  t.ok(ext, 'extension available')
+  t.equals(ext.COMPLETION_STATUS_KHR, 0x91B1, 'enum')
+  ext.maxShaderCompilerThreadsKHR(2)
+  t.equals(gl.getError(), gl.NO_ERROR, 'thread count accepted')
+
+  const vs = shader(gl, gl.VERTEX_SHADER, VERT_SRC)
+  gl.compileShader(vs)
+  const status = gl.getShaderParameter(vs, ext.COMPLETION_STATUS_KHR)
+  t.equals(typeof status, 'boolean', 'completion status is a boolean')
+  t.ok(gl.getShaderParameter(vs, gl.COMPILE_STATUS), 'compiles')
+  t.ok(gl.getShaderParameter(vs, ext.COMPLETION_STATUS_KHR), 'complete once the status was read')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+function testAsyncHelpers (name, enable) {
+  tape('parallel compile - async helpers ' + name, function (t) {
+    const gl = createContext(1, 1)
+    if (enable) {
+      gl.getExtension('KHR_parallel_shader_compile')
+    }
+    const vs = shader(gl, gl.VERTEX_SHADER, VERT_SRC)
+    const fs = shader(gl, gl.FRAGMENT_SHADER, FRAG_SRC)
+    const bad = shader(gl, gl.FRAGMENT_SHADER, 'void main() { nope; }')
+
+    Promise.all([
+      gl.compileShaderAsync(vs),
+      gl.compileShaderAsync(fs),
+      gl.compileShaderAsync(bad)
+    ]).then(function (results) {
+      t.same(results, [true, true, false], 'compile statuses')
+      t.ok(gl.getShaderInfoLog(bad).length > 0, 'info log of the failed shader')
+
+      const program = gl.createProgram()
+      gl.attachShader(program, vs)
+      gl.attachShader(program, fs)
+      return gl.linkProgramAsync(program).then(function (linked) {
+        t.ok(linked, 'link status')
+        t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'matches getProgramParameter')
+        t.ok(gl.getUniformLocation(program, 'missing') === null, 'program is usable')
+      })
+    }).then(function () {
+      if (!enable) {
+        t.equals(gl.getShaderParameter(vs, 0x91B1), null, 'extension was not enabled')
+        t.equals(gl.getError(), gl.INVALID_ENUM, 'COMPLETION_STATUS_KHR needs the extension')
+      }
+      gl.getExtension('STACKGL_destroy_context').destroy()
+      t.end()
+    }, function (err) {
+      t.fail(err)
+      t.end()
+    })
+  })
+}
+
+testAsyncHelpers('with the extension', true)
+testAsyncHelpers('without the extension', false)
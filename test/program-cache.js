@@ -0,0 +1,55 @@
+'use strict'
+
+const fs = require('fs')
+const os = require('os')
+const path = require('path')
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+
+const VERT_SRC = [
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'uniform vec4 color;',
+  'void main() {',
+  '  gl_FragColor = color * 0.5;',
+  '}'
+].join('\n')
+
+tape('program cache - validation', function (t) {
+  t.throws(function () {
+    createContext.setProgramCache({})
+  }, TypeError, 'directory is required')
+  t.throws(function () {
+    createContext.setProgramCache({ directory: os.tmpdir(), maxBytes: -1 })
+  }, TypeError, 'maxBytes must be positive')
+  t.end()
+})
+
+tape('program cache - stores linked programs', function (t) {
+  const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'headless-gl-program-cache-'))
+  createContext.setProgramCache({ directory, maxBytes: 16 * 1024 * 1024 })
+  t.throws(function () {
+    createContext.setProgramCache({ directory })
+  }, 'can only be configured once')
+
+  const gl = createContext(4, 4)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'program links')
+
+  createContext.flushProgramCache()
+  const stats = createContext.getProgramCacheStats()
+  t.ok(stats.enabled, 'cache enabled')
+  t.ok(stats.misses + stats.hits > 0, 'ANGLE consulted the cache')
+  t.equals(stats.entries > 0, stats.bytes > 0, 'entries and bytes agree')
+  t.ok(stats.bytes <= 16 * 1024 * 1024, 'stays within the budget')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
@@ -0,0 +1,143 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+const { gl: native } = require('../src/javascript/native-gl')
+
+const UNIFORMS = 64
+
+function vertexSource () {
+  const lines = ['attribute vec4 position;', 'attribute vec2 uv;', 'varying vec2 vUv;']
+  let sum = 'position'
+  for (let i = 0; i < UNIFORMS; ++i) {
+    lines.push('uniform vec4 u' + i + ';')
+    sum += ' + u' + i
+  }
+  lines.push('uniform float weights[3];')
+  lines.push('void main() {')
+  lines.push('  vUv = uv;')
+  lines.push('  gl_Position = (' + sum + ') * (weights[0] + weights[1] + weights[2]);')
+  lines.push('}')
+  return lines.join('\n')
+}
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'varying vec2 vUv;',
+  'void main() {',
+  '  gl_FragColor = vec4(vUv, 0, 1);',
+  '}'
+].join('\n')
+
+tape('program reflection - attributes and uniforms after link', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, vertexSource(), FRAG_SRC)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'links')
+
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_ATTRIBUTES), 2, 'two attributes')
+  t.equals(gl.getProgramParameter(program, gl.ACTIVE_UNIFORMS), UNIFORMS + 1, 'every uniform')
+
+  const names = []
+  for (let i = 0; i < UNIFORMS + 1; ++i) {
+    names.push(gl.getActiveUniform(program, i).name)
+  }
+  t.ok(names.indexOf('u0') >= 0 && names.indexOf('u' + (UNIFORMS - 1)) >= 0, 'uniform names')
+  t.ok(names.indexOf('weights[0]') >= 0, 'array uniform name')
+
+  t.ok(gl.getUniformLocation(program, 'u7'), 'uniform location')
+  const weights = gl.getUniformLocation(program, 'weights[0]')
+  t.ok(weights, 'array location')
+  gl.useProgram(program)
+  gl.uniform1fv(weights, [1, 2, 3])
+  t.equals(gl.getUniform(program, gl.getUniformLocation(program, 'weights[2]')), 3, 'array elements resolve')
+
+  t.ok(gl.getAttribLocation(program, 'uv') >= 0, 'attribute location')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('program reflection - failed link keeps the info log', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, 'void main() { gl_Position = vec4(undefinedThing); }', FRAG_SRC)
+  t.notOk(gl.getProgramParameter(program, gl.LINK_STATUS), 'does not link')
+  t.equals(typeof gl.getProgramInfoLog(program), 'string', 'info log')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+function activeInfo (info) {
+  return info && { type: info.type, size: info.size, name: info.name }
+}
+
+tape('program reflection - cached active info matches the driver', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, vertexSource(), FRAG_SRC)
+  const ctx = program._ctx
+
+  for (let i = 0; i < 2; ++i) {
+    t.same(activeInfo(gl.getActiveAttrib(program, i)),
+      activeInfo(native.getActiveAttrib.call(ctx, program._ | 0, i)), 'attribute ' + i)
+  }
+  for (let i = 0; i < UNIFORMS + 1; ++i) {
+    t.same(activeInfo(gl.getActiveUniform(program, i)),
+      activeInfo(native.getActiveUniform.call(ctx, program._ | 0, i)), 'uniform ' + i)
+  }
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  t.equals(gl.getActiveUniform(program, UNIFORMS + 1), null, 'out of range uniform')
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'INVALID_VALUE')
+  t.equals(gl.getActiveAttrib(program, -1), null, 'negative attribute')
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'INVALID_VALUE')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('program reflection - cached blocks and varyings match the driver', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const program = makeProgram(gl, [
+    '#version 300 es',
+    'layout(std140) uniform Camera { mat4 view; };',
+    'layout(std140) uniform Light { vec4 color; };',
+    'in vec4 position;',
+    'out vec4 tint;',
+    'out float depth;',
+    'void main() {',
+    '  tint = color;',
+    '  depth = position.z;',
+    '  gl_Position = view * position;',
+    '}'
+  ].join('\n'), [
+    '#version 300 es',
+    'precision mediump float;',
+    'in vec4 tint;',
+    'out vec4 fragColor;',
+    'void main() {',
+    '  fragColor = tint;',
+    '}'
+  ].join('\n'))
+  const ctx = program._ctx
+  native.transformFeedbackVaryings.call(ctx, program._ | 0, ['tint', 'depth'], gl.SEPARATE_ATTRIBS)
+  gl.linkProgram(program)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'links')
+
+  for (const name of ['Camera', 'Light', 'Missing']) {
+    t.equals(gl.getUniformBlockIndex(program, name),
+      native.getUniformBlockIndex.call(ctx, program._ | 0, name), 'block ' + name)
+  }
+  t.equals(gl.getUniformBlockIndex(program, 'Missing'), gl.INVALID_INDEX, 'missing block')
+  for (let i = 0; i < 2; ++i) {
+    t.same(activeInfo(gl.getTransformFeedbackVarying(program, i)),
+      activeInfo(native.getTransformFeedbackVarying.call(ctx, program._ | 0, i)), 'varying ' + i)
+  }
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  t.equals(gl.getTransformFeedbackVarying(program, 2), null, 'out of range varying')
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'INVALID_VALUE')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
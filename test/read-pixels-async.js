@@ -0,0 +1,86 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function clear (gl, r, g, b, a) {
+  gl.clearColor(r / 255, g / 255, b / 255, a / 255)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+}
+
+function allPixels (pixels, expected) {
+  for (let i = 0; i < pixels.length; i += 4) {
+    for (let j = 0; j < 4; ++j) {
+      if (pixels[i + j] !== expected[j]) {
+        return false
+      }
+    }
+  }
+  return true
+}
+
+tape('readPixelsAsync - allocates a result on WebGL 2', function (t) {
+  const gl = createContext(16, 8, { createWebGL2Context: true })
+  clear(gl, 255, 0, 0, 255)
+  gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE).then(function (pixels) {
+    t.ok(pixels instanceof Uint8Array, 'Uint8Array')
+    t.equals(pixels.length, 16 * 8 * 4, 'length')
+    t.ok(allPixels(pixels, [255, 0, 0, 255]), 'pixels')
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('readPixelsAsync - reads the framebuffer at the time of the call', function (t) {
+  const gl = createContext(16, 8, { createWebGL2Context: true })
+  const first = new Uint8Array(16 * 8 * 4)
+  clear(gl, 0, 255, 0, 255)
+  const read = gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE, first)
+  clear(gl, 0, 0, 255, 255)
+  const second = gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE)
+
+  Promise.all([read, second]).then(function (results) {
+    t.equals(results[0], first, 'resolves with the destination')
+    t.ok(allPixels(first, [0, 255, 0, 255]), 'first read')
+    t.ok(allPixels(results[1], [0, 0, 255, 255]), 'second read')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('readPixelsAsync - WebGL 1 reads synchronously', function (t) {
+  const gl = createContext(4, 4)
+  clear(gl, 10, 20, 30, 255)
+  gl.readPixelsAsync(0, 0, 4, 4, gl.RGBA, gl.UNSIGNED_BYTE).then(function (pixels) {
+    t.equals(pixels.length, 4 * 4 * 4, 'length')
+    t.ok(allPixels(pixels, [10, 20, 30, 255]), 'pixels')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('readPixelsAsync - rejects a destination that cannot hold the pixels', function (t) {
+  const gl = createContext(16, 8, { createWebGL2Context: true })
+  clear(gl, 255, 0, 0, 255)
+
+  const short = new Uint8Array(16 * 8 * 4 - 1)
+  const shortRead = gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE, short)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short destination raises INVALID_OPERATION')
+
+  const floats = new Float32Array(16 * 8 * 4)
+  const floatRead = gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE, floats)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'wrongly typed destination raises INVALID_OPERATION')
+
+  const rgb = new Uint8Array(16 * 8 * 3 - 1)
+  const rgbRead = gl.readPixelsAsync(0, 0, 16, 8, gl.RGBA, gl.UNSIGNED_BYTE, rgb, { outputFormat: 'rgb' })
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short repacked destination raises INVALID_OPERATION')
+
+  const results = [shortRead, floatRead, rgbRead].map(read => read.then(() => 'resolved', () => 'rejected'))
+  Promise.all(results).then(function (settled) {
+    t.same(settled, ['rejected', 'rejected', 'rejected'], 'all reads reject')
+    t.ok(short.every(value => value === 0), 'short destination is untouched')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
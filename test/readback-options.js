@@ -0,0 +1,83 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+const WIDTH = 5
+const HEIGHT = 2
+const BOTTOM = [200, 100, 50, 255]
+const TOP = [60, 30, 0, 128]
+
+// Bottom row BOTTOM, top row TOP
+function draw (gl) {
+  gl.clearColor(TOP[0] / 255, TOP[1] / 255, TOP[2] / 255, TOP[3] / 255)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.enable(gl.SCISSOR_TEST)
+  gl.scissor(0, 0, WIDTH, 1)
+  gl.clearColor(BOTTOM[0] / 255, BOTTOM[1] / 255, BOTTOM[2] / 255, BOTTOM[3] / 255)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.disable(gl.SCISSOR_TEST)
+}
+
+function rows (first, second) {
+  const result = []
+  for (let i = 0; i < WIDTH; ++i) result.push(...first)
+  for (let i = 0; i < WIDTH; ++i) result.push(...second)
+  return result
+}
+
+function read (gl, pixelSize, options) {
+  const pixels = new Uint8Array(WIDTH * HEIGHT * pixelSize)
+  gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels, options)
+  return Array.from(pixels)
+}
+
+function luma (pixel) {
+  return (77 * pixel[0] + 150 * pixel[1] + 29 * pixel[2] + 128) >> 8
+}
+
+tape('readback options - flip and repack', function (t) {
+  const gl = createContext(WIDTH, HEIGHT)
+  draw(gl)
+
+  t.same(read(gl, 4, {}), rows(BOTTOM, TOP), 'empty options')
+  t.same(read(gl, 4, { packFlipY: true }), rows(TOP, BOTTOM), 'flipped')
+  t.same(read(gl, 3, { outputFormat: 'rgb' }), rows(BOTTOM.slice(0, 3), TOP.slice(0, 3)), 'rgb')
+  t.same(read(gl, 4, { outputFormat: 'bgra', packFlipY: true }),
+    rows([0, 30, 60, 128], [50, 100, 200, 255]), 'flipped bgra')
+  t.same(read(gl, 1, { outputFormat: 'gray' }), rows([luma(BOTTOM)], [luma(TOP)]), 'gray')
+  t.same(read(gl, 4, { unpremultiply: true }), rows(BOTTOM, [120, 60, 0, 128]), 'unpremultiplied')
+  t.same(read(gl, 3, { unpremultiply: true, outputFormat: 'rgb' }),
+    rows(BOTTOM.slice(0, 3), [120, 60, 0]), 'unpremultiplied rgb')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('readback options - validation', function (t) {
+  const gl = createContext(WIDTH, HEIGHT)
+
+  gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(WIDTH * HEIGHT * 3), { outputFormat: 'rgba' })
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short array')
+  gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGB, gl.UNSIGNED_BYTE, new Uint8Array(WIDTH * HEIGHT * 4), { packFlipY: true })
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'format other than RGBA')
+  t.throws(function () {
+    gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(WIDTH * HEIGHT * 4), { outputFormat: 'argb' })
+  }, TypeError, 'unknown output format')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('readback options - asynchronous readback', function (t) {
+  const gl = createContext(WIDTH, HEIGHT, { createWebGL2Context: true })
+  draw(gl)
+  gl.readPixelsAsync(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, null, { packFlipY: true, outputFormat: 'rgb' })
+    .then(function (pixels) {
+      t.same(Array.from(pixels), rows(TOP.slice(0, 3), BOTTOM.slice(0, 3)), 'flipped rgb')
+      t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+      gl.getExtension('STACKGL_destroy_context').destroy()
+      t.end()
+    })
+})
@@ -46,3 +46,132 @@ tape('resize', function (t) {
 
   t.end()
 })
+
+tape('resize - reuse drawing buffer', function (t) {
+  const gl = createContext(2, 2, { reuseDrawingBuffer: true })
+
+  // Growing allocates storage larger than the drawing buffer, shrinking keeps it
+  for (const [width, height] of [[4, 4], [2, 2], [3, 1]]) {
+    gl.resize(width, height)
+    t.equals(gl.drawingBufferWidth, width, 'width updated')
+    t.equals(gl.drawingBufferHeight, height, 'height updated')
+
+    gl.clearColor(1, 1, 1, 1)
+    gl.clear(gl.COLOR_BUFFER_BIT)
+
+    const pixels = new Uint8Array(6 * 6 * 4)
+    gl.readPixels(-1, -1, 6, 6, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+    let inside = 0
+    let outside = 0
+    for (let row = -1; row < 5; ++row) {
+      for (let col = -1; col < 5; ++col) {
+        const value = pixels[((row + 1) * 6 + col + 1) * 4]
+        if (row >= 0 && col >= 0 && row < height && col < width) {
+          inside += value === 255 ? 1 : 0
+        } else {
+          outside += value === 0 ? 1 : 0
+        }
+      }
+    }
+    t.equals(inside, width * height, 'in bounds pixels are cleared')
+    t.equals(outside, 36 - width * height, 'out of bounds pixels are zero')
+  }
+
+  gl.destroy()
+  t.end()
+})
+
+tape('resize - reused storage looks freshly allocated', function (t) {
+  const gl = createContext(4, 4, { reuseDrawingBuffer: true, stencil: true })
+
+  gl.clearColor(1, 0, 0, 1)
+  gl.clearDepth(0.5)
+  gl.colorMask(true, false, true, true)
+  gl.enable(gl.SCISSOR_TEST)
+  gl.scissor(0, 0, 1, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  gl.disable(gl.SCISSOR_TEST)
+  gl.clear(gl.COLOR_BUFFER_BIT | gl.DEPTH_BUFFER_BIT)
+
+  gl.resize(2, 2)
+  gl.resize(4, 3)
+  const pixels = new Uint8Array(4 * 3 * 4)
+  gl.readPixels(0, 0, 4, 3, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(Array.from(pixels), new Array(pixels.length).fill(0), 'contents cleared')
+
+  t.same(Array.from(gl.getParameter(gl.COLOR_CLEAR_VALUE)), [1, 0, 0, 1], 'clear color kept')
+  t.equals(gl.getParameter(gl.DEPTH_CLEAR_VALUE), 0.5, 'clear depth kept')
+  t.same(gl.getParameter(gl.COLOR_WRITEMASK), [true, false, true, true], 'color mask kept')
+  t.equals(gl.isEnabled(gl.SCISSOR_TEST), false, 'scissor test kept')
+
+  // Rows past the logical height are outside the drawing buffer, also when flipped
+  gl.colorMask(true, true, true, true)
+  gl.clearColor(0, 1, 0, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+  const rgb = new Uint8Array(2 * 4 * 3)
+  gl.readPixels(3, 0, 2, 4, gl.RGBA, gl.UNSIGNED_BYTE, rgb, { packFlipY: true, outputFormat: 'rgb' })
+  t.same(Array.from(rgb), [
+    0, 0, 0, 0, 0, 0,
+    0, 255, 0, 0, 0, 0,
+    0, 255, 0, 0, 0, 0,
+    0, 255, 0, 0, 0, 0
+  ], 'clipped to the logical size')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.destroy()
+  t.end()
+})
+
+tape('resize - copies stop at the reused drawing buffer', function (t) {
+  const gl = createContext(4, 4, { reuseDrawingBuffer: true, createWebGL2Context: true })
+  gl.resize(2, 2)
+
+  // Clears all of the 4x4 storage, not just the drawing buffer
+  gl.clearColor(1, 1, 1, 1)
+  gl.clear(gl.COLOR_BUFFER_BIT)
+
+  const framebuffer = gl.createFramebuffer()
+  function readTexture (texture) {
+    gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+    gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+    const pixels = new Uint8Array(4 * 4 * 4)
+    gl.readPixels(0, 0, 4, 4, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+    gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+    return Array.from(pixels.filter((value, i) => i % 4 === 0))
+  }
+
+  // Only the bottom left 2x2 pixels are inside the drawing buffer
+  const inside = [
+    255, 255, 0, 0,
+    255, 255, 0, 0,
+    0, 0, 0, 0,
+    0, 0, 0, 0
+  ]
+
+  const copied = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, copied)
+  gl.copyTexImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 0, 0, 4, 4, 0)
+  t.same(readTexture(copied), inside, 'copyTexImage2D zero fills')
+
+  const sub = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, sub)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.copyTexSubImage2D(gl.TEXTURE_2D, 0, 0, 0, 0, 0, 4, 4)
+  t.same(readTexture(sub), inside, 'copyTexSubImage2D leaves texels past the drawing buffer alone')
+
+  gl.copyTexSubImage2D(gl.TEXTURE_2D, 0, 2, 2, 0, 0, 4, 4)
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'copyTexSubImage2D still checks the full rectangle')
+
+  const blitted = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, blitted)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 4, 4, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  gl.bindFramebuffer(gl.DRAW_FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.DRAW_FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, blitted, 0)
+  gl.blitFramebuffer(0, 0, 4, 4, 0, 0, 4, 4, gl.COLOR_BUFFER_BIT, gl.NEAREST)
+  gl.bindFramebuffer(gl.DRAW_FRAMEBUFFER, null)
+  t.same(readTexture(blitted), inside, 'blitFramebuffer leaves pixels past the drawing buffer alone')
+
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+  gl.destroy()
+  t.end()
+})
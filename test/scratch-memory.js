@@ -0,0 +1,53 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function upload (gl, width, height) {
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, width, height, 0, gl.RGBA, gl.UNSIGNED_BYTE,
+    new Uint8Array(width * height * 4))
+}
+
+tape('scratch memory - steady state uploads reuse the buffer', function (t) {
+  const gl = createContext(1, 1)
+  const ext = gl.getExtension('STACKGL_scratch_memory')
+  t.ok(ext, 'extension available')
+
+  gl.bindTexture(gl.TEXTURE_2D, gl.createTexture())
+  upload(gl, 16, 16)
+  t.equals(ext.stats().capacity, 0, 'no conversion, no buffer')
+
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, true)
+  upload(gl, 16, 16)
+  upload(gl, 16, 16)
+  upload(gl, 8, 8)
+  const stats = ext.stats()
+  t.equals(stats.grows, 1, 'allocated once')
+  t.equals(stats.reuses, 2, 'reused afterwards')
+  t.equals(stats.highWater, 16 * 16 * 4, 'high water mark')
+  t.ok(stats.capacity >= 16 * 16 * 4, 'capacity covers the largest upload')
+
+  ext.setLimit(256)
+  t.equals(ext.stats().capacity, 0, 'lowering the limit frees the buffer')
+  upload(gl, 16, 16)
+  t.equals(ext.stats().oversized, 1, 'uploads over the limit are not retained')
+  t.equals(ext.stats().capacity, 0, 'still no buffer')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  t.throws(function () {
+    ext.setLimit(-1)
+  }, TypeError, 'negative limit throws')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('scratch memory - scratchLimit option', function (t) {
+  const gl = createContext(1, 1, { scratchLimit: 1024 })
+  t.equals(gl.getExtension('STACKGL_scratch_memory').stats().limit, 1024, 'limit applied')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.throws(function () {
+    createContext(1, 1, { scratchLimit: 'big' })
+  }, TypeError, 'invalid limit throws')
+  t.end()
+})
@@ -0,0 +1,109 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+const compileShader = require('./util/make-shader')
+
+const VERT_SRC = [
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'uniform vec4 color;',
+  'void main() {',
+  '  gl_FragColor = color + vec4(0.0, 0.0, 0.0, 0.125);',
+  '}'
+].join('\n')
+
+function drawWith (gl, program) {
+  gl.useProgram(program)
+  const buffer = gl.createBuffer()
+  gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array([-1, -1, 3, -1, -1, 3]), gl.STATIC_DRAW)
+  const location = gl.getAttribLocation(program, 'position')
+  gl.enableVertexAttribArray(location)
+  gl.vertexAttribPointer(location, 2, gl.FLOAT, false, 0, 0)
+  gl.uniform4f(gl.getUniformLocation(program, 'color'), 0, 1, 0, 0.875)
+  gl.drawArrays(gl.TRIANGLES, 0, 3)
+  const pixel = new Uint8Array(4)
+  gl.readPixels(0, 0, 1, 1, gl.RGBA, gl.UNSIGNED_BYTE, pixel)
+  return Array.from(pixel)
+}
+
+tape('shared programs - second context loads the binary', function (t) {
+  t.throws(function () {
+    createContext.setSharedProgramCacheSize(-1)
+  }, TypeError, 'negative size throws')
+
+  createContext.setSharedProgramCacheSize(8 * 1024 * 1024)
+  const before = createContext.getSharedProgramStats()
+
+  const first = createContext(2, 2, { createWebGL2Context: true })
+  const firstProgram = makeProgram(first, VERT_SRC, FRAG_SRC)
+  t.ok(first.getProgramParameter(firstProgram, first.LINK_STATUS), 'first context links')
+  const afterFirst = createContext.getSharedProgramStats()
+  t.ok(afterFirst.entries > before.entries || afterFirst.hits > before.hits, 'binary retained')
+
+  const second = createContext(2, 2, { createWebGL2Context: true })
+  const secondProgram = makeProgram(second, VERT_SRC, FRAG_SRC)
+  t.ok(second.getProgramParameter(secondProgram, second.LINK_STATUS), 'second context links')
+  const afterSecond = createContext.getSharedProgramStats()
+  t.ok(afterSecond.hits > afterFirst.hits, 'second link is a hit')
+  t.ok(afterSecond.bytes > 0, 'bytes retained')
+
+  t.same(drawWith(second, secondProgram), drawWith(first, firstProgram), 'programs render the same')
+  t.same(drawWith(second, secondProgram), [0, 255, 0, 255], 'expected color')
+
+  first.getExtension('STACKGL_destroy_context').destroy()
+  second.getExtension('STACKGL_destroy_context').destroy()
+
+  createContext.setSharedProgramCacheSize(0)
+  t.equals(createContext.getSharedProgramStats().entries, 0, 'disabling drops every entry')
+  t.end()
+})
+
+tape('shared programs - webgl1 contexts are left alone', function (t) {
+  createContext.setSharedProgramCacheSize(8 * 1024 * 1024)
+  const before = createContext.getSharedProgramStats()
+
+  const gl = createContext(2, 2)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  t.ok(gl.getProgramParameter(program, gl.LINK_STATUS), 'links')
+  const after = createContext.getSharedProgramStats()
+  t.equals(after.hits + after.misses, before.hits + before.misses, 'link is not counted')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  createContext.setSharedProgramCacheSize(0)
+  t.end()
+})
+
+tape('shared programs - bindings made before sharing was enabled count', function (t) {
+  const first = createContext(2, 2, { createWebGL2Context: true })
+  const bound = first.createProgram()
+  first.bindAttribLocation(bound, 3, 'position')
+
+  createContext.setSharedProgramCacheSize(8 * 1024 * 1024)
+  first.attachShader(bound, compileShader(first, first.VERTEX_SHADER, VERT_SRC))
+  first.attachShader(bound, compileShader(first, first.FRAGMENT_SHADER, FRAG_SRC))
+  first.linkProgram(bound)
+  t.ok(first.getProgramParameter(bound, first.LINK_STATUS), 'first context links')
+  t.equals(first.getAttribLocation(bound, 'position'), 3, 'binding applied')
+  const before = createContext.getSharedProgramStats()
+
+  const second = createContext(2, 2, { createWebGL2Context: true })
+  const unbound = makeProgram(second, VERT_SRC, FRAG_SRC)
+  t.ok(second.getProgramParameter(unbound, second.LINK_STATUS), 'second context links')
+  t.equals(createContext.getSharedProgramStats().hits, before.hits, 'binary not reused')
+  t.equals(second.getAttribLocation(unbound, 'position'), 0, 'binding not inherited')
+
+  first.getExtension('STACKGL_destroy_context').destroy()
+  second.getExtension('STACKGL_destroy_context').destroy()
+  createContext.setSharedProgramCacheSize(0)
+  t.end()
+})
@@ -0,0 +1,107 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+function delta (ext, fn) {
+  const before = ext.stats()
+  fn()
+  const after = ext.stats()
+  return { hits: after.hits - before.hits, misses: after.misses - before.misses }
+}
+
+tape('state cache - redundant calls are dropped', function (t) {
+  const gl = createContext(16, 16)
+  const ext = gl.getExtension('STACKGL_state_cache')
+  t.ok(ext, 'extension available')
+
+  const texture = gl.createTexture()
+  const buffer = gl.createBuffer()
+  const counts = delta(ext, function () {
+    for (let i = 0; i < 2; ++i) {
+      gl.activeTexture(gl.TEXTURE1)
+      gl.bindTexture(gl.TEXTURE_2D, texture)
+      gl.bindBuffer(gl.ARRAY_BUFFER, buffer)
+      gl.enable(gl.DEPTH_TEST)
+      gl.blendFunc(gl.SRC_ALPHA, gl.ONE_MINUS_SRC_ALPHA)
+      gl.depthFunc(gl.LEQUAL)
+      gl.viewport(0, 0, 8, 8)
+      gl.scissor(0, 0, 4, 4)
+    }
+  })
+  t.same(counts, { hits: 8, misses: 8 }, 'second round hits the cache')
+
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), texture, 'texture bound')
+  t.equals(gl.isEnabled(gl.DEPTH_TEST), true, 'DEPTH_TEST enabled')
+  t.equals(gl.getParameter(gl.DEPTH_FUNC), gl.LEQUAL, 'DEPTH_FUNC set')
+  t.same(Array.from(gl.getParameter(gl.VIEWPORT)), [0, 0, 8, 8], 'VIEWPORT set')
+  t.same(Array.from(gl.getParameter(gl.SCISSOR_BOX)), [0, 0, 4, 4], 'SCISSOR_BOX set')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('state cache - errors are raised every time', function (t) {
+  const gl = createContext(16, 16)
+  gl.getError()
+
+  for (let i = 0; i < 2; ++i) {
+    gl.viewport(0, 0, -1, 4)
+    t.equals(gl.getError(), gl.INVALID_VALUE, 'negative viewport size')
+    gl.enable(0x1234)
+    t.equals(gl.getError(), gl.INVALID_ENUM, 'unknown capability')
+  }
+
+  const program = gl.createProgram()
+  for (let i = 0; i < 2; ++i) {
+    gl.useProgram(program)
+    t.equals(gl.getError(), gl.INVALID_OPERATION, 'unlinked program')
+  }
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('state cache - deleted objects and reused names', function (t) {
+  const gl = createContext(16, 16)
+
+  const first = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, first)
+  gl.deleteTexture(first)
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), null, 'delete unbinds')
+
+  const second = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, second)
+  t.equals(gl.getParameter(gl.TEXTURE_BINDING_2D), second, 'new texture bound')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('state cache - context switches and pooling', function (t) {
+  const a = createContext(16, 16)
+  const b = createContext(16, 16)
+
+  a.enable(a.BLEND)
+  b.disable(b.BLEND)
+  a.enable(a.BLEND)
+  t.equals(a.isEnabled(a.BLEND), true, 'first context keeps its state')
+  t.equals(b.isEnabled(b.BLEND), false, 'second context keeps its state')
+
+  a.getExtension('STACKGL_destroy_context').destroy()
+  b.getExtension('STACKGL_destroy_context').destroy()
+
+  const pool = createContext.createContextPool()
+  const gl = pool.acquire(16, 16)
+  gl.enable(gl.CULL_FACE)
+  pool.release(gl)
+
+  const again = pool.acquire(16, 16)
+  const counts = delta(again.getExtension('STACKGL_state_cache'), function () {
+    again.enable(again.CULL_FACE)
+  })
+  t.same(counts, { hits: 0, misses: 1 }, 'reset drops the shadow')
+  t.equals(again.isEnabled(again.CULL_FACE), true, 'enable after reset reaches GL')
+  pool.destroy()
+  t.end()
+})
@@ -0,0 +1,143 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+const WIDTH = 64
+const HEIGHT = 32
+
+function frame (seed) {
+  const pixels = new Uint8Array(WIDTH * HEIGHT * 4)
+  for (let i = 0; i < pixels.length; ++i) {
+    pixels[i] = (i * 7 + seed) & 0xff
+  }
+  return pixels
+}
+
+function readTexture (gl, texture) {
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  const result = new Uint8Array(WIDTH * HEIGHT * 4)
+  gl.readPixels(0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, result)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  gl.deleteFramebuffer(framebuffer)
+  return result
+}
+
+function createTexture (gl) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, WIDTH, HEIGHT, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  return texture
+}
+
+tape('texSubImage2DAsync - uploads in order on WebGL 2', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const texture = createTexture(gl)
+
+  // More uploads than staging buffers, so the ring has to wrap around
+  const frames = [1, 2, 3, 4, 5].map(frame)
+  const uploads = frames.map(pixels =>
+    gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels))
+
+  // Binding another texture must not redirect the pending uploads
+  gl.bindTexture(gl.TEXTURE_2D, createTexture(gl))
+
+  Promise.all(uploads).then(function () {
+    t.same(readTexture(gl, texture), frames[frames.length - 1], 'last upload wins')
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - flips while staging', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const texture = createTexture(gl)
+  const pixels = frame(9)
+
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, true)
+  const upload = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, false)
+
+  upload.then(function () {
+    const result = readTexture(gl, texture)
+    const rowBytes = WIDTH * 4
+    t.same(result.subarray(0, rowBytes), pixels.subarray(pixels.length - rowBytes), 'first row is the last source row')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - WebGL 1 uploads synchronously', function (t) {
+  const gl = createContext(1, 1)
+  const texture = createTexture(gl)
+  const pixels = frame(3)
+  const upload = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(readTexture(gl, texture), pixels, 'uploaded before resolving')
+  upload.then(function () {
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - destroying the context settles pending uploads', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  createTexture(gl)
+  const upload = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, frame(0))
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  upload.then(function () {
+    t.pass('resolved')
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - later calls see the upload', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const texture = createTexture(gl)
+  const pixels = frame(5)
+  const upload = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.same(readTexture(gl, texture), pixels, 'read before the promise resolves')
+  upload.then(function () {
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - invalid uploads fail synchronously and reject', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const texture = createTexture(gl)
+  const pixels = frame(6)
+
+  const outside = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 1, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels)
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'region past the texture raises INVALID_VALUE')
+
+  const short = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, pixels.subarray(4))
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'short source raises INVALID_OPERATION')
+
+  const results = [outside, short].map(upload => upload.then(() => 'resolved', () => 'rejected'))
+  Promise.all(results).then(function (settled) {
+    t.same(settled, ['rejected', 'rejected'], 'both promises reject')
+    t.same(readTexture(gl, texture), new Uint8Array(WIDTH * HEIGHT * 4), 'texture is untouched')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
+
+tape('texSubImage2DAsync - deleting the texture drops its pending uploads', function (t) {
+  const gl = createContext(1, 1, { createWebGL2Context: true })
+  const deleted = createTexture(gl)
+  const upload = gl.texSubImage2DAsync(gl.TEXTURE_2D, 0, 0, 0, WIDTH, HEIGHT, gl.RGBA, gl.UNSIGNED_BYTE, frame(8))
+  gl.deleteTexture(deleted)
+
+  // The new texture may get the name of the deleted one
+  const texture = createTexture(gl)
+  upload.then(function () {
+    t.same(readTexture(gl, texture), new Uint8Array(WIDTH * HEIGHT * 4), 'new texture is untouched')
+    t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+    gl.getExtension('STACKGL_destroy_context').destroy()
+    t.end()
+  })
+})
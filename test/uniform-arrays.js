@@ -0,0 +1,53 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+
+const VERT_SRC = [
+  'precision mediump float;',
+  'attribute vec2 position;',
+  'void main() {',
+  '  gl_Position = vec4(position, 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'uniform vec4 palette[8];',
+  'uniform ivec2 offsets[4];',
+  'void main() {',
+  '  vec4 sum = vec4(0);',
+  '  for (int i = 0; i < 8; ++i) sum += palette[i];',
+  '  for (int i = 0; i < 4; ++i) sum.xy += vec2(offsets[i]);',
+  '  gl_FragColor = sum;',
+  '}'
+].join('\n')
+
+tape('uniform arrays - uploaded in one call', function (t) {
+  const gl = createContext(4, 4)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  gl.useProgram(program)
+
+  const palette = new Float32Array(8 * 4)
+  for (let i = 0; i < palette.length; ++i) {
+    palette[i] = i / 4
+  }
+  gl.uniform4fv(gl.getUniformLocation(program, 'palette[0]'), palette)
+  gl.uniform2iv(gl.getUniformLocation(program, 'offsets[0]'), [1, 2, 3, 4, 5, 6, 7, 8])
+  t.equals(gl.getError(), gl.NO_ERROR, 'no error')
+
+  for (let i = 0; i < 8; ++i) {
+    const value = gl.getUniform(program, gl.getUniformLocation(program, `palette[${i}]`))
+    t.same(Array.from(value), Array.from(palette.subarray(4 * i, 4 * i + 4)), `palette[${i}]`)
+  }
+  const last = gl.getUniform(program, gl.getUniformLocation(program, 'offsets[3]'))
+  t.same(Array.from(last), [7, 8], 'offsets[3]')
+
+  gl.uniform4fv(gl.getUniformLocation(program, 'palette[0]'), new Float32Array(12 * 4))
+  t.equals(gl.getError(), gl.NO_ERROR, 'extra elements are ignored')
+  t.same(Array.from(gl.getUniform(program, gl.getUniformLocation(program, 'palette[7]'))), [0, 0, 0, 0], 'palette[7] overwritten')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
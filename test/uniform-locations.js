@@ -0,0 +1,90 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+const makeProgram = require('./util/make-program')
+
+const VERT_SRC = [
+  'attribute vec2 position;',
+  'uniform float scale;',
+  'uniform vec2 offsets[4];',
+  'void main() {',
+  '  gl_Position = vec4(position * scale + offsets[0] + offsets[1] + offsets[2] + offsets[3], 0, 1);',
+  '}'
+].join('\n')
+
+const FRAG_SRC = [
+  'precision mediump float;',
+  'void main() {',
+  '  gl_FragColor = vec4(1);',
+  '}'
+].join('\n')
+
+tape('uniform locations - lookups', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  gl.useProgram(program)
+
+  t.ok(gl.getUniformLocation(program, 'scale'), 'scalar uniform')
+  t.equals(gl.getUniformLocation(program, 'missing'), null, 'unknown name')
+  t.equals(gl.getUniformLocation(program, 'offsets[4]'), null, 'element past the end')
+
+  const first = gl.getUniformLocation(program, 'offsets[0]')
+  const bare = gl.getUniformLocation(program, 'offsets')
+  t.ok(first && bare, 'array by first element and by name')
+  t.notEqual(first, gl.getUniformLocation(program, 'offsets[0]'), 'every call returns a new location')
+
+  gl.uniform2fv(bare, [1, 2, 3, 4, 5, 6, 7, 8])
+  for (let i = 0; i < 4; ++i) {
+    const element = gl.getUniformLocation(program, 'offsets[' + i + ']')
+    t.same(Array.from(gl.getUniform(program, element)), [2 * i + 1, 2 * i + 2], 'element ' + i)
+  }
+
+  gl.getUniformLocation(program, 'bad$name')
+  t.equals(gl.getError(), gl.INVALID_VALUE, 'invalid names are still rejected')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no other errors')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('uniform locations - relinking invalidates old locations', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  gl.useProgram(program)
+
+  const before = gl.getUniformLocation(program, 'scale')
+  gl.linkProgram(program)
+  gl.uniform1f(before, 2)
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'stale location rejected')
+  const after = gl.getUniformLocation(program, 'scale')
+  gl.uniform1f(after, 2)
+  t.equals(gl.getError(), gl.NO_ERROR, 'new location accepted')
+  t.equals(gl.getUniform(program, after), 2, 'value set')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('uniform locations - failed relink', function (t) {
+  const gl = createContext(1, 1)
+  const program = makeProgram(gl, VERT_SRC, FRAG_SRC)
+  t.ok(gl.getUniformLocation(program, 'scale'), 'location before relink')
+
+  const broken = gl.createShader(gl.VERTEX_SHADER)
+  gl.shaderSource(broken, 'void main() { gl_Position = undefined; }')
+  gl.compileShader(broken)
+  const vertex = gl.getAttachedShaders(program).find(shader =>
+    gl.getShaderParameter(shader, gl.SHADER_TYPE) === gl.VERTEX_SHADER)
+  gl.detachShader(program, vertex)
+  gl.attachShader(program, broken)
+  gl.linkProgram(program)
+  t.equals(gl.getProgramParameter(program, gl.LINK_STATUS), false, 'relink failed')
+  gl.getError()
+
+  t.equals(gl.getUniformLocation(program, 'scale'), null, 'no location after a failed relink')
+  t.equals(gl.getError(), gl.INVALID_OPERATION, 'INVALID_OPERATION raised')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
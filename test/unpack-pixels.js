@@ -0,0 +1,55 @@
+'use strict'
+
+const tape = require('tape')
+const createContext = require('../index')
+
+// Two rows of three RGBA pixels, bottom row first.
+const PIXELS = [
+  255, 0, 0, 255, 0, 255, 0, 128, 0, 0, 255, 0,
+  200, 100, 50, 51, 255, 255, 255, 255, 10, 20, 30, 1
+]
+
+function upload (gl, flipY, premultiply) {
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, flipY)
+  gl.pixelStorei(gl.UNPACK_PREMULTIPLY_ALPHA_WEBGL, premultiply)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 3, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(PIXELS))
+
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  const result = new Uint8Array(PIXELS.length)
+  gl.readPixels(0, 0, 3, 2, gl.RGBA, gl.UNSIGNED_BYTE, result)
+  gl.bindFramebuffer(gl.FRAMEBUFFER, null)
+  return Array.from(result)
+}
+
+tape('unpack pixels - flip and premultiply', function (t) {
+  const gl = createContext(1, 1)
+
+  t.same(upload(gl, false, false), PIXELS, 'unchanged')
+  t.same(upload(gl, true, false), PIXELS.slice(12).concat(PIXELS.slice(0, 12)), 'flipped')
+
+  const premultiplied = [
+    255, 0, 0, 255, 0, 128, 0, 128, 0, 0, 0, 0,
+    40, 20, 10, 51, 255, 255, 255, 255, 0, 0, 0, 1
+  ]
+  t.same(upload(gl, false, true), premultiplied, 'premultiplied and rounded')
+  t.same(upload(gl, true, true), premultiplied.slice(12).concat(premultiplied.slice(0, 12)),
+    'flipped and premultiplied')
+  t.equals(gl.getError(), gl.NO_ERROR, 'no errors')
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
+
+tape('unpack pixels - short arrays are rejected', function (t) {
+  const gl = createContext(1, 1)
+  gl.bindTexture(gl.TEXTURE_2D, gl.createTexture())
+  gl.pixelStorei(gl.UNPACK_FLIP_Y_WEBGL, true)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 3, 2, 0, gl.RGBA, gl.UNSIGNED_BYTE, new Uint8Array(8))
+  t.notEqual(gl.getError(), gl.NO_ERROR, 'error raised')
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})
@@ -10,3 +10,41 @@ tape('use WebGLRenderingContext', function (t) {
   t.equals(!!WebGLRenderingContext.FRAMEBUFFER, true)
   t.end()
 })
+
+tape('use WebGL2RenderingContext', function (t) {
+  const createContext = require('../index')
+  const WebGL2RenderingContext = createContext.WebGL2RenderingContext
+  t.equals(WebGL2RenderingContext.TEXTURE_2D_ARRAY, 0x8C1A)
+  t.equals(WebGL2RenderingContext.RGBA8, 0x8058)
+  t.equals(WebGL2RenderingContext.STATIC_DRAW, WebGLRenderingContext.STATIC_DRAW)
+  t.equals(WebGLRenderingContext.TEXTURE_2D_ARRAY, undefined)
+
+  const gl = createContext(1, 1)
+  t.equals(gl.TEXTURE_2D_ARRAY, undefined, 'no WebGL2 enums on WebGL1 contexts')
+  const gl2 = createContext(1, 1, { createWebGL2Context: true })
+  t.equals(gl2.TEXTURE_2D_ARRAY, 0x8C1A, 'WebGL2 enums on WebGL2 contexts')
+  t.equals(gl2.MAX_CLIENT_WAIT_TIMEOUT_WEBGL, 0x9247)
+  t.end()
+})
+
+tape('errors raised around checked native calls are all kept', function (t) {
+  const createContext = require('../index')
+  const gl = createContext(1, 1)
+  const texture = gl.createTexture()
+  gl.bindTexture(gl.TEXTURE_2D, texture)
+  gl.texImage2D(gl.TEXTURE_2D, 0, gl.RGBA, 1, 1, 0, gl.RGBA, gl.UNSIGNED_BYTE, null)
+  const framebuffer = gl.createFramebuffer()
+  gl.bindFramebuffer(gl.FRAMEBUFFER, framebuffer)
+  gl.framebufferTexture2D(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, gl.TEXTURE_2D, texture, 0)
+  t.equals(gl.getError(), gl.NO_ERROR)
+
+  // INVALID_VALUE is left pending in the driver, then the query raises INVALID_ENUM
+  gl.viewport(0, 0, -1, -1)
+  t.equals(gl.getFramebufferAttachmentParameter(gl.FRAMEBUFFER, gl.COLOR_ATTACHMENT0, 0xdead), null)
+  t.equals(gl.getError(), gl.INVALID_ENUM)
+  t.equals(gl.getError(), gl.INVALID_VALUE)
+  t.equals(gl.getError(), gl.NO_ERROR)
+
+  gl.getExtension('STACKGL_destroy_context').destroy()
+  t.end()
+})